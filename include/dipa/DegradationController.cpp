@@ -0,0 +1,193 @@
+/*
+ * DegradationController.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/DegradationController.h>
+
+DegradationController::DegradationController() {
+	level = NOMINAL;
+
+	setParameters(DipaParameters());
+
+	for(int i = 0; i < NUM_STAGES; i++)
+	{
+		stage_cost[i] = 0;
+		stage_cost_set[i] = false;
+		frame_stage_latency[i] = 0;
+		frame_stage_ran[i] = false;
+	}
+
+	overhead_cost = 0;
+	overhead_cost_set = false;
+
+	frame_latency = 0;
+	frames_under_budget = 0;
+
+	seq_set = false;
+	last_seq = 0;
+	dropped_frames = 0;
+	processed_frames = 0;
+}
+
+DegradationController::~DegradationController() {
+
+}
+
+void DegradationController::setParameters(const DipaParameters& p)
+{
+	budget = p.frame_time_budget;
+	max_iterations = p.max_iterations;
+	num_features = p.num_features;
+	degraded_max_iterations = p.degraded_max_iterations;
+	degraded_num_features = p.degraded_num_features;
+}
+
+void DegradationController::beginFrame(uint32_t seq)
+{
+	frame_start = ros::WallTime::now();
+
+	for(int i = 0; i < NUM_STAGES; i++)
+	{
+		frame_stage_latency[i] = 0;
+		frame_stage_ran[i] = false;
+	}
+
+	// any gap in the sequence means the subscriber queue dropped frames
+	if(seq_set && seq > last_seq + 1)
+	{
+		dropped_frames += seq - last_seq - 1;
+		ROS_DEBUG_STREAM("dropped " << seq - last_seq - 1 << " frames before they were processed");
+	}
+
+	seq_set = true;
+	last_seq = seq;
+	processed_frames++;
+}
+
+void DegradationController::recordStage(Stage stage, double seconds)
+{
+	frame_stage_latency[stage] += seconds;
+	frame_stage_ran[stage] = true;
+}
+
+void DegradationController::endFrame()
+{
+	frame_latency = (ros::WallTime::now() - frame_start).toSec();
+
+	// update the nominal cost of each stage which ran this frame
+	double staged = 0;
+	for(int i = 0; i < NUM_STAGES; i++)
+	{
+		if(!frame_stage_ran[i])
+		{
+			continue;
+		}
+
+		staged += frame_stage_latency[i];
+
+		double scale = stageScale((Stage)i, level);
+		if(scale > 0)
+		{
+			smooth(stage_cost[i], stage_cost_set[i], frame_stage_latency[i] / scale);
+		}
+	}
+
+	smooth(overhead_cost, overhead_cost_set, std::max(0.0, frame_latency - staged));
+
+	// find the least degraded level which is predicted to fit the budget
+	int target = NUM_LEVELS - 1;
+	for(int l = NOMINAL; l < NUM_LEVELS; l++)
+	{
+		if(predictCost(l) <= budget)
+		{
+			target = l;
+			break;
+		}
+	}
+
+	// the model is smoothed so escalate immediately if this frame blew the budget anyway
+	if(frame_latency > budget && target <= level)
+	{
+		target = std::min(level + 1, (int)NUM_LEVELS - 1);
+	}
+
+	if(target > level)
+	{
+		ROS_WARN_STREAM("frame took " << frame_latency << "s of a " << budget << "s budget. degrading from level " << level << " to " << target);
+		level = target;
+		frames_under_budget = 0;
+	}
+	else if(level > NOMINAL && frame_latency <= budget && predictCost(level - 1) <= DEGRADATION_RELAX_MARGIN * budget)
+	{
+		// relax one level at a time and only after the budget has been met for a while
+		frames_under_budget++;
+		if(frames_under_budget >= DEGRADATION_RELAX_FRAMES)
+		{
+			level--;
+			frames_under_budget = 0;
+			ROS_INFO_STREAM("cpu load has dropped. relaxing to degradation level " << level);
+		}
+	}
+	else
+	{
+		frames_under_budget = 0;
+	}
+}
+
+cv::Rect DegradationController::detectionROI(cv::Size sz)
+{
+	int w = sz.width * DEGRADED_DETECTION_ROI;
+	int h = sz.height * DEGRADED_DETECTION_ROI;
+
+	return cv::Rect((sz.width - w) / 2, (sz.height - h) / 2, w, h);
+}
+
+double DegradationController::predictCost(int lvl)
+{
+	double cost = overhead_cost;
+
+	for(int i = 0; i < NUM_STAGES; i++)
+	{
+		cost += stage_cost[i] * stageScale((Stage)i, lvl);
+	}
+
+	return cost;
+}
+
+/*
+ * fraction of the nominal cost that a stage uses at a given level
+ */
+double DegradationController::stageScale(Stage stage, int lvl)
+{
+	switch(stage)
+	{
+	case STAGE_VO:
+		return (lvl >= REDUCE_FEATURES) ? (double)degraded_num_features / (double)num_features : 1.0;
+	case STAGE_DETECTION:
+		if(lvl >= SKIP_GRID_ALIGNMENT){return 0.0;}
+		return (lvl >= ROI_DETECTION) ? DEGRADED_DETECTION_ROI * DEGRADED_DETECTION_ROI : 1.0;
+	case STAGE_ICP:
+		if(lvl >= SKIP_GRID_ALIGNMENT){return 0.0;}
+		return (lvl >= REDUCE_ICP_ITERATIONS) ? (double)degraded_max_iterations / (double)max_iterations : 1.0;
+	case STAGE_INSIGHT:
+		return (lvl >= SKIP_INSIGHT) ? 0.0 : 1.0;
+	default:
+		return 1.0;
+	}
+}
+
+void DegradationController::smooth(double& est, bool& set, double measurement)
+{
+	if(!set)
+	{
+		est = measurement;
+		set = true;
+	}
+	else
+	{
+		est = (1.0 - LATENCY_SMOOTHING) * est + LATENCY_SMOOTHING * measurement;
+	}
+}
@@ -0,0 +1,133 @@
+/*
+ * DegradationController.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_DEGRADATIONCONTROLLER_H_
+#define DIPA_INCLUDE_DIPA_DEGRADATIONCONTROLLER_H_
+
+#include <ros/ros.h>
+
+#include <algorithm>
+
+#include "opencv2/core/core.hpp"
+
+#include <dipa/DipaParams.h>
+#include <dipa/DipaParameters.h>
+
+/*
+ * keeps the per frame processing time within the frame time budget by stepping through a ladder of
+ * increasingly aggressive shortcuts. each level includes all of the levels below it.
+ *
+ * the level is chosen from smoothed per stage latencies which are normalized back to their
+ * nominal (undegraded) cost so the model can predict the cost of any level.
+ */
+class DegradationController {
+public:
+
+	enum Level{
+		NOMINAL = 0,
+		SKIP_INSIGHT,
+		REDUCE_ICP_ITERATIONS,
+		ROI_DETECTION,
+		REDUCE_FEATURES,
+		SKIP_GRID_ALIGNMENT,
+		NUM_LEVELS
+	};
+
+	enum Stage{
+		STAGE_VO = 0,
+		STAGE_DETECTION,
+		STAGE_ICP,
+		STAGE_INSIGHT,
+		NUM_STAGES
+	};
+
+	DegradationController();
+	virtual ~DegradationController();
+
+	/*
+	 * takes the budget and the nominal and degraded settings
+	 */
+	void setParameters(const DipaParameters& p);
+
+	/*
+	 * call when a frame enters the pipeline. uses the image sequence number to count frames
+	 * which were dropped before they reached us
+	 */
+	void beginFrame(uint32_t seq);
+
+	/*
+	 * adds the measured wall time of a stage to the current frame
+	 */
+	void recordStage(Stage stage, double seconds);
+
+	/*
+	 * closes the frame, updates the latency model and selects the level for the next frame
+	 */
+	void endFrame();
+
+	int getLevel(){return level;}
+
+	bool skipInsight(){return level >= SKIP_INSIGHT;}
+	bool roiDetection(){return level >= ROI_DETECTION;}
+	bool skipGridAlignment(){return level >= SKIP_GRID_ALIGNMENT;}
+
+	int maxIterations(){return (level >= REDUCE_ICP_ITERATIONS) ? degraded_max_iterations : max_iterations;}
+	int numFeatures(){return (level >= REDUCE_FEATURES) ? degraded_num_features : num_features;}
+
+	/*
+	 * the roi used for line detection when roiDetection() is set
+	 */
+	cv::Rect detectionROI(cv::Size sz);
+
+	double predictCost(int lvl);
+
+	uint32_t getDroppedFrames(){return dropped_frames;}
+	uint32_t getProcessedFrames(){return processed_frames;}
+
+	double getFrameLatency(){return frame_latency;}
+	double getStageLatency(Stage stage){return frame_stage_latency[stage];}
+
+	double getBudget(){return budget;}
+
+private:
+
+	int level;
+
+	double budget;
+	int max_iterations;
+	int num_features;
+	int degraded_max_iterations;
+	int degraded_num_features;
+
+	// smoothed nominal cost of each stage
+	double stage_cost[NUM_STAGES];
+	bool stage_cost_set[NUM_STAGES];
+
+	// smoothed cost of everything which is not a tracked stage (conversion, resize, tf lookups)
+	double overhead_cost;
+	bool overhead_cost_set;
+
+	// raw measurements of the current frame
+	double frame_stage_latency[NUM_STAGES];
+	bool frame_stage_ran[NUM_STAGES];
+	double frame_latency;
+
+	ros::WallTime frame_start;
+
+	int frames_under_budget;
+
+	bool seq_set;
+	uint32_t last_seq;
+	uint32_t dropped_frames;
+	uint32_t processed_frames;
+
+	double stageScale(Stage stage, int lvl);
+
+	void smooth(double& est, bool& set, double measurement);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_DEGRADATIONCONTROLLER_H_ */
@@ -9,20 +9,50 @@
 
 Dipa::Dipa(tf::Transform initial_world_to_base_transform, bool debug) {
 	ros::NodeHandle nh;
+	ros::NodeHandle pnh("~");
+
+	this->offline = false;
+
+#if LINE_DETECTOR == LINE_DETECTOR_LSD
+	this->line_detector.reset(new LSDLineDetector);
+#elif LINE_DETECTOR == LINE_DETECTOR_EDLINES
+	this->line_detector.reset(new EDLineDetector);
+#elif LINE_DETECTOR == LINE_DETECTOR_PRIOR_HOUGH
+	this->line_detector.reset(new PriorHoughLineDetector);
+#else
+	this->line_detector.reset(new HoughLineDetector);
+#endif
+
+	this->params.load(pnh);
+	if(!this->params.valid())
+	{
+		ROS_WARN("THE PARAMETER PROFILE IS INVALID. USING THE DEFAULTS");
+		this->params = DipaParameters();
+	}
+	this->applyParameters(this->params);
 
 	image_transport::ImageTransport it(nh);
-	//TODO make a camera sub when I have a properly recorded dataset
-	image_transport::CameraSubscriber bottom_cam_sub = it.subscribeCamera(BOTTOM_CAMERA_TOPIC, 2, &Dipa::bottomCamCb, this);
+	//only the newest frame is kept so a queue of one is enough
+	this->bottom_cam_sub = it.subscribeCamera(BOTTOM_CAMERA_TOPIC, 1, &Dipa::bottomCamCb, this);
 
 
 	//setup realignment sub
 	this->pose_realignment_sub = nh.subscribe<geometry_msgs::PoseWithCovarianceStamped>(REALIGNMENT_TOPIC, 2, &Dipa::realignmentCb, this);
-	this->time_at_last_realignment = ros::Time(0);
+
+#if USE_IMU
+	this->imu_sub = nh.subscribe<sensor_msgs::Imu>(IMU_TOPIC, 10, &Dipa::imuCb, this);
+#endif
 
 	this->odom_pub = nh.advertise<nav_msgs::Odometry>(ODOM_TOPIC, 1);
 
+	this->status_pub = nh.advertise<dipa::DipaStatus>(STATUS_TOPIC, 1);
+
+	this->prediction_pub = nh.advertise<dipa::PosePrediction>(PREDICTION_TOPIC, 1);
+
+	this->reload_parameters_srv = pnh.advertiseService("reload_parameters", &Dipa::reloadParametersCb, this);
+
 #if PUBLISH_INSIGHT
-	this->insight_pub = nh.advertise<sensor_msgs::Image>(INSIGHT_TOPIC, 1);
+	this->insight.start(nh);
 #endif
 
 	tf::StampedTransform b2c;
@@ -43,6 +73,59 @@ Dipa::Dipa(tf::Transform initial_world_to_base_transform, bool debug) {
 		return;
 	}
 
+	this->initialize(initial_world_to_base_transform, b2c);
+
+	// served by the async spinner so predictions keep coming while a frame is processed
+	if(PREDICTION_RATE > 0)
+	{
+		this->prediction_timer = nh.createTimer(ros::Duration(1.0 / PREDICTION_RATE), &Dipa::predictionTimerCb, this);
+	}
+
+	if(!debug)
+	{
+		this->run(); // go into the main loop;
+	}
+
+}
+
+/*
+ * processes frames handed to processFrame without ros communication. the camera is mounted at b2c
+ * and nothing is published
+ */
+Dipa::Dipa(tf::Transform initial_world_to_base_transform, tf::Transform b2c, const DipaParameters& p) {
+	this->offline = true;
+
+#if LINE_DETECTOR == LINE_DETECTOR_LSD
+	this->line_detector.reset(new LSDLineDetector);
+#elif LINE_DETECTOR == LINE_DETECTOR_EDLINES
+	this->line_detector.reset(new EDLineDetector);
+#elif LINE_DETECTOR == LINE_DETECTOR_PRIOR_HOUGH
+	this->line_detector.reset(new PriorHoughLineDetector);
+#else
+	this->line_detector.reset(new HoughLineDetector);
+#endif
+
+	this->applyParameters(p);
+
+	// processFrame looks the camera up in tf so it is given to the listener directly
+	this->tf_listener.setTransform(tf::StampedTransform(b2c, ros::Time(0), BASE_FRAME, CAMERA_FRAME), "offline");
+
+	this->initialize(initial_world_to_base_transform, b2c);
+}
+
+Dipa::~Dipa() {
+
+}
+
+void Dipa::initialize(tf::Transform initial_world_to_base_transform, tf::Transform b2c)
+{
+	this->time_at_last_realignment = ros::Time(0);
+	this->time_at_last_grid_alignment = ros::Time(0);
+
+	this->max_icp_iterations = this->params.max_iterations;
+
+	this->last_frame_grid_aligned = false;
+
 	TRACKING_LOST = false; //we have a good initial guess
 
 	vo_initialized = false; // we must init vo before losing tracking set
@@ -53,55 +136,363 @@ Dipa::Dipa(tf::Transform initial_world_to_base_transform, bool debug) {
 
 	//initialize vo with the guess
 	//TODO transform to the camera
-	this->vo.updatePose(initial_world_to_base_transform * b2c, ros::Time(0));
+	this->vo->updatePose(initial_world_to_base_transform * b2c, ros::Time(0));
 
-	if(!debug)
+#if USE_SLIDING_WINDOW
+	this->frames_since_window_post = 0;
+	this->window_last_post = ros::Time(0);
+	this->window_corrected_through = ros::Time(0);
+	this->window_optimizer.start();
+#endif
+
+	this->processing = false;
+
+	this->image_scale = 0; // set by the first frame
+	this->pixel_scale = 1;
+
+	this->line_motion_known = false;
+}
+
+/*
+ * the inverse scale the next frame is processed at
+ */
+double Dipa::selectImageScale(const sensor_msgs::CameraInfoConstPtr& cam)
+{
+	if(!this->params.resolution_control)
 	{
-		ros::spin(); // go into the main loop;
+		return this->params.inverse_image_scale;
 	}
 
+	// the grid spacing on the full resolution image when looking straight down from the current height
+	double altitude = this->state.getCurrentBestPose().getOrigin().z();
+	double grid_spacing_px = (altitude > 0) ? cam->K.at(0) * this->params.grid_spacing / altitude : std::numeric_limits<double>::infinity();
+
+	return this->resolution.update(this->deadline.predictCost(DegradationController::NOMINAL), this->deadline.getBudget(), grid_spacing_px);
 }
 
-Dipa::~Dipa() {
+/*
+ * serves the callbacks on an async spinner while a dedicated thread processes the newest frame
+ */
+void Dipa::run()
+{
+	ros::AsyncSpinner spinner(CALLBACK_THREADS);
+	spinner.start();
+
+	this->processing = true;
+	std::thread processor(&Dipa::processingLoop, this);
+
+	ros::waitForShutdown();
+
+	this->processing = false;
+	processor.join();
+
+	spinner.stop();
+}
+
+void Dipa::processingLoop()
+{
+	while(this->processing && ros::ok())
+	{
+		std::unique_ptr<CameraFrame> frame = this->frame_mailbox.waitAndTake(0.1);
+
+		// parameters are swapped between frames so no stage sees a mix of two profiles
+		std::unique_ptr<DipaParameters> p = this->parameter_mailbox.take();
+		if(p)
+		{
+			this->applyParameters(*p);
+		}
+
+		// realignments are applied between frames so the callback never waits on image processing
+		std::unique_ptr<Realignment> realignment = this->realignment_mailbox.take();
+		if(realignment)
+		{
+			this->applyRealignment(*realignment);
+		}
+
+		// the mailboxes are drained even when the camera stalls
+		if(!frame)
+		{
+			continue;
+		}
+
+#if USE_SLIDING_WINDOW
+		this->applyWindowCorrection();
+#endif
+
+		this->processFrame(frame->img, frame->cam);
+	}
+}
+
+bool Dipa::reloadParametersCb(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res)
+{
+	std::unique_ptr<DipaParameters> p(new DipaParameters);
+	p->load(ros::NodeHandle("~"));
+
+	if(!p->valid())
+	{
+		res.success = false;
+		res.message = "the " + p->profile + " profile is invalid";
+		return true;
+	}
+
+	res.success = true;
+	res.message = "the " + p->profile + " profile will be used from the next frame";
+
+	this->parameter_mailbox.post(std::move(p));
+
+	return true;
+}
+
+/*
+ * runs on the processing thread or before it starts
+ */
+void Dipa::applyParameters(const DipaParameters& p)
+{
+	this->params = p;
+
+	this->selectVOEngine(p.vo_engine);
+
+	// the next frame moves the tracking state to the new scale
+	this->resolution.reset(p.inverse_image_scale);
+
+	this->renderer.setGrid(p.grid_width, p.grid_height, p.grid_spacing);
+	this->deadline.setParameters(p);
+	this->line_detector->setParameters(p);
+	this->vo->fast_threshold = p.fast_threshold;
+}
+
+/*
+ * creates the vo engine or replaces it when a new profile picks another one. a replacement starts
+ * from the current pose and finds its own features on the next frame
+ */
+void Dipa::selectVOEngine(int engine)
+{
+	if(this->vo && engine == this->vo_engine)
+	{
+		return;
+	}
+
+	std::unique_ptr<PlanarOdometry> next;
+
+	if(engine == VO_ENGINE_DIRECT)
+	{
+		next.reset(new DirectTracker);
+	}
+	else
+	{
+		next.reset(new FeatureTracker);
+	}
+
+	if(this->vo)
+	{
+		ROS_INFO_STREAM("switching the vo engine to " << ((engine == VO_ENGINE_DIRECT) ? "direct" : "feature"));
+
+		next->K = this->vo->K;
+		next->state.currentPose = this->vo->state.currentPose;
+		next->state.time_at_last_realignment = this->vo->state.time_at_last_realignment;
 
+		// the new engine has no features yet so it must not lose tracking before it has tracked once
+		this->vo_initialized = false;
+
+#if USE_SLIDING_WINDOW
+		this->window_optimizer.reset(); // the window was built on the old engine's features
+#endif
+	}
+
+	this->vo = std::move(next);
+	this->vo_engine = engine;
 }
 
 void Dipa::realignmentCb(const geometry_msgs::PoseWithCovarianceStampedConstPtr& msg)
+{
+	std::unique_ptr<Realignment> r(new Realignment);
+
+	r->stamp = msg->header.stamp;
+	r->valid = true;
+
+	//get the transform from the msg frame to CAMERA
+	tf::StampedTransform b2c;
+	try {
+		tf_listener.lookupTransform(msg->header.frame_id, CAMERA_FRAME,
+				ros::Time(0), b2c);
+	} catch (tf::TransformException& e) {
+		ROS_ERROR_STREAM(e.what());
+		ROS_ERROR("THIS POSE WILL NOT BE USED TO REALIGN!");
+		r->valid = false;
+	}
+
+	r->b2c = b2c;
+	r->w2b = tf::Transform(tf::Quaternion(msg->pose.pose.orientation.x, msg->pose.pose.orientation.y, msg->pose.pose.orientation.z, msg->pose.pose.orientation.w),
+			tf::Vector3(msg->pose.pose.position.x, msg->pose.pose.position.y, msg->pose.pose.position.z));
+
+	this->realignment_mailbox.post(std::move(r));
+}
+
+#if USE_IMU
+/*
+ * feeds the gyro into the state filter directly. the filter locks itself
+ */
+void Dipa::imuCb(const sensor_msgs::ImuConstPtr& msg)
+{
+	tf::StampedTransform b2i;
+	try {
+		tf_listener.lookupTransform(BASE_FRAME, msg->header.frame_id,
+				ros::Time(0), b2i);
+	} catch (tf::TransformException& e) {
+		ROS_WARN_STREAM_THROTTLE(1, e.what());
+		return;
+	}
+
+	tf::Vector3 omega = b2i.getBasis() * tf::Vector3(msg->angular_velocity.x, msg->angular_velocity.y, msg->angular_velocity.z);
+
+	this->state.addImu(omega, msg->header.stamp);
+}
+#endif
+
+/*
+ * runs on the processing thread
+ */
+void Dipa::applyRealignment(const Realignment& r)
 {
 	//update the time
-	this->time_at_last_realignment = msg->header.stamp;
+	this->time_at_last_realignment = r.stamp;
 
 	// if tracking is lost update the pose of vo and the state
-	if(TRACKING_LOST)
+	if(TRACKING_LOST && r.valid)
 	{
 		ROS_INFO_STREAM("GOT POSE UPDATE TO REINITIALIZE TRACKING WITH!");
 
-		//get the transform from the msg frame to CAMERA
-		tf::StampedTransform b2c;
-		try {
-			tf_listener.lookupTransform(msg->header.frame_id, CAMERA_FRAME,
-					ros::Time(0), b2c);
-		} catch (tf::TransformException& e) {
-			ROS_ERROR_STREAM(e.what());
-			ROS_ERROR("THIS POSE WILL NOT BE USED TO REALIGN!");
-			TRACKING_LOST = true;
-			return; //
+		// the localizer lags behind the camera so its pose is moved to the newest frame with the vo
+		// increments since its stamp
+		tf::Transform w2c;
+		ros::Time stamp;
+		if(!this->pose_history.propagate(r.stamp, r.w2b*r.b2c, w2c, stamp))
+		{
+			ROS_WARN("THE REALIGNMENT POSE IS TOO OLD TO BE APPLIED!");
+			return;
 		}
 
-		tf::Transform w2b = tf::Transform(tf::Quaternion(msg->pose.pose.orientation.x, msg->pose.pose.orientation.y, msg->pose.pose.orientation.z, msg->pose.pose.orientation.w),
-				tf::Vector3(msg->pose.pose.position.x, msg->pose.pose.position.y, msg->pose.pose.position.z));
+		this->vo->updatePose(w2c, stamp); // update vo's pose estimate and its pixel depth's
+		this->pose_history.amendNewest(w2c, true);
 
-		this->vo.updatePose(w2b*b2c, msg->header.stamp); // update vo's pose estimate and its pixel depth's
-
-		//manually replace the dipa state's current estimate
-		this->state.manualPoseUpdate(w2b, msg->header.stamp);
+		//manually replace the dipa state's current estimate. the motion it has is from the lost track
+		this->state.resetPose(w2c * r.b2c.inverse(), stamp);
 
+#if USE_SLIDING_WINDOW
+		this->window_optimizer.reset(); // the window was built on the lost track
+#endif
 
 		TRACKING_LOST = false; // regained tracking
 	}
 }
 
+#if USE_SLIDING_WINDOW
+/*
+ * runs on the processing thread
+ * the correction of the newest window frame is applied to the current pose as a world frame
+ * correction and the refined landmarks replace the plane positions of their features.
+ *
+ * a correction is relative to the pose its frame was posted with so it is only valid if no other
+ * correction was applied after that frame was posted
+ */
+void Dipa::applyWindowCorrection()
+{
+	std::unique_ptr<SlidingWindowOptimizer::Correction> c = this->window_optimizer.takeCorrection();
+
+	if(!c || TRACKING_LOST)
+	{
+		return;
+	}
+
+	// a window which started before the last grid alignment would overwrite that fresher absolute fix
+	if(c->window_start < this->time_at_last_grid_alignment)
+	{
+		ROS_DEBUG("dropping a sliding window correction which started before the last grid alignment");
+		return;
+	}
+
+	// the pose this frame was posted with did not contain the last applied correction yet
+	if(c->stamp <= this->window_corrected_through)
+	{
+		ROS_DEBUG("dropping a sliding window correction of a frame posted before the last applied correction");
+		return;
+	}
+
+	tf::Transform correction = c->refined_w2c * c->estimate_w2c.inverse();
+
+	if(correction.getOrigin().length() > SWO_MAX_CORRECTION)
+	{
+		ROS_WARN_STREAM("ignoring a sliding window correction of " << correction.getOrigin().length() << " meters");
+		return;
+	}
+
+	// look the camera up before anything is changed so a failure leaves the tracker as it was
+	tf::StampedTransform c2b;
+	try {
+		tf_listener.lookupTransform(CAMERA_FRAME, BASE_FRAME,
+				ros::Time(0), c2b);
+	} catch (tf::TransformException& e) {
+		ROS_ERROR_STREAM(e.what());
+		return;
+	}
+
+	// the current pose belongs to the newest frame, not to the filter stamp the imu moves ahead
+	PoseHistory::Entry newest;
+	if(!this->pose_history.newest(newest))
+	{
+		return;
+	}
+
+	PlanarOdometry::VOState& vo_state = this->vo->state;
+
+	//both id lists are in increasing order
+	int j = 0;
+	for(int i = 0; i < vo_state.size(); i++)
+	{
+		while(j < c->ids.size() && c->ids[j] < vo_state.ids[i])
+		{
+			j++;
+		}
+
+		if(j < c->ids.size() && c->ids[j] == vo_state.ids[i])
+		{
+			vo_state.objects[i] = c->objects[j];
+		}
+		else
+		{
+			// move the features the window did not refine with the camera
+			tf::Vector3 moved = correction * tf::Vector3(vo_state.objects[i].x, vo_state.objects[i].y, 0);
+			vo_state.objects[i] = cv::Point2f(moved.x(), moved.y());
+		}
+	}
+
+	vo_state.currentPose = correction * vo_state.currentPose;
+	this->pose_history.amendNewest(vo_state.currentPose, false);
+
+	this->state.manualPoseUpdate(vo_state.currentPose * c2b, newest.stamp);
+
+	this->window_corrected_through = this->window_last_post;
+
+	ROS_DEBUG_STREAM("applied a sliding window correction of " << correction.getOrigin().length() << " meters");
+}
+#endif
+
+/*
+ * ingest only. the frame replaces any frame which has not been processed yet
+ */
 void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs::CameraInfoConstPtr& cam)
+{
+	std::unique_ptr<CameraFrame> frame(new CameraFrame);
+	frame->img = img;
+	frame->cam = cam;
+
+	if(this->frame_mailbox.post(std::move(frame)))
+	{
+		ROS_DEBUG("skipped a stale frame");
+	}
+}
+
+void Dipa::processFrame(const sensor_msgs::ImageConstPtr& img, const sensor_msgs::CameraInfoConstPtr& cam)
 //void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img)
 {
 
@@ -117,35 +508,81 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 		return; //
 	}
 
+	this->deadline.beginFrame(img->header.seq);
+
+	this->last_frame_grid_aligned = false;
+
 	cv::Mat temp = cv_bridge::toCvShare(img, img->encoding)->image.clone();
+	this->full_img = temp;
+
+	// pick the processing resolution and move the tracking state to it if it changed
+	double scale = this->selectImageScale(cam);
+	cv::Size scaled_size(temp.cols / scale, temp.rows / scale);
+
+	if(this->image_scale > 0 && scale != this->image_scale)
+	{
+		ROS_INFO_STREAM("processing at 1/" << scale << " resolution");
+
+		double factor = this->image_scale / scale;
+		this->vo->rescale(factor, scaled_size);
+		this->esm.rescale(factor);
+	}
+
+	this->image_scale = scale;
+
+	// the pixel thresholds are tuned at the configured scale
+	this->pixel_scale = this->params.pixelScale(this->image_scale);
+	this->line_detector->setPixelScale(this->pixel_scale);
+	this->vo->setPixelScale(this->pixel_scale);
+	this->line_tracker.setPixelScale(this->pixel_scale);
 
 	// scale the image parameters for the renderer
-	this->image_size = cv::Size(temp.cols / INVERSE_IMAGE_SCALE, temp.rows / INVERSE_IMAGE_SCALE);
-	this->image_K = (1.0 / INVERSE_IMAGE_SCALE) * (cv::Mat_<float>(3, 3) << cam->K.at(0), cam->K.at(1), cam->K.at(2), cam->K.at(3), cam->K.at(4), cam->K.at(5), cam->K.at(6), cam->K.at(7), cam->K.at(8));
+	this->image_size = scaled_size;
+	this->image_K = (1.0 / this->image_scale) * (cv::Mat_<float>(3, 3) << cam->K.at(0), cam->K.at(1), cam->K.at(2), cam->K.at(3), cam->K.at(4), cam->K.at(5), cam->K.at(6), cam->K.at(7), cam->K.at(8));
 
 	//set the vo K
-	this->vo.K = this->image_K;
+	this->vo->K = this->image_K;
 	//set the render K and size
 	this->renderer.setIntrinsic(this->image_K);
 	this->renderer.setSize(this->image_size);
 
 
 	cv::Mat scaled_img;
-	cv::resize(temp, scaled_img, cv::Size(temp.cols / INVERSE_IMAGE_SCALE, temp.rows / INVERSE_IMAGE_SCALE));
+	cv::resize(temp, scaled_img, this->image_size);
 
 	//PLANAR ODOMETRY
+	ros::WallTime stage_start = ros::WallTime::now();
 	double vo_error = -1; //per pixel odometry error
 	bool good_vo = false;
-	if(this->vo.state.features.size() > 0)
+	tf::Transform w2c_guess = this->vo->state.currentPose;
+	bool predicted = false;
+	PoseHistory::Entry last_frame;
+	if(this->state.twistSet() && this->pose_history.newest(last_frame) && img->header.stamp > last_frame.stamp)
+	{
+		// move the vo camera by the base motion the state predicts between the frames. the imu may
+		// already have moved the filter past both so it is queried at the frame stamps
+		tf::Transform delta = this->state.predict(last_frame.stamp).inverse() * this->state.predict(img->header.stamp);
+		w2c_guess = this->vo->state.currentPose * c2b * delta * c2b.inverse();
+		predicted = true;
+	}
+
+	if(this->vo->state.size() > 0)
 	{
 		ROS_DEBUG("start vo");
 		//flow the features
-		this->vo.updateFeatures(scaled_img);
+		if(predicted)
+		{
+			this->vo->updateFeatures(scaled_img, w2c_guess);
+		}
+		else
+		{
+			this->vo->updateFeatures(scaled_img);
+		}
 
-		if(this->vo.state.features.size() >= MINIMUM_TRACKABLE_FEATURES)
+		if(this->vo->state.size() >= MINIMUM_TRACKABLE_FEATURES)
 		{
 			//compute the new pose
-			good_vo = this->vo.computePose(vo_error);
+			good_vo = this->vo->computePose(vo_error);
 			if(!vo_initialized && good_vo){vo_initialized = true; ROS_INFO("VO INITIALIZED");}
 		}
 		else
@@ -160,20 +597,44 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 		ROS_WARN("visual odometry has no valid features");
 	}
 
+#if USE_ESM_FALLBACK
+	if(!good_vo && vo_initialized)
+	{
+		double rms;
+		if(this->esm.align(scaled_img, w2c_guess, rms))
+		{
+			ROS_WARN_STREAM("VO engine failed. using the esm alignment with rms " << rms);
+			this->vo->state.currentPose = w2c_guess;
+			this->vo->state.ppe = ESM_PPE;
+			vo_error = ESM_PPE;
+			good_vo = true;
+		}
+	}
+#endif
+
 	//get more features
-	this->vo.replenishFeatures(scaled_img);
+	this->vo->replenishFeatures(scaled_img, this->deadline.numFeatures());
+
+#if USE_ESM_FALLBACK
+	if(good_vo)
+	{
+		this->esm.setTemplate(scaled_img, this->vo->state.currentPose, this->image_K, this->projectedGridRegion(this->vo->state.currentPose));
+	}
+#endif
+
+	this->deadline.recordStage(DegradationController::STAGE_VO, (ros::WallTime::now() - stage_start).toSec());
 
 	// update the current pose estimate with this vo estimate if it is good
 	if(good_vo)
 	{
 		ROS_DEBUG("had good vo estimate: updating the base pose");
-		this->state.updatePose(this->vo.state.currentPose * c2b, img->header.stamp);
+		this->state.updatePose(this->vo->state.currentPose * c2b, img->header.stamp);
 
 		//check if the ppe is too high
-		if(this->vo.state.ppe > MAXIMUM_VO_PPE)
+		if(this->vo->state.ppe > this->params.maximum_vo_ppe * this->pixel_scale)
 		{
 			TRACKING_LOST = true;
-			ROS_WARN_STREAM("LOST TRACKING: VO PPE too high: " << this->vo.state.ppe);
+			ROS_WARN_STREAM("LOST TRACKING: VO PPE too high: " << this->vo->state.ppe);
 		}
 
 	}
@@ -187,10 +648,51 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 
 	}
 
+	this->pose_history.record(img->header.stamp, this->vo->state.currentPose);
 
 
+
+#if USE_SLIDING_WINDOW
+	//the observations are copied before grid alignment can re-anchor the features
+	std::unique_ptr<SlidingWindowOptimizer::Frame> window_frame;
+	if(good_vo && !TRACKING_LOST && this->vo->state.size() >= MINIMUM_TRACKABLE_FEATURES)
+	{
+		window_frame.reset(new SlidingWindowOptimizer::Frame);
+		window_frame->stamp = img->header.stamp;
+		window_frame->K = this->image_K;
+		window_frame->pixel_scale = this->pixel_scale;
+		window_frame->ids = this->vo->state.ids;
+		window_frame->pixels = this->vo->state.pixels;
+		window_frame->objects = this->vo->state.objects;
+		window_frame->grid_aligned = false;
+	}
+#endif
+
 	//GRID ALIGNMENT
-	this->detectFeatures(scaled_img);
+	if(this->deadline.skipGridAlignment())
+	{
+		ROS_WARN("OVER THE FRAME BUDGET. SKIPPING GRID ALIGNMENT!");
+		this->detected_corners.clear();
+		this->detected_labels.clear();
+		this->detected_lines.clear();
+		this->chamfer.clear();
+		this->line_tracker.reset(); // the lines can only be moved by one frame
+	}
+	else
+	{
+		stage_start = ros::WallTime::now();
+		this->predictGridLines(this->vo->state.currentPose);
+		this->predictLineMotion(good_vo);
+		if(this->deadline.roiDetection())
+		{
+			this->detectFeatures(scaled_img, this->deadline.detectionROI(scaled_img.size()));
+		}
+		else
+		{
+			this->detectFeatures(scaled_img);
+		}
+		this->deadline.recordStage(DegradationController::STAGE_DETECTION, (ros::WallTime::now() - stage_start).toSec());
+	}
 
 	ROS_ASSERT(this->state.currentPoseSet());
 
@@ -203,9 +705,14 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 	bool icp_good = false;
 	double icp_ppe = -1;
 
-	if(this->detected_corners.size() > 0)
+	if(this->haveGridObservations())
 	{
-		tf::Transform w2c_aligned = this->runICP(this->vo.state.currentPose, icp_ppe, icp_good);
+		stage_start = ros::WallTime::now();
+		this->max_icp_iterations = this->deadline.maxIterations();
+		tf::Transform w2c_aligned = this->alignGrid(this->vo->state.currentPose, icp_ppe, icp_good);
+		this->deadline.recordStage(DegradationController::STAGE_ICP, (ros::WallTime::now() - stage_start).toSec());
+
+		this->last_frame_grid_aligned = icp_good;
 
 
 		//IF HAD GOOD GRID ALIGNMENT UPDATE THE VO
@@ -214,23 +721,45 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 			ROS_INFO_STREAM("GOOD GRID ALIGNMENT WITH ERROR: " << icp_ppe);
 			ROS_ASSERT(icp_ppe != -1);
 
-			this->vo.updatePose(w2c_aligned, img->header.stamp); // update vo's pose estimate and its pixel depth's
+			this->vo->updatePose(w2c_aligned, img->header.stamp); // update vo's pose estimate and its pixel depth's
+			this->pose_history.amendNewest(w2c_aligned, true);
+			this->time_at_last_grid_alignment = img->header.stamp;
 
 			//manually replace the dipa state's current estimate
 			this->state.manualPoseUpdate(w2c_aligned * c2b, img->header.stamp);
 
+#if USE_SLIDING_WINDOW
+			if(window_frame)
+			{
+				window_frame->grid_aligned = true;
+				window_frame->grid_w2c = w2c_aligned;
+			}
+#endif
+
 			if(TRACKING_LOST)
 			{
 				//if we have passed all outlier checks we have regained tracking internally
 				ROS_INFO("REGAINED TRACKING FROM A INTERNAL GRID ALIGNMENT. MAY BE WRONG.");
 				TRACKING_LOST = false;
 
+#if USE_SLIDING_WINDOW
+				this->window_optimizer.reset(); // the window was built on the lost track
+#endif
+
 #if PUBLISH_INSIGHT
-				ROS_DEBUG("pub insight start");
-				this->publishInsight(scaled_img, icp_good);
-				ROS_DEBUG("pub insight end");
+				if(!this->deadline.skipInsight())
+				{
+					ROS_DEBUG("pub insight start");
+					stage_start = ros::WallTime::now();
+					this->publishInsight(scaled_img, icp_good, img->header.stamp);
+					this->deadline.recordStage(DegradationController::STAGE_INSIGHT, (ros::WallTime::now() - stage_start).toSec());
+					ROS_DEBUG("pub insight end");
+				}
 #endif
 
+				this->deadline.endFrame();
+				this->publishStatus(img->header.stamp);
+
 				// return to prevent a false velocity/omega from being published
 				return;
 			}
@@ -240,16 +769,31 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 			ROS_INFO("GRID ALIGNMENT FAILED");
 		}
 	}
-	else // no detected corners
+	else if(!this->deadline.skipGridAlignment()) // no detected corners
 	{
 		ROS_ERROR("NO DETECTED CORNERS. DID NOT ATTEMPT TO ALIGN GRID!");
 	}
 
+#if USE_SLIDING_WINDOW
+	if(window_frame && (window_frame->grid_aligned || ++this->frames_since_window_post >= SWO_FRAME_STRIDE))
+	{
+		window_frame->w2c = this->vo->state.currentPose;
+		this->window_last_post = window_frame->stamp;
+		this->window_optimizer.post(std::move(window_frame));
+		this->frames_since_window_post = 0;
+	}
+#endif
+
 
 #if PUBLISH_INSIGHT
-	ROS_DEBUG("pub insight start");
-	this->publishInsight(scaled_img, icp_good);
-	ROS_DEBUG("pub insight end");
+	if(!this->deadline.skipInsight())
+	{
+		ROS_DEBUG("pub insight start");
+		stage_start = ros::WallTime::now();
+		this->publishInsight(scaled_img, icp_good, img->header.stamp);
+		this->deadline.recordStage(DegradationController::STAGE_INSIGHT, (ros::WallTime::now() - stage_start).toSec());
+		ROS_DEBUG("pub insight end");
+	}
 #endif
 
 	// final outlier checks
@@ -259,14 +803,16 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 		ROS_WARN("TRACKING HAS BEEN LOST! the pose estimate is in an extreme position. will now attempt to reinitialize");
 	}
 
-	if(this->vo.state.getTimeSinceLastRealignment(img->header.stamp) > MAXIMUM_TIME_SINCE_REALIGNMENT)
+	if(this->vo->state.getTimeSinceLastRealignment(img->header.stamp) > this->params.maximum_time_since_realignment)
 	{
 		TRACKING_LOST = true;
-		ROS_WARN_STREAM("TRACKING HAS BEEN LOST! icp has not realigned the pose in " << this->vo.state.getTimeSinceLastRealignment(img->header.stamp) <<" seconds. will now attempt to reinitialize");
+		ROS_WARN_STREAM("TRACKING HAS BEEN LOST! icp has not realigned the pose in " << this->vo->state.getTimeSinceLastRealignment(img->header.stamp) <<" seconds. will now attempt to reinitialize");
 	}
 
-	if(!TRACKING_LOST){this->publishOdometry();}
+	if(!TRACKING_LOST){this->publishOdometry(img->header.stamp);}
 
+	this->deadline.endFrame();
+	this->publishStatus(img->header.stamp);
 
 	//alert the user if there has not been a realignment pose published
 	if(this->time_at_last_realignment == ros::Time(0)){ROS_WARN("REALIGNMENT POSE HAS NOT BEEN PUBLISHED YET");}
@@ -275,57 +821,78 @@ void Dipa::bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs:
 
 void Dipa::detectFeatures(cv::Mat scaled_img)
 {
-	ROS_DEBUG("detect start");
-	cv::Mat scaled_img_blur;
+	this->detectFeatures(scaled_img, cv::Rect(0, 0, scaled_img.cols, scaled_img.rows));
+}
 
-	cv::GaussianBlur(scaled_img, scaled_img_blur, cv::Size(0, 0), CANNY_BLUR_SIGMA);
+/*
+ * detects grid corners inside of the roi only. the corners are returned in full image coordinates
+ */
+void Dipa::detectFeatures(cv::Mat scaled_img, cv::Rect roi)
+{
+#if GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_CHAMFER
+	// the edges are aligned directly so there is no need for lines
+	this->detectEdgeDistance(scaled_img, roi);
+	return;
+#endif
 
-	//cv::Mat white_only;
-	//cv::threshold(scaled_img, white_only, WHITE_THRESH, 255, CV_8UC1);
+	cv::Mat roi_img = scaled_img(roi);
 
-	/*cv::Mat harris = cv::Mat(scaled_img.size(), CV_32FC1);
-	cv::cornerHarris(scaled_img, harris, HARRIS_SIZE, HARRIS_APERTURE, HARRIS_K, cv::BORDER_DEFAULT);
+	ROS_DEBUG("detect start");
 
-	cv::Mat harris_norm, harris_norm_scaled;
+	// the predicted lines in roi coordinates
+	std::vector<cv::Vec4f> prior = this->predicted_lines;
+	for(auto& e : prior)
+	{
+		e -= cv::Vec4f(roi.x, roi.y, roi.x, roi.y);
+	}
+	this->line_detector->setPrior(prior);
 
-	cv::normalize( harris, harris_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat() );
-	cv::convertScaleAbs( harris_norm, harris_norm_scaled );*/
-	/*
-#if USE_FAST_CORNERS
-	cv::Mat fast_blur;
-	cv::GaussianBlur(scaled_img, fast_blur, cv::Size(0, 0), FAST_BLUR_SIGMA);
-	std::vector<cv::KeyPoint> fast_kp;
-	cv::FAST(fast_blur, fast_kp, FAST_THRESHOLD, true, cv::FastFeatureDetector::TYPE_9_16);
-#endif
-	 */
+	std::vector<cv::Vec2f> lines;
 
-	//detect hough lines
-	cv::Mat canny;
-	cv::Canny(scaled_img_blur, canny, CANNY_THRESH_1, CANNY_THRESH_2);
+#if USE_LINE_TRACKER
+	// the motion of the full image moved into this roi from the last one
+	cv::Matx33d to_roi(1, 0, -roi.x, 0, 1, -roi.y, 0, 0, 1);
+	cv::Matx33d from_last_roi(1, 0, this->line_roi.x, 0, 1, this->line_roi.y, 0, 0, 1);
 
-#if SUPER_DEBUG
-	cv::imshow("raw canny", canny);
-	cv::waitKey(30);
+	this->line_tracker.track(roi_img, to_roi * this->line_motion * from_last_roi, this->line_motion_known, *this->line_detector, lines);
+	this->line_roi = roi;
+#else
+	this->line_detector->detect(roi_img, lines);
 #endif
 
-	std::vector<cv::Vec2f> lines;
-
-	cv::HoughLines(canny, lines, 1, CV_PI/180, HOUGH_THRESH, 0, 0);
-
 	if(lines.size() == 0)
 	{
 		ROS_ERROR("line detection failed to detect lines, please tune. SKIPPING FRAME AND CLEARING CORNERS!");
 		this->detected_corners.clear(); // remove previous detected corners
+		this->detected_labels.clear();
+		this->detected_lines.clear();
 		return;
 	}
+
+	//shift the lines back into the full image
+	this->detected_lines.clear();
+	for(auto& e : lines)
+	{
+		this->detected_lines.push_back(cv::Vec2f(e[0] + roi.x * cos(e[1]) + roi.y * sin(e[1]), e[1]));
+	}
+
+#if GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_LINES
+	// the lines are aligned directly so there is no need for their intersections
+	this->detected_corners.clear();
+	this->detected_labels.clear();
+	ROS_DEBUG("detect end");
+	return;
+#endif
+
 	ROS_DEBUG_STREAM("starting intersect alg: " << lines.size());
-	std::vector<cv::Point2f> intersects =  this->findLineIntersections(lines, cv::Rect(0, 0, canny.cols, canny.rows));
+	std::vector<std::pair<cv::Vec2f, cv::Vec2f> > pairs;
+	std::vector<cv::Point2f> intersects = LineDetector::findLineIntersections(lines, cv::Rect(0, 0, roi_img.cols, roi_img.rows), pairs);
 	ROS_DEBUG("finish intersect alg");
 	ROS_DEBUG("detect end");
 
 #if SUPER_DEBUG
 
-	cv::Mat out = scaled_img;
+	cv::Mat out = roi_img;
 	cv::cvtColor(out,out,CV_GRAY2RGB);
 
 	//draw lines
@@ -346,22 +913,32 @@ void Dipa::detectFeatures(cv::Mat scaled_img)
 	cv::drawKeypoints(out, fast_kp, out, cv::Scalar(0, 0, 255));
 #endif
 	 */
-	cv::Mat final;
-	cv::cvtColor(canny,canny,CV_GRAY2RGB);
-
 	//draw intersects
 	for(auto e : intersects){
-		cv::drawMarker(canny, e, cv::Scalar(255, 0, 0));
+		cv::drawMarker(out, e, cv::Scalar(255, 0, 0));
 	}
 
-	cv::hconcat(out, canny, final);
-
-	cv::imshow("kp", final);
+	cv::imshow("kp", out);
 	cv::waitKey(30);
 #endif
 
+	//shift the corners back into the full image
+	for(auto& e : intersects)
+	{
+		e.x += roi.x;
+		e.y += roi.y;
+	}
+
 	this->detected_corners = intersects; // set the corners
 
+	this->detected_labels.assign(intersects.size(), CornerLabel());
+#if USE_CORNER_LABELS
+	for(int i = 0; i < intersects.size(); i++)
+	{
+		this->detected_labels[i] = this->labelCorner(intersects[i], pairs[i].first[1], pairs[i].second[1]);
+	}
+#endif
+
 	/*
 	//if the user wants to include fast corners
 #if USE_FAST_CORNERS
@@ -374,53 +951,107 @@ void Dipa::detectFeatures(cv::Mat scaled_img)
 
 }
 
-bool inBounds(cv::Point2f testPt, cv::Rect bounds)
+/*
+ * builds the distance transform of the canny edges inside of the roi for the chamfer alignment
+ */
+void Dipa::detectEdgeDistance(cv::Mat scaled_img, cv::Rect roi)
 {
-	return (testPt.x >= bounds.x && testPt.y >= bounds.y && testPt.x <= bounds.width && testPt.y <= bounds.height);
+	cv::Mat blur, edges, not_edges;
+
+	cv::GaussianBlur(scaled_img(roi), blur, cv::Size(0, 0), this->params.canny_blur_sigma);
+	cv::Canny(blur, edges, this->params.canny_thresh_1, this->params.canny_thresh_2);
+
+	if(cv::countNonZero(edges) == 0)
+	{
+		ROS_ERROR("canny failed to detect edges, please tune. SKIPPING FRAME!");
+		this->chamfer.clear();
+		return;
+	}
+
+	// the distance transform measures the distance to the nearest zero pixel
+	cv::threshold(edges, not_edges, 0, 255, cv::THRESH_BINARY_INV);
+
+	cv::Mat_<float> roi_dist;
+	cv::distanceTransform(not_edges, roi_dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+
+	cv::Mat_<float> dist(scaled_img.rows, scaled_img.cols, (float)(this->params.max_norm * this->pixel_scale));
+	roi_dist.copyTo(dist(roi));
+
+	this->chamfer.setDistance(dist, roi, this->params.max_norm * this->pixel_scale);
 }
 
-std::vector<cv::Point2f> Dipa::findLineIntersections(std::vector<cv::Vec2f> lines, cv::Rect boundingBox)
+/*
+ * the padded bounding box of the visible grid if the camera is at w2c. empty if none is visible
+ */
+cv::Rect Dipa::projectedGridRegion(tf::Transform w2c)
 {
-	std::vector<cv::Point2f> pts;
+	this->renderer.setSize(this->image_size);
+	this->renderer.setIntrinsic(this->image_K);
+	this->renderer.setW2C(w2c);
 
-	//float min_d_theta = MIN_D_THETA;
+	std::vector<GridRenderer::Line> lines = this->renderer.renderGridLines();
 
-	for(int i = 0; i < lines.size() - 1; i++)
+	if(lines.empty())
 	{
-		for(int j = i+1; j < lines.size(); j++)
-		{
-			float t1 = (lines[i][1]);
-			float t2 = (lines[j][1]);
+		return cv::Rect();
+	}
 
-			//assert that the lines are not parallel
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for(auto& e : lines)
+	{
+		minX = std::min(minX, std::min(e.pa.x, e.pb.x));
+		minY = std::min(minY, std::min(e.pa.y, e.pb.y));
+		maxX = std::max(maxX, std::max(e.pa.x, e.pb.x));
+		maxY = std::max(maxY, std::max(e.pa.y, e.pb.y));
+	}
 
+	cv::Rect region(cvFloor(minX) - ESM_GRID_PADDING, cvFloor(minY) - ESM_GRID_PADDING, cvCeil(maxX - minX) + 2 * ESM_GRID_PADDING + 1, cvCeil(maxY - minY) + 2 * ESM_GRID_PADDING + 1);
 
-			float r1 = lines[i][0];
-			float r2 = lines[j][0];
+	return region & cv::Rect(0, 0, this->image_size.width, this->image_size.height);
+}
 
-			float ct1=cos(t1);     //matrix element a
-			float st1=sin(t1);     //b
-			float ct2=cos(t2);     //c
-			float st2=sin(t2);     //d
-			float d=ct1*st2-st1*ct2;        //determinative (rearranged matrix for inverse)
+/*
+ * the visible grid line edges if the camera is at w2c. nothing is predicted while tracking is lost
+ */
+void Dipa::predictGridLines(tf::Transform w2c)
+{
+	this->predicted_lines.clear();
 
-			//check if the vectors are parallel
-			if(fabs(d) < PARALLEL_THRESH)
-			{
-				continue;
-			}
+	if(TRACKING_LOST)
+	{
+		return;
+	}
 
-			cv::Point2f pt = cv::Point2f((st2*r1-st1*r2)/d, (-ct2*r1+ct1*r2)/d);
+	this->renderer.setSize(this->image_size);
+	this->renderer.setIntrinsic(this->image_K);
+	this->renderer.setW2C(w2c);
 
+	// the detectors find the edges of the grid lines so the windows are centered on them
+	for(auto& e : this->renderer.renderGridEdges())
+	{
+		this->predicted_lines.push_back(cv::Vec4f(e.pa.x, e.pa.y, e.pb.x, e.pb.y));
+	}
+}
 
-			if(inBounds(pt, boundingBox))
-			{
-				pts.push_back(pt);
-			}
-		}
+/*
+ * the homography which moves the lines of the last frame into this one. it comes from the vo motion
+ * of this frame so realignments between the frames do not move the lines
+ */
+void Dipa::predictLineMotion(bool good_vo)
+{
+	PoseHistory::Entry newest;
+
+	this->line_motion_known = good_vo && !TRACKING_LOST && !this->line_K.empty() && this->pose_history.newest(newest);
+
+	if(this->line_motion_known)
+	{
+		tf::Transform w2c = this->vo->state.currentPose;
+		tf::Transform w2c_last = w2c * newest.increment.inverse();
+
+		this->line_motion = LineTracker::planeHomography(w2c, this->image_K) * LineTracker::planeHomography(w2c_last, this->line_K).inv();
 	}
 
-	return pts;
+	this->line_K = this->image_K;
 }
 
 /*void Dipa::setupKDTree()
@@ -435,6 +1066,102 @@ std::vector<cv::Point2f> Dipa::findLineIntersections(std::vector<cv::Vec2f> line
 	ROS_DEBUG("tree setup");
 }*/
 
+/*
+ * labels a detected corner from the full resolution image by sampling one point in each of the four
+ * quadrants made by its two lines. the corner is in processing pixels and the thetas are the normals
+ * of its lines
+ */
+CornerLabel Dipa::labelCorner(cv::Point2f corner, float theta1, float theta2)
+{
+	CornerLabel label;
+
+	if(this->full_img.type() != CV_8UC1)
+	{
+		return label;
+	}
+
+	float c1 = cos(theta1), s1 = sin(theta1), c2 = cos(theta2), s2 = sin(theta2);
+	float det = c1 * s2 - s1 * c2;
+
+	if(fabs(det) < CORNER_MIN_CROSSING_SINE)
+	{
+		return label;
+	}
+
+	cv::Point2f q((corner.x + 0.5) * this->image_scale - 0.5, (corner.y + 0.5) * this->image_scale - 0.5);
+
+	// the corner is only known to a processing pixel so the radius grows with the scale
+	const float radius = CORNER_SAMPLE_RADIUS * this->image_scale;
+
+	// the offset which is a on the normal side of the first line and b of the second
+	auto offset = [&](float a, float b){
+		return cv::Point2f((s2 * a - s1 * b) / det, (-c2 * a + c1 * b) / det) * radius;
+	};
+
+	const float signs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+	cv::Point2f dirs[4];
+	int values[4];
+	int lo = 255, hi = 0;
+
+	for(int k = 0; k < 4; k++)
+	{
+		dirs[k] = offset(signs[k][0], signs[k][1]);
+		cv::Point2f p = q + dirs[k];
+
+		int x = cvRound(p.x), y = cvRound(p.y);
+		if(x < 0 || y < 0 || x >= this->full_img.cols || y >= this->full_img.rows)
+		{
+			return label;
+		}
+
+		values[k] = this->full_img.at<uchar>(y, x);
+		lo = std::min(lo, values[k]);
+		hi = std::max(hi, values[k]);
+	}
+
+	if(hi - lo < CORNER_MIN_CONTRAST)
+	{
+		return label;
+	}
+
+	int mid = (hi + lo) / 2;
+	int bright = 0, last_bright = 0, last_dark = 0;
+
+	for(int k = 0; k < 4; k++)
+	{
+		if(values[k] > mid)
+		{
+			bright++;
+			last_bright = k;
+		}
+		else
+		{
+			last_dark = k;
+		}
+	}
+
+	if(bright == 3)
+	{
+		label.type = CORNER_INNER;
+		label.dir = dirs[last_dark];
+	}
+	else if(bright == 1)
+	{
+		label.type = CORNER_OUTER;
+		label.dir = dirs[last_bright];
+	}
+	else
+	{
+		// two bright quadrants are an edge crossing a line, not the corner of a strip
+		label.type = CORNER_NONE;
+		return label;
+	}
+
+	label.dir *= 1.0 / sqrt(label.dir.dot(label.dir));
+
+	return label;
+}
+
 void Dipa::findClosestPoints(Matches& model)
 {
 	/*
@@ -454,39 +1181,143 @@ kdtree.radiusSearch(query, indices, dists, range, numOfPoints);
 	//ROS_DEBUG("finding nearest neighbors");
 	double maxRadius = sqrt(this->image_size.width * this->image_size.width + this->image_size.height * this->image_size.height);
 
-	for(auto& e : model.matches)
+	for(auto& e : model.matches)
+	{
+		std::vector<float> query;
+		query.push_back(e.obj_px.x);
+		query.push_back(e.obj_px.y);
+
+		std::vector<int> indexes;
+		std::vector<float> dists;
+
+		tree.knnSearch(query, indexes, dists, CORNER_SEARCH_NEIGHBORS);
+
+		int best = -1, nearest = 0;
+		double min = DBL_MAX, nearest_min = DBL_MAX;
+
+		for(auto j : indexes)
+		{
+			if(j < 0 || j >= detected_corners.size())
+			{
+				continue;
+			}
+
+			e.measurement = cv::Point2d(detected_corners.at(j).x, detected_corners.at(j).y);
+
+			double temp = e.computePixelNorm();
+
+			if(temp < nearest_min)
+			{
+				nearest = j;
+				nearest_min = temp;
+			}
+
+#if USE_CORNER_LABELS
+			// only corners of the same kind can correspond
+			if(j < detected_labels.size() && !e.label.compatible(detected_labels.at(j), cos(CORNER_MAX_ANGLE)))
+			{
+				continue;
+			}
+#endif
+
+			if(temp < min)
+			{
+				best = j;
+				min = temp;
+			}
+		}
+
+		// without a compatible corner the nearest one is kept for the error but never used
+		e.compatible = (best != -1);
+		if(!e.compatible)
+		{
+			best = nearest;
+			min = nearest_min;
+		}
+
+		e.measurement = cv::Point2d(detected_corners.at(best).x, detected_corners.at(best).y);
+		e.detected_index = best;
+		e.pixelNorm = min;
+		//ROS_DEBUG_STREAM("norm: " << e.pixelNorm);
+	}
+
+	//ROS_DEBUG("neighbors found");
+}
+
+/*
+ * moves the detected corners of the matches to their subpixel position in the full resolution image.
+ * only the corners which passed the max norm gate are refined and each only once per alignment.
+ * the measurements of the matches are updated to the refined corners
+ */
+void Dipa::refineMatchedCorners(Matches& huber, std::vector<bool>& refined)
+{
+	// cornerSubPix only takes single channel 8 bit or float images
+	if(this->full_img.type() != CV_8UC1)
+	{
+		return;
+	}
+
+	std::vector<int> indexes;
+	std::vector<cv::Point2f> pts;
+
+	for(auto& e : huber.matches)
 	{
-		std::vector<float> query;
-		query.push_back(e.obj_px.x);
-		query.push_back(e.obj_px.y);
+		int j = e.detected_index;
 
-		std::vector<int> indexes;
-		std::vector<float> dists;
+		if(j < 0 || refined.at(j))
+		{
+			continue;
+		}
 
-		tree.knnSearch(query, indexes, dists, 4);
+		refined.at(j) = true;
 
-		int best = 0;
-		double min = DBL_MAX;
+		// pixel centers line up between the scales
+		cv::Point2f p = this->detected_corners.at(j);
+		cv::Point2f q((p.x + 0.5) * this->image_scale - 0.5, (p.y + 0.5) * this->image_scale - 0.5);
 
-		for(auto j : indexes)
+		// the window has to fit in the image
+		if(q.x < SUBPIX_WINDOW + 1 || q.y < SUBPIX_WINDOW + 1 || q.x >= this->full_img.cols - SUBPIX_WINDOW - 1 || q.y >= this->full_img.rows - SUBPIX_WINDOW - 1)
 		{
-			e.measurement = cv::Point2d(detected_corners.at(j).x, detected_corners.at(j).y);
+			continue;
+		}
 
-			double temp = e.computePixelNorm();
+		indexes.push_back(j);
+		pts.push_back(q);
+	}
 
-			if(temp < min)
-			{
-				best = j;
-				min = temp;
-			}
+	if(pts.size() > 0)
+	{
+		cv::cornerSubPix(this->full_img, pts, cv::Size(SUBPIX_WINDOW, SUBPIX_WINDOW), cv::Size(-1, -1),
+				cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, SUBPIX_ITERATIONS, SUBPIX_EPSILON));
+	}
+
+	int moved = 0;
+
+	for(int i = 0; i < pts.size(); i++)
+	{
+		cv::Point2f p((pts[i].x + 0.5) / this->image_scale - 0.5, (pts[i].y + 0.5) / this->image_scale - 0.5);
+		cv::Point2f d = p - this->detected_corners.at(indexes[i]);
+
+		// a large move means the window saw something other than the corner
+		if(d.x * d.x + d.y * d.y > SUBPIX_MAX_SHIFT * SUBPIX_MAX_SHIFT * this->pixel_scale * this->pixel_scale)
+		{
+			continue;
 		}
 
-		e.measurement = cv::Point2d(detected_corners.at(best).x, detected_corners.at(best).y);
-		e.pixelNorm = min;
-		//ROS_DEBUG_STREAM("norm: " << e.pixelNorm);
+		this->detected_corners.at(indexes[i]) = p;
+		moved++;
 	}
 
-	//ROS_DEBUG("neighbors found");
+	ROS_DEBUG_STREAM("refined " << moved << " of " << pts.size() << " matched corners");
+
+	for(auto& e : huber.matches)
+	{
+		if(e.detected_index >= 0)
+		{
+			e.measurement = cv::Point2d(this->detected_corners.at(e.detected_index).x, this->detected_corners.at(e.detected_index).y);
+			e.computePixelNorm();
+		}
+	}
 }
 
 void Dipa::tf2rvecAndtvec(tf::Transform tf, cv::Mat& tvec, cv::Mat& rvec){
@@ -527,6 +1358,24 @@ tf::Transform Dipa::rvecAndtvec2tf(cv::Mat tvec, cv::Mat rvec){
 	return trans;
 }
 
+void Dipa::tf2Rt(tf::Transform tf, cv::Matx33d& R, cv::Vec3d& t)
+{
+	tf::Matrix3x3 basis = tf.getBasis();
+
+	R = cv::Matx33d(basis[0][0], basis[0][1], basis[0][2], basis[1][0], basis[1][1], basis[1][2], basis[2][0], basis[2][1], basis[2][2]);
+	t = cv::Vec3d(tf.getOrigin().x(), tf.getOrigin().y(), tf.getOrigin().z());
+}
+
+tf::Transform Dipa::Rt2tf(const cv::Matx33d& R, const cv::Vec3d& t)
+{
+	tf::Transform trans;
+
+	trans.getBasis().setValue(R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2), R(2, 0), R(2, 1), R(2, 2));
+	trans.setOrigin(tf::Vector3(t[0], t[1], t[2]));
+
+	return trans;
+}
+
 /*
  * tests if the pose estimate is reasonable by its position estimate
  */
@@ -537,12 +1386,12 @@ bool Dipa::fitsPositionalConstraints(tf::Transform w2c)
 		return false;
 	}
 
-	if(w2c.getOrigin().x() < (-(GRID_WIDTH * GRID_SPACING) / 2) || w2c.getOrigin().x() > ((GRID_WIDTH * GRID_SPACING) / 2))
+	if(w2c.getOrigin().x() < (-(this->params.grid_width * this->params.grid_spacing) / 2) || w2c.getOrigin().x() > ((this->params.grid_width * this->params.grid_spacing) / 2))
 	{
 		return false;
 	}
 
-	if(w2c.getOrigin().y() < (-(GRID_HEIGHT * GRID_SPACING) / 2) || w2c.getOrigin().y() > ((GRID_HEIGHT * GRID_SPACING) / 2))
+	if(w2c.getOrigin().y() < (-(this->params.grid_height * this->params.grid_spacing) / 2) || w2c.getOrigin().y() > ((this->params.grid_height * this->params.grid_spacing) / 2))
 	{
 		return false;
 	}
@@ -550,6 +1399,34 @@ bool Dipa::fitsPositionalConstraints(tf::Transform w2c)
 	return true;
 }
 
+/*
+ * true if this frame detected what the grid alignment mode needs
+ */
+bool Dipa::haveGridObservations()
+{
+#if GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_LINES
+	return this->detected_lines.size() > 0;
+#elif GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_CHAMFER
+	return !this->chamfer.empty();
+#else
+	return this->detected_corners.size() > 0;
+#endif
+}
+
+/*
+ * aligns the model grid to this frame's detections with the configured mode
+ */
+tf::Transform Dipa::alignGrid(tf::Transform w2c_guess, double& ppe, bool& pass)
+{
+#if GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_LINES
+	return this->runPnL(w2c_guess, ppe, pass);
+#elif GRID_ALIGNMENT_MODE == GRID_ALIGNMENT_CHAMFER
+	return this->runChamfer(w2c_guess, ppe, pass);
+#else
+	return this->runICP(w2c_guess, ppe, pass);
+#endif
+}
+
 /*
  * runs iterative closest point algorithm modified to work with 2d to 3d correspondences.
  * takes a tf transform representing the transform from the world coordinate frame to the camera coordinate frame
@@ -572,6 +1449,9 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 
 	ROS_DEBUG("begining optim");
 
+	// the detected corners which have been moved to their subpixel position
+	std::vector<bool> refined(this->detected_corners.size(), false);
+
 	//initial setup and sse calculation
 	this->renderer.setC2W(this->rvecAndtvec2tf(tvec, rvec)); // the the renderer's current pose
 	Matches matches = this->renderer.renderGridCorners(); // render the corners into this frame given our current guess
@@ -585,18 +1465,18 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 
 #if SUPER_DEBUG
 	cv::Mat blank = cv::Mat::zeros(this->image_size, CV_8UC3);
-	blank = matches.draw(blank, this->detected_corners);
+	blank = matches.draw(blank, this->detected_corners, this->params.max_norm * this->pixel_scale);
 	cv::imshow("render", blank);
 	cv::waitKey(30);
 	ros::Duration dur(1);
 	//dur.sleep();
 #endif
 
-	for(int i = 0; i < MAX_ITERATIONS; i++)
+	for(int i = 0; i < this->max_icp_iterations; i++)
 	{
 		// now we minimize the photometric error between our known model and our observations using the correspondences we have just guessed
 #if USE_MAX_NORM
-		Matches huber = matches.performHuberMaxNorm(MAX_NORM);
+		Matches huber = matches.performHuberMaxNorm(this->params.max_norm * this->pixel_scale);
 		ROS_DEBUG_STREAM("performed huber max norm size before: " << matches.matches.size() << " now: " << huber.matches.size());
 
 		//check if there are enough matches to reliably align the grid
@@ -609,6 +1489,10 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 			return w2c_guess; // return the guess as it is the best answer for now
 		}
 
+#if USE_SUBPIX_REFINEMENT
+		this->refineMatchedCorners(huber, refined);
+#endif
+
 		cv::solvePnP(huber.getObjectInOrder(), huber.getMeasurementsInOrder(), this->image_K, cv::noArray(), rvec, tvec, true, cv::SOLVEPNP_ITERATIVE); // use the current guess to help convergence
 #else
 		cv::solvePnP(matches.getObjectInOrder(), matches.getMeasurementsInOrder(), this->image_K, cv::noArray(), rvec, tvec, true, cv::SOLVEPNP_ITERATIVE); // use the current guess to help convergence
@@ -630,7 +1514,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 			ppe = huber_error;
 
 			ROS_DEBUG_STREAM("huber per point error: " << huber_error);
-			if(huber_error > MAX_ICP_ERROR)
+			if(huber_error > this->params.max_icp_error * this->pixel_scale)
 			{
 				ROS_WARN("final per point error too high!");
 
@@ -641,7 +1525,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 #else
 			ppe = currencurrent_sse;
 
-			if(current_sse > MAX_ICP_ERROR)
+			if(current_sse > this->params.max_icp_error * this->pixel_scale)
 			{
 
 				pass = false;
@@ -652,7 +1536,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 
 #if SUPER_DEBUG
 			cv::Mat blank = cv::Mat::zeros(this->image_size, CV_8UC3);
-			blank = matches.draw(blank, this->detected_corners);
+			blank = matches.draw(blank, this->detected_corners, this->params.max_norm * this->pixel_scale);
 			cv::imshow("render", blank);
 			cv::waitKey(30);
 			ros::Duration dur(1);
@@ -667,7 +1551,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 
 #if SUPER_DEBUG
 		cv::Mat blank = cv::Mat::zeros(this->image_size, CV_8UC3);
-		blank = matches.draw(blank, this->detected_corners);
+		blank = matches.draw(blank, this->detected_corners, this->params.max_norm * this->pixel_scale);
 		cv::imshow("render", blank);
 		cv::waitKey(30);
 		ros::Duration dur(1);
@@ -680,7 +1564,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 
 	ROS_ASSERT(USE_MAX_NORM);
 
-	Matches huber = matches.performHuberMaxNorm(MAX_NORM);
+	Matches huber = matches.performHuberMaxNorm(this->params.max_norm * this->pixel_scale);
 
 	if(huber.matches.size() < MINIMUM_FINAL_MATCHES)
 	{
@@ -709,7 +1593,7 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 	}
 
 	//finally check if the error is too high
-	if(ppe > MAX_ICP_ERROR)
+	if(ppe > this->params.max_icp_error * this->pixel_scale)
 	{
 		ROS_WARN_STREAM("huber ppe too high at: " << ppe);
 		pass = false;
@@ -734,8 +1618,289 @@ tf::Transform Dipa::runICP(tf::Transform w2c_guess, double& ppe, bool& pass)
 }
 
 
-void Dipa::publishOdometry()
+/*
+ * matches every detected line to the closest visible model edge with a similar angle. the detector
+ * finds the edges of the grid lines so the model has both edges of every line. the visible end
+ * points of the model edge are moved onto the plane with the pose (R, t) which takes world points
+ * into the camera.
+ *
+ * returns the number of matched lines in the grid direction with the fewest matches
+ */
+int Dipa::matchGridLines(const std::vector<GridRenderer::Line>& model, const cv::Matx33d& R, const cv::Vec3d& t, std::vector<PlanarLineSolver::Correspondence>& corr)
+{
+	corr.clear();
+
+	cv::Matx33d Rt = R.t();
+	cv::Vec3d center = -(Rt * t);
+	double fx = this->image_K(0), cx = this->image_K(2), fy = this->image_K(4), cy = this->image_K(5);
+
+	// the plane point seen at a pixel
+	auto backProject = [&](cv::Point2f px, cv::Point2d& plane_pt){
+		cv::Vec3d ray = Rt * cv::Vec3d((px.x - cx) / fx, (px.y - cy) / fy, 1.0);
+		if(fabs(ray[2]) < 1e-9){return false;}
+		double lambda = -center[2] / ray[2];
+		if(lambda <= 0){return false;}
+		plane_pt = cv::Point2d(center[0] + lambda * ray[0], center[1] + lambda * ray[1]);
+		return true;
+	};
+
+	int x_lines = 0, y_lines = 0;
+
+	for(auto& d : this->detected_lines)
+	{
+		int best = -1;
+		double best_dist = this->params.max_norm * this->pixel_scale;
+		cv::Vec3d best_line;
+
+		for(int j = 0; j < model.size(); j++)
+		{
+			const GridRenderer::Line& m = model[j];
+			double rho = d[0], theta = d[1];
+
+			// the same line can be on either side of the theta wrap around
+			double dtheta = theta - m.line[1];
+			if(dtheta > CV_PI / 2){theta -= CV_PI; rho = -rho; dtheta -= CV_PI;}
+			else if(dtheta < -CV_PI / 2){theta += CV_PI; rho = -rho; dtheta += CV_PI;}
+
+			if(fabs(dtheta) > PNL_MAX_ANGLE)
+			{
+				continue;
+			}
+
+			cv::Vec3d line(cos(theta), sin(theta), rho);
+
+			double da = fabs(line[0] * m.pa.x + line[1] * m.pa.y - rho);
+			double db = fabs(line[0] * m.pb.x + line[1] * m.pb.y - rho);
+			double dist = std::max(da, db);
+
+			if(dist < best_dist)
+			{
+				best_dist = dist;
+				best = j;
+				best_line = line;
+			}
+		}
+
+		if(best == -1)
+		{
+			continue;
+		}
+
+		const GridRenderer::Line& m = model[best];
+
+		PlanarLineSolver::Correspondence c;
+		if(!backProject(m.pa, c.a) || !backProject(m.pb, c.b))
+		{
+			continue;
+		}
+		c.line = best_line;
+
+		corr.push_back(c);
+
+		// lines of constant x run along y
+		if(m.a.x() == m.b.x()){x_lines++;}
+		else{y_lines++;}
+	}
+
+	return std::min(x_lines, y_lines);
+}
+
+/*
+ * aligns the grid by matching the detected lines to the model lines directly and solving for the pose
+ * which puts the model lines on them. there are no intersections or nearest corner searches.
+ *
+ * takes the current best guess of the transform from the world coordinate frame to the camera
+ * coordinate frame and returns the optimized pose. the outlier tests mirror runICP
+ */
+tf::Transform Dipa::runPnL(tf::Transform w2c_guess, double& ppe, bool& pass)
+{
+	ppe = -1;
+	pass = false;
+
+	this->renderer.setSize(this->image_size);
+	this->renderer.setIntrinsic(this->image_K);
+
+	// the pose which takes world points into the camera (C2W)
+	cv::Matx33d R;
+	cv::Vec3d t;
+	this->tf2Rt(w2c_guess.inverse(), R, t);
+
+	PlanarLineSolver solver;
+	std::vector<PlanarLineSolver::Correspondence> corr;
+	std::vector<GridRenderer::Line> model;
+	double last_rms = -1;
+
+	ROS_DEBUG("begining pnl");
+
+	for(int i = 0; i < this->max_icp_iterations; i++)
+	{
+		this->renderer.setC2W(this->Rt2tf(R, t));
+		model = this->renderer.renderGridEdges();
+
+		if(this->matchGridLines(model, R, t, corr) < PNL_MIN_LINES_PER_FAMILY)
+		{
+			ROS_WARN("too few line matches in a grid direction to reliably align the grid!");
+			return w2c_guess;
+		}
+
+		double rms = solver.step(corr, this->image_K, PNL_HUBER * this->pixel_scale, R, t);
+
+		if(rms < 0)
+		{
+			ROS_WARN("the pnl step failed!");
+			return w2c_guess;
+		}
+
+		ROS_DEBUG_STREAM("pnl error: " << rms << " with " << corr.size() << " lines");
+
+		if(last_rms >= 0 && fabs(rms - last_rms) < CONVERGENCE_DELTA)
+		{
+			ROS_DEBUG("PNL Converged");
+			break;
+		}
+
+		last_rms = rms;
+	}
+
+	ROS_DEBUG("end pnl");
+
+	// the final matches and error at the solved pose
+	this->renderer.setC2W(this->Rt2tf(R, t));
+	model = this->renderer.renderGridEdges();
+
+	if(this->matchGridLines(model, R, t, corr) < PNL_MIN_LINES_PER_FAMILY)
+	{
+		ROS_WARN_STREAM("final line matches too low: " << corr.size());
+		return w2c_guess;
+	}
+
+	// the share of the detected lines which lie on a grid line edge
+	double matchRatio = (double)corr.size() / (double)this->detected_lines.size();
+
+	if(matchRatio < MINIMUM_HUBER_RATIO)
+	{
+		ROS_WARN_STREAM("line match ratio too low at: " << matchRatio);
+		return w2c_guess;
+	}
+
+	double sum = 0;
+	for(auto& e : corr)
+	{
+		sum += fabs(PlanarLineSolver::distance(e.line, e.a, this->image_K, R, t)) + fabs(PlanarLineSolver::distance(e.line, e.b, this->image_K, R, t));
+	}
+
+	ppe = sum / (2.0 * corr.size());
+
+	if(ppe > this->params.max_icp_error * this->pixel_scale)
+	{
+		ROS_WARN_STREAM("pnl ppe too high at: " << ppe);
+		return w2c_guess;
+	}
+
+	tf::Transform final_w2c = this->Rt2tf(R, t).inverse();
+
+	if(!this->fitsPositionalConstraints(final_w2c))
+	{
+		ROS_WARN_STREAM("pose does not fit positional constraints: x: " << final_w2c.getOrigin().x() << " y: " << final_w2c.getOrigin().y() << " z: " << final_w2c.getOrigin().z());
+		return w2c_guess;
+	}
+
+	pass = true;
+
+	return final_w2c;
+}
+
+/*
+ * aligns the grid by pulling points along the model line edges onto the distance transform of this
+ * frame's edges. there are no correspondences so no nearest neighbour search is needed.
+ *
+ * takes the current best guess of the transform from the world coordinate frame to the camera
+ * coordinate frame and returns the optimized pose. the outlier tests mirror runICP
+ */
+tf::Transform Dipa::runChamfer(tf::Transform w2c_guess, double& ppe, bool& pass)
+{
+	ppe = -1;
+	pass = false;
+
+	std::vector<cv::Point2d> pts = this->renderer.sampleGridEdges(CHAMFER_SAMPLES_PER_CELL);
+
+	// the pose which takes world points into the camera (C2W)
+	cv::Matx33d R;
+	cv::Vec3d t;
+	this->tf2Rt(w2c_guess.inverse(), R, t);
+
+	double last_rms = -1;
+
+	ROS_DEBUG("begining chamfer");
+
+	for(int i = 0; i < this->max_icp_iterations; i++)
+	{
+		double rms = this->chamfer.step(pts, this->image_K, CHAMFER_HUBER * this->pixel_scale, R, t);
+
+		if(rms < 0)
+		{
+			ROS_WARN("the chamfer step failed!");
+			return w2c_guess;
+		}
+
+		ROS_DEBUG_STREAM("chamfer error: " << rms);
+
+		if(last_rms >= 0 && fabs(rms - last_rms) < CONVERGENCE_DELTA)
+		{
+			ROS_DEBUG("CHAMFER Converged");
+			break;
+		}
+
+		last_rms = rms;
+	}
+
+	ROS_DEBUG("end chamfer");
+
+	int visible, inliers;
+	ppe = this->chamfer.error(pts, this->image_K, R, t, visible, inliers);
+
+	if(inliers < CHAMFER_MIN_INLIERS)
+	{
+		ROS_WARN_STREAM("chamfer inliers too low: " << inliers);
+		return w2c_guess;
+	}
+
+	double inlierRatio = (double)inliers / (double)visible;
+
+	if(inlierRatio < MINIMUM_HUBER_RATIO)
+	{
+		ROS_WARN_STREAM("chamfer inlier ratio too low at: " << inlierRatio);
+		return w2c_guess;
+	}
+
+	if(ppe > this->params.max_icp_error * this->pixel_scale)
+	{
+		ROS_WARN_STREAM("chamfer ppe too high at: " << ppe);
+		return w2c_guess;
+	}
+
+	tf::Transform final_w2c = this->Rt2tf(R, t).inverse();
+
+	if(!this->fitsPositionalConstraints(final_w2c))
+	{
+		ROS_WARN_STREAM("pose does not fit positional constraints: x: " << final_w2c.getOrigin().x() << " y: " << final_w2c.getOrigin().y() << " z: " << final_w2c.getOrigin().z());
+		return w2c_guess;
+	}
+
+	pass = true;
+
+	return final_w2c;
+}
+
+/*
+ * publishes the state at the frame stamp t. the imu may have moved the filter past it
+ */
+void Dipa::publishOdometry(ros::Time t)
 {
+	if(this->offline)
+	{
+		return;
+	}
 
 	if(!this->state.twistSet() || !this->state.currentPoseSet())
 	{
@@ -746,19 +1911,21 @@ void Dipa::publishOdometry()
 	nav_msgs::Odometry msg;
 
 	msg.child_frame_id = BASE_FRAME;
-	msg.header.stamp = this->state.getCurrentBestPoseStamp();
+	msg.header.stamp = t;
 	msg.header.frame_id = WORLD_FRAME;
 
-	tf::Quaternion q = this->state.getCurrentBestPose().getRotation();
+	tf::Transform w2b = this->state.predict(t);
+
+	tf::Quaternion q = w2b.getRotation();
 
 	msg.pose.pose.orientation.w = q.w();
 	msg.pose.pose.orientation.x = q.x();
 	msg.pose.pose.orientation.y = q.y();
 	msg.pose.pose.orientation.z = q.z();
 
-	msg.pose.pose.position.x = this->state.getCurrentBestPose().getOrigin().x();
-	msg.pose.pose.position.y = this->state.getCurrentBestPose().getOrigin().y();
-	msg.pose.pose.position.z = this->state.getCurrentBestPose().getOrigin().z();
+	msg.pose.pose.position.x = w2b.getOrigin().x();
+	msg.pose.pose.position.y = w2b.getOrigin().y();
+	msg.pose.pose.position.z = w2b.getOrigin().z();
 
 	msg.twist.twist.angular.x = this->state.getBaseFrameOmega().x();
 	msg.twist.twist.angular.y = this->state.getBaseFrameOmega().y();
@@ -769,67 +1936,122 @@ void Dipa::publishOdometry()
 	msg.twist.twist.linear.z = this->state.getBaseFrameVelocity().z();
 
 	// twist covariance = CONST * VO_PPE
-	if(this->vo.state.ppe == 0)
-		this->vo.state.ppe = 0.00001;
+	if(this->vo->state.ppe == 0)
+		this->vo->state.ppe = 0.00001;
 
-	msg.twist.covariance.at(0) = this->vo.state.ppe;
-	msg.twist.covariance.at(7) = this->vo.state.ppe;
-	msg.twist.covariance.at(14) = this->vo.state.ppe;
-	msg.twist.covariance.at(21) = this->vo.state.ppe;
-	msg.twist.covariance.at(28) = this->vo.state.ppe;
-	msg.twist.covariance.at(35) = this->vo.state.ppe;
+	msg.twist.covariance.at(0) = this->vo->state.ppe;
+	msg.twist.covariance.at(7) = this->vo->state.ppe;
+	msg.twist.covariance.at(14) = this->vo->state.ppe;
+	msg.twist.covariance.at(21) = this->vo->state.ppe;
+	msg.twist.covariance.at(28) = this->vo->state.ppe;
+	msg.twist.covariance.at(35) = this->vo->state.ppe;
 
 	this->odom_pub.publish(msg);
 }
 
+/*
+ * runs on a spinner thread. the state filter locks itself so this never waits on a frame
+ */
+void Dipa::predictionTimerCb(const ros::TimerEvent& event)
+{
+	if(TRACKING_LOST || this->prediction_pub.getNumSubscribers() == 0)
+	{
+		return;
+	}
+
+	if(!this->state.twistSet() || !this->state.currentPoseSet())
+	{
+		return;
+	}
+
+	dipa::PosePrediction msg;
 
-void Dipa::publishInsight(cv::Mat in, bool grid_aligned){
+	msg.header.stamp = ros::Time::now();
+	msg.header.frame_id = WORLD_FRAME;
+	msg.child_frame_id = BASE_FRAME;
 
-	cv::Mat src;
+	tf::Transform w2b = this->state.predict(msg.header.stamp, msg.age);
 
-	cv::cvtColor(in, src, CV_GRAY2BGR);
+	tf::Quaternion q = w2b.getRotation();
 
-	if(detected_corners.size() > 0)
-	{
-		for(auto e : this->detected_corners)
-		{
-			cv::drawMarker(src, e, cv::Scalar(255, 0, 0), cv::MARKER_DIAMOND, 4);
-		}
-	}
+	msg.pose.orientation.w = q.w();
+	msg.pose.orientation.x = q.x();
+	msg.pose.orientation.y = q.y();
+	msg.pose.orientation.z = q.z();
 
-	for(auto e : this->vo.state.features){
-		cv::drawMarker(src, e.px, cv::Scalar(255, 0, 255), cv::MARKER_SQUARE, 6);
-	}
-	ROS_DEBUG_STREAM("rendering grid");
-	this->renderer.setW2C(this->vo.state.currentPose); // render the grid with the current w2c
-	Matches m = this->renderer.renderGridCorners();
+	msg.pose.position.x = w2b.getOrigin().x();
+	msg.pose.position.y = w2b.getOrigin().y();
+	msg.pose.position.z = w2b.getOrigin().z();
+
+	tf::Vector3 omega = this->state.getBaseFrameOmega();
+	tf::Vector3 vel = this->state.getBaseFrameVelocity();
+
+	msg.twist.angular.x = omega.x();
+	msg.twist.angular.y = omega.y();
+	msg.twist.angular.z = omega.z();
+
+	msg.twist.linear.x = vel.x();
+	msg.twist.linear.y = vel.y();
+	msg.twist.linear.z = vel.z();
+
+	this->prediction_pub.publish(msg);
+}
+
+
+/*
+ * hands a snapshot of this frame to the insight thread if anyone is listening
+ */
+void Dipa::publishInsight(cv::Mat in, bool grid_aligned, ros::Time t){
 
-	ROS_DEBUG_STREAM("rendering grid corners with " << m.matches.size() << "corners");
-	if(m.matches.size() > 0)
+	if(this->offline || !this->insight.wanted())
 	{
-		//draw
-		for(auto e : m.matches){
-			if(grid_aligned)
-			{
-				cv::drawMarker(src, e.obj_px, cv::Scalar(0, 255, 0), cv::MARKER_CROSS, 8);
-			}
-			else
-			{
-				cv::drawMarker(src, e.obj_px, cv::Scalar(0, 0, 255), cv::MARKER_CROSS, 8);
-			}
-		}
+		return;
 	}
-	else
+
+	std::unique_ptr<InsightPublisher::Snapshot> snap(new InsightPublisher::Snapshot);
+
+	snap->img = in;
+	snap->detected_corners = this->detected_corners;
+	snap->features = this->vo->state.pixels;
+	snap->w2c = this->vo->state.currentPose;
+	snap->K = this->image_K.clone();
+	snap->size = this->image_size;
+	snap->grid_width = this->params.grid_width;
+	snap->grid_height = this->params.grid_height;
+	snap->grid_spacing = this->params.grid_spacing;
+	snap->grid_aligned = grid_aligned;
+	snap->stamp = t;
+
+	this->insight.post(std::move(snap));
+}
+
+void Dipa::publishStatus(ros::Time t)
+{
+	if(this->offline)
 	{
-		ROS_WARN("there are no projected grid corners for the current estimate.");
+		return;
 	}
 
-	cv_bridge::CvImage cv_img;
+	dipa::DipaStatus msg;
+
+	msg.header.stamp = t;
+	msg.header.frame_id = CAMERA_FRAME;
+
+	msg.degradation_level = this->deadline.getLevel();
+	msg.dropped_frames = this->deadline.getDroppedFrames();
+	msg.skipped_frames = this->frame_mailbox.getOverwrittenCount();
+	msg.processed_frames = this->deadline.getProcessedFrames();
+
+	msg.frame_latency = this->deadline.getFrameLatency();
+	msg.vo_latency = this->deadline.getStageLatency(DegradationController::STAGE_VO);
+	msg.detection_latency = this->deadline.getStageLatency(DegradationController::STAGE_DETECTION);
+	msg.icp_latency = this->deadline.getStageLatency(DegradationController::STAGE_ICP);
+	msg.insight_latency = this->deadline.getStageLatency(DegradationController::STAGE_INSIGHT);
+
+	msg.predicted_latency = this->deadline.predictCost(this->deadline.getLevel());
+	msg.budget = this->deadline.getBudget();
 
-	cv_img.image = src;
-	cv_img.header.frame_id = CAMERA_FRAME;
-	cv_img.encoding = sensor_msgs::image_encodings::BGR8;
+	msg.inverse_image_scale = this->image_scale;
 
-	this->insight_pub.publish(cv_img.toImageMsg());
-	ROS_DEBUG("end publish");
+	this->status_pub.publish(msg);
 }
@@ -47,77 +47,241 @@
 
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 
+#include <sensor_msgs/Imu.h>
+
 #include <dipa/DipaParams.h>
+#include <dipa/DipaParameters.h>
+
+#include <std_srvs/Trigger.h>
 
 #include <dipa/GridRenderer.h>
 
 #include <dipa/DipaTypes.h>
 
 #include <dipa/planar_odometry/FeatureTracker.h>
+#include <dipa/planar_odometry/DirectTracker.h>
+#include <dipa/planar_odometry/PlanarESM.h>
+#include <dipa/planar_odometry/PlanarLineSolver.h>
+#include <dipa/planar_odometry/PlanarChamferSolver.h>
+
+#include <dipa/line_detection/HoughLineDetector.h>
+#include <dipa/line_detection/LSDLineDetector.h>
+#include <dipa/line_detection/EDLineDetector.h>
+#include <dipa/line_detection/PriorHoughLineDetector.h>
+#include <dipa/line_detection/LineTracker.h>
+
+#include <dipa/DegradationController.h>
+#include <dipa/ResolutionController.h>
+
+#include <dipa/DipaStatus.h>
+#include <dipa/PosePrediction.h>
+
+#include <dipa/Mailbox.h>
+
+#include <dipa/InsightPublisher.h>
+
+#include <dipa/SlidingWindowOptimizer.h>
+
+#include <dipa/PoseHistory.h>
+
+#include <thread>
+#include <limits>
 
 class Dipa {
 public:
 
+	struct CameraFrame{
+		sensor_msgs::ImageConstPtr img;
+		sensor_msgs::CameraInfoConstPtr cam;
+	};
+
+	struct Realignment{
+		tf::Transform w2b;
+		tf::Transform b2c; // transform from the msg frame to the camera
+		ros::Time stamp;
+		bool valid; // false if the camera transform could not be looked up
+	};
+
 	tf::TransformListener tf_listener;
 
 	GridRenderer renderer;
 
-	FeatureTracker vo;
+	std::unique_ptr<PlanarOdometry> vo;
+	int vo_engine; // the engine of vo
+
+	// aligns the whole frame when the vo engine loses its features
+	PlanarESM esm;
+
+	std::unique_ptr<LineDetector> line_detector;
+	std::vector<cv::Vec4f> predicted_lines; // the visible grid line edges at the vo pose of this frame
+
+	LineTracker line_tracker;
+	cv::Matx33d line_motion; // moves the last frame's lines into this frame
+	bool line_motion_known;
+	cv::Mat_<float> line_K; // intrinsics of the last frame the lines were found in
+	cv::Rect line_roi; // roi of the last frame the lines were found in
 
 	cv::Size image_size;
 	cv::Mat_<float> image_K;
+	double image_scale; // the inverse scale of the last frame. 0 before the first
+	double pixel_scale; // multiplies the pixel thresholds which are tuned at params.inverse_image_scale
+	cv::Mat full_img; // the current frame at full resolution
 
-	bool TRACKING_LOST;
+	ResolutionController resolution;
+
+	std::atomic<bool> TRACKING_LOST; // also read by the prediction timer
 	bool vo_initialized;
 
+	bool offline; // nothing is published or subscribed
+
+	bool last_frame_grid_aligned; // the last processed frame had a good grid alignment
+
 	std::vector<cv::Point2f> detected_corners;
+	std::vector<CornerLabel> detected_labels; // one for every detected corner
+	std::vector<cv::Vec2f> detected_lines; // (rho, theta) in full image coordinates
+	PlanarChamferSolver chamfer; // holds the edge distance transform of this frame
 
 	DipaState state;
 
+	// the runtime parameters. only replaced between frames on the processing thread
+	DipaParameters params;
+
+	// the pose each frame ended with so delayed realignments can be applied at their stamp
+	PoseHistory pose_history;
+
+	DegradationController deadline;
+	int max_icp_iterations;
+
+#if USE_SLIDING_WINDOW
+	SlidingWindowOptimizer window_optimizer;
+	int frames_since_window_post;
+	ros::Time window_last_post; // the stamp of the newest frame posted to the window
+	ros::Time window_corrected_through; // the newest posted frame when a correction was last applied
+#endif
+
 	ros::Publisher odom_pub;
+	ros::Publisher status_pub;
+
+	ros::Publisher prediction_pub;
+	ros::Timer prediction_timer;
 
 #if PUBLISH_INSIGHT
 	//insight
-	ros::Publisher insight_pub;
+	InsightPublisher insight;
 #endif
 
 	ros::Subscriber pose_realignment_sub;
 	ros::Time time_at_last_realignment; //  the msg stamp of the last pose realignment
+	ros::Time time_at_last_grid_alignment; // the stamp of the last frame with a good grid alignment
+
+	image_transport::CameraSubscriber bottom_cam_sub;
+
+#if USE_IMU
+	ros::Subscriber imu_sub;
+#endif
+
+	// the callbacks only write into these. the processing thread always takes the newest
+	Mailbox<CameraFrame> frame_mailbox;
+	Mailbox<Realignment> realignment_mailbox;
+	Mailbox<DipaParameters> parameter_mailbox;
+
+	ros::ServiceServer reload_parameters_srv;
+
+	std::atomic<bool> processing;
 
 	//cv::flann::Index* kdtree;
 
 	Dipa(tf::Transform initial_world_to_base_transform, bool debug=false);
+
+	/*
+	 * an offline instance for tools which feed processFrame themselves
+	 */
+	Dipa(tf::Transform initial_world_to_base_transform, tf::Transform b2c, const DipaParameters& p);
+
 	virtual ~Dipa();
 
-	void run(){
-		ros::spin();
-	}
+	void initialize(tf::Transform initial_world_to_base_transform, tf::Transform b2c);
+
+	void run();
+
+	void processingLoop();
 
 	//void bottomCamCb(const sensor_msgs::ImageConstPtr& img);
 	void bottomCamCb(const sensor_msgs::ImageConstPtr& img, const sensor_msgs::CameraInfoConstPtr& cam);
 
+	void processFrame(const sensor_msgs::ImageConstPtr& img, const sensor_msgs::CameraInfoConstPtr& cam);
+
 	//realignment sub
 	void realignmentCb(const geometry_msgs::PoseWithCovarianceStampedConstPtr& msg);
 
+	void applyRealignment(const Realignment& r);
+
+#if USE_IMU
+	void imuCb(const sensor_msgs::ImuConstPtr& msg);
+#endif
+
+#if USE_SLIDING_WINDOW
+	void applyWindowCorrection();
+#endif
+
+	//reads the parameter server again and hands the result to the processing thread
+	bool reloadParametersCb(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
+
+	void applyParameters(const DipaParameters& p);
+
+	void selectVOEngine(int engine);
+
+	double selectImageScale(const sensor_msgs::CameraInfoConstPtr& cam);
+
+	void predictionTimerCb(const ros::TimerEvent& event);
+
 	//void setupKDTree();
 
 	void detectFeatures(cv::Mat img);
 
-	std::vector<cv::Point2f> findLineIntersections(std::vector<cv::Vec2f> lines, cv::Rect boundingBox);
+	void detectFeatures(cv::Mat img, cv::Rect roi);
+
+	void detectEdgeDistance(cv::Mat img, cv::Rect roi);
+
+	void predictGridLines(tf::Transform w2c);
+
+	cv::Rect projectedGridRegion(tf::Transform w2c);
+
+	void predictLineMotion(bool good_vo);
+
+	CornerLabel labelCorner(cv::Point2f corner, float theta1, float theta2);
 
 	void findClosestPoints(Matches& model);
 
+	void refineMatchedCorners(Matches& huber, std::vector<bool>& refined);
+
 	void tf2rvecAndtvec(tf::Transform tf, cv::Mat& tvec, cv::Mat& rvec);
 
 	tf::Transform rvecAndtvec2tf(cv::Mat tvec, cv::Mat rvec);
 
+	void tf2Rt(tf::Transform tf, cv::Matx33d& R, cv::Vec3d& t);
+
+	tf::Transform Rt2tf(const cv::Matx33d& R, const cv::Vec3d& t);
+
 	bool fitsPositionalConstraints(tf::Transform w2c);
 
+	bool haveGridObservations();
+
+	tf::Transform alignGrid(tf::Transform w2c_guess, double& ppe, bool& pass);
+
 	tf::Transform runICP(tf::Transform w2c_guess, double& ppe, bool& pass);
 
-	void publishOdometry();
+	int matchGridLines(const std::vector<GridRenderer::Line>& model, const cv::Matx33d& R, const cv::Vec3d& t, std::vector<PlanarLineSolver::Correspondence>& corr);
+
+	tf::Transform runPnL(tf::Transform w2c_guess, double& ppe, bool& pass);
+
+	tf::Transform runChamfer(tf::Transform w2c_guess, double& ppe, bool& pass);
+
+	void publishOdometry(ros::Time t);
+
+	void publishInsight(cv::Mat src,  bool grid_aligned, ros::Time t);
 
-	void publishInsight(cv::Mat src,  bool grid_aligned);
+	void publishStatus(ros::Time t);
 };
 
 #endif /* DIPA_INCLUDE_DIPA_DIPA_H_ */
@@ -0,0 +1,112 @@
+/*
+ * DipaParameters.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/DipaParameters.h>
+
+DipaParameters::DipaParameters() {
+	profile = "default";
+
+	grid_width = GRID_WIDTH;
+	grid_height = GRID_HEIGHT;
+	grid_spacing = GRID_SPACING;
+
+	max_iterations = MAX_ITERATIONS;
+	max_norm = MAX_NORM;
+	max_icp_error = MAX_ICP_ERROR;
+
+	inverse_image_scale = INVERSE_IMAGE_SCALE;
+	resolution_control = USE_RESOLUTION_CONTROL;
+	canny_blur_sigma = CANNY_BLUR_SIGMA;
+	canny_thresh_1 = CANNY_THRESH_1;
+	canny_thresh_2 = CANNY_THRESH_2;
+	hough_thresh = HOUGH_THRESH;
+
+	vo_engine = VO_ENGINE;
+	num_features = NUM_FEATURES;
+	fast_threshold = FAST_THRESHOLD;
+	maximum_vo_ppe = MAXIMUM_VO_PPE;
+	maximum_time_since_realignment = MAXIMUM_TIME_SINCE_REALIGNMENT;
+
+	frame_time_budget = FRAME_TIME_BUDGET;
+	degraded_max_iterations = DEGRADED_MAX_ITERATIONS;
+	degraded_num_features = DEGRADED_NUM_FEATURES;
+}
+
+void DipaParameters::load(const ros::NodeHandle& nh)
+{
+	nh.param<std::string>("profile", profile, profile);
+
+	nh.param<int>("grid_width", grid_width, grid_width);
+	nh.param<int>("grid_height", grid_height, grid_height);
+	nh.param<double>("grid_spacing", grid_spacing, grid_spacing);
+
+	nh.param<int>("max_iterations", max_iterations, max_iterations);
+	nh.param<double>("max_norm", max_norm, max_norm);
+	nh.param<double>("max_icp_error", max_icp_error, max_icp_error);
+
+	nh.param<double>("inverse_image_scale", inverse_image_scale, inverse_image_scale);
+	nh.param<bool>("resolution_control", resolution_control, resolution_control);
+	nh.param<double>("canny_blur_sigma", canny_blur_sigma, canny_blur_sigma);
+	nh.param<int>("canny_thresh_1", canny_thresh_1, canny_thresh_1);
+	nh.param<int>("canny_thresh_2", canny_thresh_2, canny_thresh_2);
+	nh.param<int>("hough_thresh", hough_thresh, hough_thresh);
+
+	nh.param<int>("vo_engine", vo_engine, vo_engine);
+	nh.param<int>("num_features", num_features, num_features);
+	nh.param<int>("fast_threshold", fast_threshold, fast_threshold);
+	nh.param<double>("maximum_vo_ppe", maximum_vo_ppe, maximum_vo_ppe);
+	nh.param<double>("maximum_time_since_realignment", maximum_time_since_realignment, maximum_time_since_realignment);
+
+	nh.param<double>("frame_time_budget", frame_time_budget, frame_time_budget);
+	nh.param<int>("degraded_max_iterations", degraded_max_iterations, degraded_max_iterations);
+	nh.param<int>("degraded_num_features", degraded_num_features, degraded_num_features);
+
+	ROS_INFO_STREAM("loaded the " << profile << " parameter profile");
+}
+
+bool DipaParameters::valid() const
+{
+	bool ok = true;
+
+	if(grid_width <= 0 || grid_height <= 0 || grid_spacing <= 0)
+	{
+		ROS_WARN("the grid must have a positive size");
+		ok = false;
+	}
+
+	if(inverse_image_scale < 1)
+	{
+		ROS_WARN("the image can't be scaled up");
+		ok = false;
+	}
+
+	if(vo_engine != VO_ENGINE_FEATURE && vo_engine != VO_ENGINE_DIRECT)
+	{
+		ROS_WARN("the vo engine must be VO_ENGINE_FEATURE (0) or VO_ENGINE_DIRECT (1)");
+		ok = false;
+	}
+
+	if(max_iterations <= 0 || degraded_max_iterations <= 0 || degraded_max_iterations > max_iterations)
+	{
+		ROS_WARN("the degraded icp iterations must be positive and at most max_iterations");
+		ok = false;
+	}
+
+	if(num_features < MINIMUM_TRACKABLE_FEATURES || degraded_num_features < MINIMUM_TRACKABLE_FEATURES || degraded_num_features > num_features)
+	{
+		ROS_WARN("the degraded feature count must be trackable and at most num_features");
+		ok = false;
+	}
+
+	if(frame_time_budget <= 0)
+	{
+		ROS_WARN("the frame time budget must be positive");
+		ok = false;
+	}
+
+	return ok;
+}
@@ -0,0 +1,86 @@
+/*
+ * DipaParameters.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_DIPAPARAMETERS_H_
+#define DIPA_INCLUDE_DIPA_DIPAPARAMETERS_H_
+
+#include <ros/ros.h>
+
+#include <string>
+
+#include <dipa/DipaParams.h>
+
+/*
+ * the tuning knobs which can change at runtime. the defaults are the values in DipaParams.h.
+ *
+ * the values are read from the parameter server under the node's private namespace with the
+ * names of the fields. config/ has profiles which the launch file loads there. every component
+ * keeps its own copy which is only replaced between frames so the hot loops read plain members.
+ *
+ * knobs which size buffers or unroll loops (patch sizes, pyramid levels, window sizes) stay compile
+ * time constants.
+ *
+ * pixel thresholds (max_norm, max_icp_error, hough_thresh, maximum_vo_ppe and the pixel distances in
+ * DipaParams.h) hold at inverse_image_scale. when resolution control picks another scale they are
+ * multiplied by pixelScale.
+ */
+struct DipaParameters {
+
+	std::string profile; // the name of the loaded profile for logging
+
+	//GRID
+	int grid_width;
+	int grid_height;
+	double grid_spacing;
+
+	//ICP
+	int max_iterations;
+	double max_norm;
+	double max_icp_error;
+
+	//CORNER DETECTION
+	double inverse_image_scale; // the starting scale when resolution_control is set
+	bool resolution_control;
+	double canny_blur_sigma;
+	int canny_thresh_1;
+	int canny_thresh_2;
+	int hough_thresh;
+
+	//PLANAR ODOM
+	int vo_engine; // VO_ENGINE_FEATURE or VO_ENGINE_DIRECT
+	int num_features;
+	int fast_threshold;
+	double maximum_vo_ppe;
+	double maximum_time_since_realignment;
+
+	//DEADLINE
+	double frame_time_budget;
+	int degraded_max_iterations;
+	int degraded_num_features;
+
+	DipaParameters();
+
+	/*
+	 * reads every value which is set on the parameter server and keeps the current value otherwise
+	 */
+	void load(const ros::NodeHandle& nh);
+
+	/*
+	 * returns false and warns if a value would break the pipeline
+	 */
+	bool valid() const;
+
+	/*
+	 * converts a pixel threshold tuned at inverse_image_scale to image_scale
+	 */
+	double pixelScale(double image_scale) const
+	{
+		return inverse_image_scale / image_scale;
+	}
+};
+
+#endif /* DIPA_INCLUDE_DIPA_DIPAPARAMETERS_H_ */
@@ -23,6 +23,15 @@
 #define ABSOLUTE_MAX_Z 5.0
 
 //ICP
+//how the detected grid is aligned to the model grid
+//corners: intersections of the detected lines matched to the nearest model corners
+//lines: the detected lines matched to the model lines and solved with point to line pnl
+//chamfer: points along the model line edges pulled onto the distance transform of the canny edges
+#define GRID_ALIGNMENT_CORNERS 0
+#define GRID_ALIGNMENT_LINES 1
+#define GRID_ALIGNMENT_CHAMFER 2
+#define GRID_ALIGNMENT_MODE GRID_ALIGNMENT_CORNERS
+
 #define MAX_ITERATIONS 20
 
 #define CONVERGENCE_DELTA 0.1
@@ -50,6 +59,22 @@
 // maximium per pixel error to be unti deemed outlier
 #define MAX_ICP_ERROR 1.5
 
+//PNL
+//maximum angle between a model line and its detected line
+#define PNL_MAX_ANGLE (5.0 * CV_PI / 180.0)
+//both grid directions need this many matched lines to constrain the pose
+#define PNL_MIN_LINES_PER_FAMILY 2
+//point to line distance in pixels after which a residual is down weighted
+#define PNL_HUBER 2.0
+
+//CHAMFER
+//points sampled along each edge of every grid line per grid cell
+#define CHAMFER_SAMPLES_PER_CELL 8
+//edge distance in pixels after which a residual is down weighted. distances are truncated at max_norm
+#define CHAMFER_HUBER 1.5
+//minimum visible points on an edge for a good alignment
+#define CHAMFER_MIN_INLIERS 50
+
 //END ICP
 
 //CORNER DETECTION
@@ -70,21 +95,168 @@
 //#define MIN_D_THETA 10 * CV_PI/180
 #define PARALLEL_THRESH 0.1
 
+//the backend which finds the grid lines
+#define LINE_DETECTOR_HOUGH 0 // canny edges voted into cv::HoughLines
+#define LINE_DETECTOR_LSD 1 // opencv's line segment detector fitted to the grid line families
+#define LINE_DETECTOR_EDLINES 2 // edge drawing chains split into segments and fitted to the grid line families
+#define LINE_DETECTOR_PRIOR_HOUGH 3 // hough which only votes near the grid lines predicted from the vo pose
+#define LINE_DETECTOR LINE_DETECTOR_PRIOR_HOUGH
+
+//the prior hough only votes within this angle of a predicted line
+#define PRIOR_HOUGH_THETA_WINDOW (6.0 * CV_PI / 180.0)
+//and within this many pixels of its rho
+#define PRIOR_HOUGH_RHO_WINDOW 10.0
+
+//segments shorter than this many pixels are ignored by the segment backends
+#define LINE_MIN_SEGMENT_LENGTH 10
+//segments within this angle of a grid line family belong to it
+#define LINE_FAMILY_ANGLE_TOL (15.0 * CV_PI / 180.0)
+//segments of a family whose rho is within this many pixels are fitted as one line
+#define LINE_MERGE_RHO 3.0
+//a fitted line needs this many pixels of segments
+#define LINE_MIN_SUPPORT 20.0
+
+//edge drawing
+//gradient magnitude (|dx| + |dy| of sobel) below which a pixel is not an edge
+#define ED_GRADIENT_THRESH 36
+//an anchor must be this much stronger than its neighbors across the edge
+#define ED_ANCHOR_THRESH 8
+//anchors are only searched on every n-th row and column
+#define ED_SCAN_INTERVAL 2
+//maximum distance in pixels of a chain pixel from its fitted segment
+#define ED_LINE_FIT_ERROR 1.0
+
+//line tracking
+//keep the lines between frames and only run the line detector when too few survive
+#define USE_LINE_TRACKER true
+//points searched along the normal of every tracked line
+#define LINE_TRACK_SAMPLES 16
+//pixels searched to each side of the predicted line
+#define LINE_TRACK_SEARCH 6
+//intensity change per pixel an edge needs to be found
+#define LINE_TRACK_MIN_GRADIENT 10.0
+//fraction of the samples which must find the edge for the line to survive
+#define LINE_TRACK_MIN_INLIERS 0.6
+//pixels an edge may be from the first fit of a line to be used in the second
+#define LINE_TRACK_REFIT_DIST 1.5
+//run the line detector when fewer lines of either grid direction survive
+#define LINE_TRACK_MIN_FAMILY_LINES 3
+//the most lines tracked at once. bounds the cost of a frame
+#define LINE_TRACK_MAX_LINES 40
+
+//subpixel refinement
+//refine the corners which survive the max norm gate on the full resolution image
+#define USE_SUBPIX_REFINEMENT true
+//half width of the refinement window in full resolution pixels
+#define SUBPIX_WINDOW 5
+#define SUBPIX_ITERATIONS 20
+#define SUBPIX_EPSILON 0.01
+//a refined corner which moved more than this many processing pixels is left where it was
+#define SUBPIX_MAX_SHIFT 1.5
+
+//corner labels
+//label every detected corner by its quadrants and only match it to model corners of the same kind
+#define USE_CORNER_LABELS true
+//distance in processing pixels from both lines at which the quadrants around a corner are sampled.
+//the detected lines are rounded to a processing pixel so it must be larger than one and stay below
+//the width of the tape in processing pixels
+#define CORNER_SAMPLE_RADIUS 1.5
+//lines crossing at a shallower angle spread the samples too far to label their corner
+#define CORNER_MIN_CROSSING_SINE 0.5
+//minimum intensity difference between the brightest and darkest quadrant
+#define CORNER_MIN_CONTRAST 30
+//maximum angle in the image between the odd quadrants of a model corner and its detected corner
+#define CORNER_MAX_ANGLE (45.0 * CV_PI / 180.0)
+//nearest detected corners searched for a compatible one
+#define CORNER_SEARCH_NEIGHBORS 6
+
 //END GRID CORNER DETECTION
 
 //PLANAR ODOM
+//the default engine used for planar odometry. the vo_engine parameter switches it at runtime
+#define VO_ENGINE_FEATURE 0 // fast corners tracked with klt
+#define VO_ENGINE_DIRECT 1 // sparse patches aligned by their photometric error
+#define VO_ENGINE VO_ENGINE_FEATURE
+
 //fast corner detector for planar odometry
 #define FAST_THRESHOLD 100
 #define FAST_BLUR_SIGMA 0.5
 
 #define KLT_MIN_EIGEN 1e-4
 
+#define KLT_WINDOW_SIZE 21
+#define KLT_PYRAMID_LEVELS 3
+
+//used instead when the features are initialized with the motion predicted by the state
+#define KLT_PREDICTED_WINDOW_SIZE 11
+#define KLT_PREDICTED_PYRAMID_LEVELS 1
+
 #define MIN_NEW_FEATURE_DIST 30
 
 #define NUM_FEATURES 40
 
 #define MINIMUM_TRACKABLE_FEATURES 4
 
+//OUTLIER DETECTION
+//track each feature back into the old frame and drop it if it does not return to where it started
+#define USE_FORWARD_BACKWARD_CHECK true
+#define MAX_FORWARD_BACKWARD_ERROR 1.0
+//number of blocks of features which are tracked forward and backward in parallel
+#define KLT_PARALLEL_BLOCKS 4
+
+//OUTLIER DETECTION
+//drop features which disagree with the ransac plane homography before solving the pose
+#define USE_HOMOGRAPHY_GATE true
+//maximum reprojection error in pixels for a homography inlier
+#define HOMOGRAPHY_RANSAC_THRESH 2.0
+
+//track the features against the last keyframe instead of the last frame
+#define USE_KEYFRAMES true
+//a new keyframe is taken when fewer than this fraction of the keyframe's features are still tracked
+#define KEYFRAME_MIN_OVERLAP 0.6
+//or when the features have moved this many pixels from the keyframe on average
+#define KEYFRAME_MAX_PARALLAX 15.0
+
+//solve the pose by decomposing the plane homography instead of with solvePnP
+#define USE_PLANAR_POSE_SOLVER true
+//gauss newton steps used to refine the decomposed pose
+#define PLANAR_GN_ITERATIONS 3
+
+//DIRECT ENGINE
+//width of the square patches in pixels
+#define DIRECT_PATCH_SIZE 4
+#define DIRECT_PYRAMID_LEVELS 3
+//gauss newton iterations per pyramid level for the pose and per patch for its pixel
+#define DIRECT_ITERATIONS 10
+#define DIRECT_PATCH_ITERATIONS 5
+//photometric residuals larger than this are down weighted
+#define DIRECT_HUBER_THRESH 10.0
+//minimum gradient of a new patch center
+#define DIRECT_MIN_GRADIENT 40
+//OUTLIER DETECTION
+//patches whose mean intensity error exceeds this after alignment are dropped
+#define DIRECT_MAX_PATCH_ERROR 12.0
+
+//ESM FALLBACK
+//align the whole frame to the last one when the vo engine fails to compute motion
+#define USE_ESM_FALLBACK true
+#define ESM_SAMPLE_STEP 2
+//minimum gradient of a template sample
+#define ESM_MIN_GRADIENT 10
+//the template is thinned out evenly to stay below this many samples
+#define ESM_MAX_SAMPLES 3000
+#define ESM_MIN_SAMPLES 100
+#define ESM_ITERATIONS 15
+//the alignment warns when it takes longer than this many seconds
+#define ESM_TARGET_TIME 0.002
+//pixels around the projected grid which are still sampled for the template
+#define ESM_GRID_PADDING 10
+//OUTLIER DETECTION
+//maximum rms intensity error of an aligned frame
+#define ESM_MAX_RMS 20.0
+//the per pixel error reported for a pose from the esm fallback
+#define ESM_PPE 3.0
+
 //OUTLIER DETECTION
 // if icp has not realigned vo since this time, we have lost tracking
 #define MAXIMUM_TIME_SINCE_REALIGNMENT 5
@@ -94,10 +266,107 @@
 
 //END PLANAR ODOM
 
+//SLIDING WINDOW
+//refine the recent poses and features together on a background thread
+#define USE_SLIDING_WINDOW true
+#define SWO_WINDOW_SIZE 8
+//every n-th frame with good vo is added to the window. grid aligned frames are always added
+#define SWO_FRAME_STRIDE 3
+#define SWO_ITERATIONS 5
+//reprojection errors larger than this in pixels are down weighted
+#define SWO_HUBER_THRESH 2.0
+//information of the prior holding the oldest pose and of a grid alignment prior
+#define SWO_ANCHOR_WEIGHT 1e6
+#define SWO_GRID_PRIOR_WEIGHT 1e3
+#define SWO_DAMPING 1e-4
+//frames waiting for the optimizer beyond this are dropped
+#define SWO_MAX_PENDING 4
+//OUTLIER DETECTION
+//corrections which move the camera more than this in meters are ignored
+#define SWO_MAX_CORRECTION 0.2
+//END SLIDING WINDOW
+
+//STATE ESTIMATION
+//white noise driving the constant velocity model in m/s^2 and rad/s^2
+#define EKF_ACCEL_NOISE 2.0
+#define EKF_ANGULAR_ACCEL_NOISE 2.0
+//uncertainty of the first pose and motion
+#define EKF_INITIAL_POSITION_SIGMA 0.1
+#define EKF_INITIAL_ROTATION_SIGMA 0.1
+#define EKF_INITIAL_VELOCITY_SIGMA 1.0
+#define EKF_INITIAL_OMEGA_SIGMA 1.0
+//vo poses drift so they are loose absolute measurements
+#define EKF_VO_POSITION_SIGMA 0.05
+#define EKF_VO_ROTATION_SIGMA 0.05
+//noise of the motion between two vo poses in m and rad
+#define EKF_VO_INCREMENT_POSITION_SIGMA 0.01
+#define EKF_VO_INCREMENT_ROTATION_SIGMA 0.01
+//grid alignments and realignments
+#define EKF_MANUAL_POSITION_SIGMA 0.005
+#define EKF_MANUAL_ROTATION_SIGMA 0.005
+//measurements older than this many measurements are dropped
+#define EKF_HISTORY_SIZE 300
+
+//fuse the gyro of an imu into the state
+#define USE_IMU false
+#define IMU_TOPIC "imu/data"
+//gyro noise in rad/s
+#define EKF_GYRO_SIGMA 0.01
+//END STATE ESTIMATION
+
+//DEADLINE
+//time budget for processing one frame in seconds
+#define FRAME_TIME_BUDGET 0.05
+
+//smoothing factor for the measured stage latencies
+#define LATENCY_SMOOTHING 0.2
+
+//number of frames in a row that must fit the budget before relaxing one degradation level
+#define DEGRADATION_RELAX_FRAMES 15
+//the less degraded level must be predicted to use less than this fraction of the budget to relax
+#define DEGRADATION_RELAX_MARGIN 0.8
+
+//reduced settings used by the degradation ladder
+#define DEGRADED_MAX_ITERATIONS 5
+#define DEGRADED_NUM_FEATURES 20
+//width and height of the centered roi used for line detection as a fraction of the image
+#define DEGRADED_DETECTION_ROI 0.5
+
+//number of threads serving the ros callbacks. images are processed on their own thread
+#define CALLBACK_THREADS 2
+
+//END DEADLINE
+
+//RESOLUTION
+//choose the image scale every frame from the latency and the altitude. otherwise INVERSE_IMAGE_SCALE is fixed
+//this is the default of the resolution_control parameter
+#define USE_RESOLUTION_CONTROL true
+
+//the range of the chosen inverse scale
+#define RES_MIN_INVERSE_SCALE 2.0
+#define RES_MAX_INVERSE_SCALE 8.0
+//the inverse scale is a multiple of this and only changes by at least this much
+#define RES_SCALE_STEP 0.5
+
+//the grid lines must be at least this many pixels apart in the processed image for reliable corners
+#define RES_MIN_GRID_SPACING 24.0
+//the nominal cost of a frame should use this fraction of the budget
+#define RES_TARGET_LOAD 0.7
+//a change must be wanted for this many frames in a row. changes needed to keep the grid detectable are immediate
+#define RES_HOLD_FRAMES 15
+
+//END RESOLUTION
+
 #define ODOM_TOPIC "dipa/odom"
 
+//the state is extrapolated and published at this rate in hz between frames. 0 disables it
+#define PREDICTION_RATE 200.0
+#define PREDICTION_TOPIC "dipa/predicted_pose"
+
 // this topic will serve as a last resort for realignment
 #define REALIGNMENT_TOPIC "state/pose"
+//number of frames remembered to apply a delayed realignment at its stamp
+#define POSE_HISTORY_SIZE 256
 
 #define BOTTOM_CAMERA_TOPIC "/bottom_camera/image_rect"
 #define CAMERA_FRAME "bottom_camera"
@@ -109,5 +378,10 @@
 // insight is an image representing the describing the current state of DIPA
 #define PUBLISH_INSIGHT true
 #define INSIGHT_TOPIC "dipa/insight"
+// maximum rate in Hz. insight is only drawn when the topic has subscribers
+#define INSIGHT_RATE 5.0
+
+// status reports the active degradation level, frame drops and stage latencies
+#define STATUS_TOPIC "dipa/status"
 
 #endif /* DIPA_INCLUDE_DIPA_DIPAPARAMS_H_ */
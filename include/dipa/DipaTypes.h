@@ -26,13 +26,49 @@
 
 #include <dipa/DipaParams.h>
 
+#include <dipa/PoseFilter.h>
+
+/*
+ * every grid corner is the corner of a tape strip where one quadrant differs from the other three.
+ * inner corners have one dark floor quadrant between white tape and outer corners, the four at the
+ * outside of the border, have one white quadrant on the dark floor.
+ */
+enum CornerType {
+	CORNER_UNKNOWN, // could not be labeled. matches anything
+	CORNER_INNER,
+	CORNER_OUTER,
+	CORNER_NONE // not a grid corner. matches nothing
+};
+
+struct CornerLabel {
+	CornerType type;
+	cv::Point2f dir; // unit direction of the odd quadrant in the image
+
+	CornerLabel() {
+		type = CORNER_UNKNOWN;
+	}
+
+	bool compatible(const CornerLabel& other, double min_cos) const {
+		if (type == CORNER_UNKNOWN || other.type == CORNER_UNKNOWN) {
+			return true;
+		}
+
+		return type == other.type && type != CORNER_NONE && dir.dot(other.dir) >= min_cos;
+	}
+};
+
 struct Match {
 	cv::Point3d obj;
 	cv::Point2d obj_px;
 	cv::Point2d measurement;
+	int detected_index; // the detected corner of the measurement or -1
+	CornerLabel label; // of the model corner
+	bool compatible; // the labels of the model corner and the measurement agree
 	double pixelNorm;
 
 	Match() {
+		detected_index = -1;
+		compatible = true;
 		pixelNorm = -1;
 	}
 
@@ -49,10 +85,10 @@ struct Match {
 struct Matches {
 	std::vector<Match> matches;
 
-	cv::Mat draw(cv::Mat in) {
+	cv::Mat draw(cv::Mat in, double max_norm) {
 		for (auto e : matches) {
 #if USE_MAX_NORM
-			if (e.computePixelNorm() > MAX_NORM) {
+			if (e.computePixelNorm() > max_norm) {
 				cv::line(in, e.obj_px, e.measurement, cv::Scalar(255, 0, 255));
 			} else {
 #endif
@@ -70,7 +106,7 @@ struct Matches {
 		return in;
 	}
 
-	cv::Mat draw(cv::Mat in, std::vector<cv::Point2f> detect) {
+	cv::Mat draw(cv::Mat in, std::vector<cv::Point2f> detect, double max_norm) {
 		for (auto e : detect) {
 			cv::drawMarker(in, e, cv::Scalar(255, 0, 0), cv::MARKER_DIAMOND, 4);
 		}
@@ -82,7 +118,7 @@ struct Matches {
 
 			//ROS_DEBUG_STREAM(e.pixelNorm);
 
-			if (e.pixelNorm > MAX_NORM) {
+			if (e.pixelNorm > max_norm) {
 				//ROS_DEBUG_STREAM(e.computePixelNorm());
 				//ROS_DEBUG_STREAM("skipping norm: " << e.computePixelNorm());
 				cv::line(in, e.obj_px, e.measurement, cv::Scalar(0, 255, 255));
@@ -156,7 +192,7 @@ struct Matches {
 
 		for (auto e : matches) {
 			ROS_ASSERT(e.pixelNorm != -1);
-			if (e.pixelNorm <= max_norm) {
+			if (e.pixelNorm <= max_norm && e.compatible) {
 				//ROS_DEBUG_STREAM("adding norm: " << e.pixelNorm);
 
 				out.matches.push_back(e);
@@ -168,135 +204,87 @@ struct Matches {
 
 };
 
+/*
+ * the best estimate of the base pose and its motion. backed by an error state kalman filter which
+ * fuses vo, grid alignments and the imu
+ */
 struct DipaState {
 
 private:
-	tf::Vector3 omega; // rad/s
-	tf::Vector3 vel; // m/s in base frame
-
-	tf::Transform current_best_w2b;
-	ros::Time current_best_t;
-
-	tf::Transform last_best_w2b;
-	ros::Time last_best_t;
+	PoseFilter filter;
 
-	bool twist_set;
-	bool current_pose_set;
-	bool last_pose_set;
 public:
 
 	DipaState() {
-		twist_set = false;
-		current_pose_set = false;
-		last_pose_set = false;
 	}
 
+	/*
+	 * a grid alignment or realignment. the stamp may be older than the latest vo pose
+	 */
 	void manualPoseUpdate(tf::Transform trans, ros::Time t)
 	{
-		current_best_t = t;
-		current_best_w2b = trans;
-		current_pose_set = true;
+		filter.addAbsolutePose(trans, t, EKF_MANUAL_POSITION_SIGMA, EKF_MANUAL_ROTATION_SIGMA);
 	}
 
-	void updatePose(tf::Transform trans, ros::Time t) {
-		if (current_pose_set) // we can now set the last pose
-		{
-			last_pose_set = true;
-			last_best_t = current_best_t;
-			last_best_w2b = current_best_w2b;
-		}
-
-		current_best_t = t;
-		current_best_w2b = trans;
-
-		if (current_pose_set && last_pose_set && last_best_t != ros::Time(0)) // make sure that the last pose has a valid time
-		{
-			//numerically derive the velocities
-			tf::Transform delta = last_best_w2b.inverse() * current_best_w2b;
-
-			double dt = (current_best_t - last_best_t).toSec();
-
-			ROS_DEBUG_STREAM("deriving twist with dt: " << dt);
-			//ROS_ASSERT(dt > 0);
-			if(dt <= 0)
-			{
-				ROS_WARN_STREAM("can't derive twist with dt: " << dt);
-			}
-			else
-			{
-
-				double r, p, y;
-				delta.getBasis().getRPY(r, p, y);
-				omega.setX(r);
-				omega.setY(p);
-				omega.setZ(y);
-				omega /= dt;
-
-				vel = (delta.getOrigin())
-									/ dt; // this transforms the delta into the base frame
-
-				ROS_DEBUG_STREAM("DERIVED TWIST vel: " << vel.x() << ", " << vel.y() << ", " << vel.z() << "\n omega: " << omega.x() << ", " << omega.y() << ", " << omega.z());
+	/*
+	 * drops the filter's history and motion. used when the old track is no longer trusted
+	 */
+	void resetPose(tf::Transform trans, ros::Time t)
+	{
+		filter.reset(trans, t);
+	}
 
-				twist_set = true;
-			}
-		}
+	void updatePose(tf::Transform trans, ros::Time t) {
+		filter.addVO(trans, t);
+	}
 
-		current_pose_set = true;
+	/*
+	 * omega is the angular rate in the base frame in rad/s
+	 */
+	void addImu(tf::Vector3 omega, ros::Time t)
+	{
+		filter.addGyro(omega, t);
 	}
 
 	tf::Transform predict(ros::Time new_t) {
-		ROS_ASSERT(twist_set && current_pose_set);
-
-		//if the current best time is invalid just return the current best pose
-		if (current_best_t == ros::Time(0)) {
-			return current_best_w2b;
-		}
-
-		double dt = (new_t - current_best_t).toSec();
-
-		ROS_DEBUG_STREAM("dt: " << dt);
+		ROS_ASSERT(filter.initialized());
 
-		ROS_ASSERT(dt > 0);
-
-		ROS_DEBUG_STREAM("predicting with vel: " << vel.x() << ", " << vel.y() << ", " << vel.z() << "\n omega: " << omega.x() << ", " << omega.y() << ", " << omega.z());
-
-		//form update transform
-		tf::Transform delta;
-
-		tf::Vector3 dtheta = omega * dt;
-
-		tf::Matrix3x3 rot;
-		rot.setRPY(dtheta.x(), dtheta.y(), dtheta.z());
+		return filter.predict(new_t);
+	}
 
-		delta.setBasis(rot);
+	/*
+	 * age is the time in seconds the pose was extrapolated over
+	 */
+	tf::Transform predict(ros::Time new_t, double& age) {
+		ROS_ASSERT(filter.initialized());
 
-		delta.setOrigin((vel * dt)); //creates a base frame delta then transforms it into the world frame
+		ros::Time from;
+		tf::Transform pose = filter.predict(new_t, from);
+		age = (new_t - from).toSec();
 
-		return current_best_w2b * delta; // convolve the current best pose estimate
+		return pose;
 	}
 
 	bool currentPoseSet() {
-		return current_pose_set;
+		return filter.initialized();
 	}
 	bool twistSet() {
-		return twist_set;
+		return filter.motionKnown();
 	}
 
 	tf::Transform getCurrentBestPose() {
-		ROS_ASSERT(current_pose_set);
-		return current_best_w2b;
+		ROS_ASSERT(filter.initialized());
+		return filter.getPose();
 	}
 	ros::Time getCurrentBestPoseStamp() {
-		ROS_ASSERT(current_pose_set);
-		return current_best_t;
+		ROS_ASSERT(filter.initialized());
+		return filter.getStamp();
 	}
 	tf::Vector3 getBaseFrameVelocity() {
-		ROS_ASSERT(twist_set);
-		return vel;
+		return filter.getBaseFrameVelocity();
 	}
 	tf::Vector3 getBaseFrameOmega() {
-		ROS_ASSERT(twist_set);
-		return omega;
+		return filter.getBaseFrameOmega();
 	}
 
 };
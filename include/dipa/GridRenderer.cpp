@@ -28,6 +28,24 @@ GridRenderer::~GridRenderer() {
 
 }
 
+void GridRenderer::setGrid(int width, int height, double spacing)
+{
+	if(width == grid_width && height == grid_height && spacing == grid_spacing)
+	{
+		return;
+	}
+
+	grid_width = width;
+	grid_height = height;
+	grid_spacing = spacing;
+
+	grid.clear();
+	grid_corners.clear();
+	grid_corner_labels.clear();
+
+	generateGrid();
+}
+
 void GridRenderer::setColors(cv::Vec3b w, cv::Vec3b g, cv::Vec3b r)
 {
 	WHITE = w;
@@ -81,17 +99,17 @@ void GridRenderer::generateGrid()
 
 		if(line != 0 && line != grid_width)
 		{
-			q.vertices.push_back(cv::Point2f( x - ilt, maxY));
-			q.vertices.push_back(cv::Point2f( x + ilt, maxY));
-			q.vertices.push_back(cv::Point2f( x + ilt, minY));
-			q.vertices.push_back(cv::Point2f( x - ilt, minY));
+			q.vertices.push_back(cv::Point2f( x - ilt / 2.0, maxY));
+			q.vertices.push_back(cv::Point2f( x + ilt / 2.0, maxY));
+			q.vertices.push_back(cv::Point2f( x + ilt / 2.0, minY));
+			q.vertices.push_back(cv::Point2f( x - ilt / 2.0, minY));
 		}
 		else
 		{
-			q.vertices.push_back(cv::Point2f( x - olt, maxY));
-			q.vertices.push_back(cv::Point2f( x + olt, maxY));
-			q.vertices.push_back(cv::Point2f( x + olt, minY));
-			q.vertices.push_back(cv::Point2f( x - olt, minY));
+			q.vertices.push_back(cv::Point2f( x - olt / 2.0, maxY));
+			q.vertices.push_back(cv::Point2f( x + olt / 2.0, maxY));
+			q.vertices.push_back(cv::Point2f( x + olt / 2.0, minY));
+			q.vertices.push_back(cv::Point2f( x - olt / 2.0, minY));
 		}
 
 		ROS_DEBUG_STREAM("front size: " << grid.front().vertices.size());
@@ -111,17 +129,17 @@ void GridRenderer::generateGrid()
 
 		if(line != 0 && line != grid_height)
 		{
-			q.vertices.push_back(cv::Point2f(maxX, y - ilt));
-			q.vertices.push_back(cv::Point2f(maxX, y + ilt));
-			q.vertices.push_back(cv::Point2f(minX, y + ilt));
-			q.vertices.push_back(cv::Point2f(minX, y - ilt));
+			q.vertices.push_back(cv::Point2f(maxX, y - ilt / 2.0));
+			q.vertices.push_back(cv::Point2f(maxX, y + ilt / 2.0));
+			q.vertices.push_back(cv::Point2f(minX, y + ilt / 2.0));
+			q.vertices.push_back(cv::Point2f(minX, y - ilt / 2.0));
 		}
 		else
 		{
-			q.vertices.push_back(cv::Point2f(maxX, y - olt));
-			q.vertices.push_back(cv::Point2f(maxX, y + olt));
-			q.vertices.push_back(cv::Point2f(minX, y + olt));
-			q.vertices.push_back(cv::Point2f(minX, y - olt));
+			q.vertices.push_back(cv::Point2f(maxX, y - olt / 2.0));
+			q.vertices.push_back(cv::Point2f(maxX, y + olt / 2.0));
+			q.vertices.push_back(cv::Point2f(minX, y + olt / 2.0));
+			q.vertices.push_back(cv::Point2f(minX, y - olt / 2.0));
 		}
 
 		grid.push_front(q);
@@ -213,6 +231,42 @@ void GridRenderer::generateGrid()
 		x_line++;
 	}
 
+	labelGridCorners();
+}
+
+/*
+ * every corner sits diagonally off the center of its crossing. the odd quadrant of an inner corner
+ * points away from the crossing and the one of an outer corner points back into the grid
+ */
+void GridRenderer::labelGridCorners()
+{
+	double minX = -(grid_width * grid_spacing / 2);
+	double maxX = (grid_width * grid_spacing / 2);
+	double minY = -(grid_height * grid_spacing / 2);
+	double maxY = (grid_height * grid_spacing / 2);
+
+	grid_corner_labels.clear();
+
+	for(auto& e : grid_corners)
+	{
+		double cx = minX + round((e.x() - minX) / grid_spacing) * grid_spacing;
+		double cy = minY + round((e.y() - minY) / grid_spacing) * grid_spacing;
+
+		CornerLabel l;
+		l.dir = cv::Point2f((e.x() > cx) ? 1 : -1, (e.y() > cy) ? 1 : -1);
+
+		if((e.x() < minX || e.x() > maxX) && (e.y() < minY || e.y() > maxY))
+		{
+			l.type = CORNER_OUTER;
+			l.dir = -l.dir;
+		}
+		else
+		{
+			l.type = CORNER_INNER;
+		}
+
+		grid_corner_labels.push_back(l);
+	}
 }
 
 cv::Mat GridRenderer::computeHomography()
@@ -317,8 +371,10 @@ cv::Mat GridRenderer::drawCorners(cv::Mat in, std::vector<cv::Point2f> corners)
 Matches GridRenderer::renderGridCorners()
 {
 	Matches matches;
-	for(auto e : grid_corners)
+	for(int i = 0; i < grid_corners.size(); i++)
 	{
+		const tf::Vector3& e = grid_corners[i];
+
 		bool good = false;
 		cv::Point2f px = this->projectPoint(e, good);
 		if(good)
@@ -326,6 +382,19 @@ Matches GridRenderer::renderGridCorners()
 			Match m;
 			m.obj = cv::Point3d(e.x(), e.y(), e.z());
 			m.obj_px = px;
+
+			// move the odd quadrant direction into the image
+			const CornerLabel& l = grid_corner_labels[i];
+			bool dir_good = false;
+			cv::Point2f d = this->projectPoint(e + tf::Vector3(l.dir.x, l.dir.y, 0) * inner_line_thickness, dir_good) - px;
+			double len = sqrt(d.dot(d));
+
+			if(dir_good && len > 0)
+			{
+				m.label.type = l.type;
+				m.label.dir = d * (1.0 / len);
+			}
+
 			matches.matches.push_back(m);
 		}
 	}
@@ -333,6 +402,186 @@ Matches GridRenderer::renderGridCorners()
 	return matches;
 }
 
+/*
+ * clips the segment a b to the rectangle [0, w] x [0, h]. returns false if it is outside
+ */
+static bool clipSegment(cv::Point2f& a, cv::Point2f& b, float w, float h)
+{
+	float t0 = 0, t1 = 1;
+	float dx = b.x - a.x, dy = b.y - a.y;
+
+	float p[4] = {-dx, dx, -dy, dy};
+	float q[4] = {a.x, w - a.x, a.y, h - a.y};
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(p[i] == 0)
+		{
+			if(q[i] < 0){return false;}
+			continue;
+		}
+
+		float t = q[i] / p[i];
+		if(p[i] < 0){t0 = std::max(t0, t);}
+		else{t1 = std::min(t1, t);}
+
+		if(t0 > t1){return false;}
+	}
+
+	cv::Point2f start = a;
+	a = start + t0 * cv::Point2f(dx, dy);
+	b = start + t1 * cv::Point2f(dx, dy);
+
+	return true;
+}
+
+/*
+ * projects the plane segment ab and clips it to the image. false if no part of it is visible
+ */
+bool GridRenderer::renderLine(tf::Vector3 a, tf::Vector3 b, Line& l)
+{
+	const double near = 1e-3;
+
+	tf::Vector3 ca = this->c2w * a;
+	tf::Vector3 cb = this->c2w * b;
+
+	// keep the part in front of the camera
+	if(ca.z() < near && cb.z() < near){return false;}
+	if(ca.z() < near){ca = ca + (cb - ca) * ((near - ca.z()) / (cb.z() - ca.z()));}
+	if(cb.z() < near){cb = cb + (ca - cb) * ((near - cb.z()) / (ca.z() - cb.z()));}
+
+	l.a = a;
+	l.b = b;
+	l.pa = cv::Point2f(this->K(0) * (ca.x()/ca.z()) + this->K(2), this->K(4) * (ca.y()/ca.z()) + this->K(5));
+	l.pb = cv::Point2f(this->K(0) * (cb.x()/cb.z()) + this->K(2), this->K(4) * (cb.y()/cb.z()) + this->K(5));
+
+	if(!clipSegment(l.pa, l.pb, this->size.width, this->size.height))
+	{
+		return false;
+	}
+
+	cv::Point2f d = l.pb - l.pa;
+	if(d.x * d.x + d.y * d.y < 1)
+	{
+		return false;
+	}
+
+	double theta = atan2(d.x, -d.y);
+	if(theta < 0){theta += CV_PI;}
+	if(theta >= CV_PI){theta -= CV_PI;}
+
+	l.line = cv::Vec2f(cos(theta) * l.pa.x + sin(theta) * l.pa.y, theta);
+
+	return true;
+}
+
+std::vector<GridRenderer::Line> GridRenderer::renderGridLines()
+{
+	std::vector<Line> lines;
+
+	double minX = -(grid_width * grid_spacing / 2);
+	double maxX = (grid_width * grid_spacing / 2);
+	double minY = -(grid_height * grid_spacing / 2);
+	double maxY = (grid_height * grid_spacing / 2);
+
+	Line l;
+
+	for(int i = 0; i <= grid_width; i++)
+	{
+		double x = minX + i * grid_spacing;
+		if(renderLine(tf::Vector3(x, minY, 0), tf::Vector3(x, maxY, 0), l)){lines.push_back(l);}
+	}
+
+	for(int j = 0; j <= grid_height; j++)
+	{
+		double y = minY + j * grid_spacing;
+		if(renderLine(tf::Vector3(minX, y, 0), tf::Vector3(maxX, y, 0), l)){lines.push_back(l);}
+	}
+
+	return lines;
+}
+
+/*
+ * the edges are half a line thickness to either side of the center line like the grid corners
+ */
+std::vector<GridRenderer::Line> GridRenderer::renderGridEdges()
+{
+	std::vector<Line> lines;
+
+	double minX = -(grid_width * grid_spacing / 2);
+	double maxX = (grid_width * grid_spacing / 2);
+	double minY = -(grid_height * grid_spacing / 2);
+	double maxY = (grid_height * grid_spacing / 2);
+
+	Line l;
+
+	for(int i = 0; i <= grid_width; i++)
+	{
+		double x = minX + i * grid_spacing;
+		double h = ((i == 0 || i == grid_width) ? outer_line_thickness : inner_line_thickness) / 2.0;
+
+		if(renderLine(tf::Vector3(x - h, minY, 0), tf::Vector3(x - h, maxY, 0), l)){lines.push_back(l);}
+		if(renderLine(tf::Vector3(x + h, minY, 0), tf::Vector3(x + h, maxY, 0), l)){lines.push_back(l);}
+	}
+
+	for(int j = 0; j <= grid_height; j++)
+	{
+		double y = minY + j * grid_spacing;
+		double h = ((j == 0 || j == grid_height) ? outer_line_thickness : inner_line_thickness) / 2.0;
+
+		if(renderLine(tf::Vector3(minX, y - h, 0), tf::Vector3(maxX, y - h, 0), l)){lines.push_back(l);}
+		if(renderLine(tf::Vector3(minX, y + h, 0), tf::Vector3(maxX, y + h, 0), l)){lines.push_back(l);}
+	}
+
+	return lines;
+}
+
+/*
+ * the samples sit between the crossings because the edges of a line are broken where the other
+ * direction crosses it
+ */
+std::vector<cv::Point2d> GridRenderer::sampleGridEdges(int samples_per_cell)
+{
+	std::vector<cv::Point2d> pts;
+
+	double minX = -(grid_width * grid_spacing / 2);
+	double minY = -(grid_height * grid_spacing / 2);
+	double step = grid_spacing / samples_per_cell;
+
+	int nx = grid_width * samples_per_cell;
+	int ny = grid_height * samples_per_cell;
+
+	pts.reserve(2 * ((grid_width + 1) * ny + (grid_height + 1) * nx));
+
+	for(int i = 0; i <= grid_width; i++)
+	{
+		double x = minX + i * grid_spacing;
+		double h = ((i == 0 || i == grid_width) ? outer_line_thickness : inner_line_thickness) / 2.0;
+
+		for(int k = 0; k < ny; k++)
+		{
+			double y = minY + (k + 0.5) * step;
+			pts.push_back(cv::Point2d(x - h, y));
+			pts.push_back(cv::Point2d(x + h, y));
+		}
+	}
+
+	for(int j = 0; j <= grid_height; j++)
+	{
+		double y = minY + j * grid_spacing;
+		double h = ((j == 0 || j == grid_height) ? outer_line_thickness : inner_line_thickness) / 2.0;
+
+		for(int k = 0; k < nx; k++)
+		{
+			double x = minX + (k + 0.5) * step;
+			pts.push_back(cv::Point2d(x, y - h));
+			pts.push_back(cv::Point2d(x, y + h));
+		}
+	}
+
+	return pts;
+}
+
 cv::Mat GridRenderer::renderGridByProjection()
 {
 	cv::Mat result = cv::Mat(size, CV_8UC3);
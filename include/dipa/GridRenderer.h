@@ -69,6 +69,9 @@ private:
 
 	std::deque<Quad> grid;
 	std::vector<tf::Vector3> grid_corners;
+	std::vector<CornerLabel> grid_corner_labels; // the odd quadrant as a direction on the plane
+
+	void labelGridCorners();
 
 	int grid_width;
 	int grid_height;
@@ -90,6 +93,13 @@ private:
 public:
 	cv::Mat sourceRender;
 
+	// a line on the plane and its visible part in the image
+	struct Line{
+		tf::Vector3 a, b; // world end points
+		cv::Point2f pa, pb; // image end points clipped to the image
+		cv::Vec2f line; // (rho, theta) like cv::HoughLines
+	};
+
 	GridRenderer();
 	virtual ~GridRenderer();
 
@@ -115,6 +125,11 @@ public:
 
 	void generateGrid();
 
+	/*
+	 * replaces the grid dimensions and regenerates it
+	 */
+	void setGrid(int width, int height, double spacing);
+
 	void setColors(cv::Vec3b w, cv::Vec3b g, cv::Vec3b r);
 
 	tf::Vector3 project2XYPlane(cv::Mat_<float> dir, bool& behind);
@@ -126,10 +141,29 @@ public:
 
 	Matches renderGridCorners();
 
+	/*
+	 * projects the center line of every grid line and keeps the ones which cross the image
+	 */
+	std::vector<Line> renderGridLines();
+
+	/*
+	 * projects both edges of every grid line. these are what an edge detector sees
+	 */
+	std::vector<Line> renderGridEdges();
+
+	/*
+	 * plane xy of points spaced evenly along both edges of every grid line
+	 */
+	std::vector<cv::Point2d> sampleGridEdges(int samples_per_cell);
+
 	void renderSourceImage();
 
 	cv::Mat computeHomography();
 
+private:
+
+	bool renderLine(tf::Vector3 a, tf::Vector3 b, Line& l);
+
 };
 
 #endif /* MANTIS_INCLUDE_MANTIS3_GRIDRENDERER_H_ */
@@ -0,0 +1,125 @@
+/*
+ * InsightPublisher.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/InsightPublisher.h>
+
+InsightPublisher::InsightPublisher() {
+	running = false;
+}
+
+InsightPublisher::~InsightPublisher() {
+	this->stop();
+}
+
+void InsightPublisher::start(ros::NodeHandle& nh)
+{
+	this->insight_pub = nh.advertise<sensor_msgs::Image>(INSIGHT_TOPIC, 1);
+
+	this->running = true;
+	this->worker = std::thread(&InsightPublisher::loop, this);
+}
+
+void InsightPublisher::stop()
+{
+	this->running = false;
+
+	if(this->worker.joinable())
+	{
+		this->worker.join();
+	}
+}
+
+bool InsightPublisher::wanted()
+{
+	if(!this->running || this->insight_pub.getNumSubscribers() == 0)
+	{
+		return false;
+	}
+
+	ros::WallTime now = ros::WallTime::now();
+
+	if((now - this->last_snapshot).toSec() < 1.0 / INSIGHT_RATE)
+	{
+		return false;
+	}
+
+	this->last_snapshot = now;
+	return true;
+}
+
+void InsightPublisher::post(std::unique_ptr<Snapshot> snap)
+{
+	this->mailbox.post(std::move(snap));
+}
+
+void InsightPublisher::loop()
+{
+	while(this->running && ros::ok())
+	{
+		std::unique_ptr<Snapshot> snap = this->mailbox.waitAndTake(0.1);
+
+		if(!snap)
+		{
+			continue;
+		}
+
+		cv_bridge::CvImage cv_img;
+
+		cv_img.image = this->draw(*snap);
+		cv_img.header.stamp = snap->stamp;
+		cv_img.header.frame_id = CAMERA_FRAME;
+		cv_img.encoding = sensor_msgs::image_encodings::BGR8;
+
+		this->insight_pub.publish(cv_img.toImageMsg());
+		ROS_DEBUG("end publish");
+	}
+}
+
+cv::Mat InsightPublisher::draw(const Snapshot& snap)
+{
+	cv::Mat src;
+
+	cv::cvtColor(snap.img, src, CV_GRAY2BGR);
+
+	for(auto e : snap.detected_corners)
+	{
+		cv::drawMarker(src, e, cv::Scalar(255, 0, 0), cv::MARKER_DIAMOND, 4);
+	}
+
+	for(auto e : snap.features){
+		cv::drawMarker(src, e, cv::Scalar(255, 0, 255), cv::MARKER_SQUARE, 6);
+	}
+
+	ROS_DEBUG_STREAM("rendering grid");
+	this->renderer.setGrid(snap.grid_width, snap.grid_height, snap.grid_spacing); // no op unless the grid changed
+	this->renderer.setIntrinsic(snap.K);
+	this->renderer.setSize(snap.size);
+	this->renderer.setW2C(snap.w2c); // render the grid with the current w2c
+	Matches m = this->renderer.renderGridCorners();
+
+	ROS_DEBUG_STREAM("rendering grid corners with " << m.matches.size() << "corners");
+	if(m.matches.size() > 0)
+	{
+		//draw
+		for(auto e : m.matches){
+			if(snap.grid_aligned)
+			{
+				cv::drawMarker(src, e.obj_px, cv::Scalar(0, 255, 0), cv::MARKER_CROSS, 8);
+			}
+			else
+			{
+				cv::drawMarker(src, e.obj_px, cv::Scalar(0, 0, 255), cv::MARKER_CROSS, 8);
+			}
+		}
+	}
+	else
+	{
+		ROS_WARN("there are no projected grid corners for the current estimate.");
+	}
+
+	return src;
+}
@@ -0,0 +1,88 @@
+/*
+ * InsightPublisher.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_INSIGHTPUBLISHER_H_
+#define DIPA_INCLUDE_DIPA_INSIGHTPUBLISHER_H_
+
+#include <ros/ros.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgproc/types_c.h>
+
+#include <tf/tf.h>
+
+#include "sensor_msgs/Image.h"
+#include <sensor_msgs/image_encodings.h>
+#include <cv_bridge/cv_bridge.h>
+
+#include <thread>
+#include <atomic>
+
+#include <dipa/DipaParams.h>
+
+#include <dipa/GridRenderer.h>
+
+#include <dipa/Mailbox.h>
+
+/*
+ * draws and publishes the insight image on its own thread.
+ *
+ * the processing thread only copies the little state needed to draw a frame into a snapshot and
+ * only when somebody is subscribed and the rate limit allows it.
+ */
+class InsightPublisher {
+public:
+
+	struct Snapshot{
+		cv::Mat img; // the scaled gray frame. frames are never written after they are scaled so this is shared
+		std::vector<cv::Point2f> detected_corners;
+		std::vector<cv::Point2f> features;
+		tf::Transform w2c;
+		cv::Mat_<float> K;
+		cv::Size size;
+		int grid_width; // the grid the frame was aligned to
+		int grid_height;
+		double grid_spacing;
+		bool grid_aligned;
+		ros::Time stamp;
+	};
+
+	InsightPublisher();
+	virtual ~InsightPublisher();
+
+	void start(ros::NodeHandle& nh);
+
+	void stop();
+
+	/*
+	 * true if a snapshot should be taken for this frame
+	 */
+	bool wanted();
+
+	void post(std::unique_ptr<Snapshot> snap);
+
+private:
+
+	ros::Publisher insight_pub;
+
+	// the drawing thread has its own renderer so it never touches the one used for alignment.
+	// it follows the grid of the snapshots
+	GridRenderer renderer;
+
+	Mailbox<Snapshot> mailbox;
+
+	std::thread worker;
+	std::atomic<bool> running;
+
+	ros::WallTime last_snapshot;
+
+	void loop();
+
+	cv::Mat draw(const Snapshot& snap);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_INSIGHTPUBLISHER_H_ */
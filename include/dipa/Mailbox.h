@@ -0,0 +1,96 @@
+/*
+ * Mailbox.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_MAILBOX_H_
+#define DIPA_INCLUDE_DIPA_MAILBOX_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+/*
+ * single slot mailbox where the latest item wins.
+ *
+ * posting and taking are a single atomic exchange of the slot so the producer never waits on the
+ * consumer. an item which is replaced before it was taken is destroyed and counted as overwritten.
+ * the mutex is only used to wake a sleeping consumer and never guards the slot.
+ */
+template<class T>
+class Mailbox {
+public:
+
+	Mailbox() : slot(nullptr), overwritten(0) {}
+
+	~Mailbox()
+	{
+		delete slot.exchange(nullptr);
+	}
+
+	/*
+	 * puts the item in the slot. returns true if an item which was never taken was replaced
+	 */
+	bool post(std::unique_ptr<T> item)
+	{
+		std::unique_ptr<T> old(slot.exchange(item.release(), std::memory_order_acq_rel));
+
+		bool replaced = (old != nullptr);
+		if(replaced)
+		{
+			overwritten++;
+		}
+
+		{
+			// makes sure a consumer which just found the slot empty is already waiting
+			std::lock_guard<std::mutex> lock(wake_mutex);
+		}
+		wake.notify_one();
+
+		return replaced;
+	}
+
+	/*
+	 * takes the item out of the slot. returns null if there is none
+	 */
+	std::unique_ptr<T> take()
+	{
+		return std::unique_ptr<T>(slot.exchange(nullptr, std::memory_order_acq_rel));
+	}
+
+	/*
+	 * takes the item out of the slot, sleeping up to timeout seconds for one to arrive
+	 */
+	std::unique_ptr<T> waitAndTake(double timeout)
+	{
+		std::unique_ptr<T> item = take();
+		if(item)
+		{
+			return item;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake.wait_for(lock, std::chrono::duration<double>(timeout), [this]{return slot.load(std::memory_order_acquire) != nullptr;});
+		lock.unlock();
+
+		return take();
+	}
+
+	uint32_t getOverwrittenCount()
+	{
+		return overwritten.load();
+	}
+
+private:
+	std::atomic<T*> slot;
+	std::atomic<uint32_t> overwritten;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+};
+
+#endif /* DIPA_INCLUDE_DIPA_MAILBOX_H_ */
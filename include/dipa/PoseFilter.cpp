@@ -0,0 +1,395 @@
+/*
+ * PoseFilter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/PoseFilter.h>
+
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+#include <algorithm>
+
+PoseFilter::PoseFilter() {
+	is_initialized = false;
+	last_vo_set = false;
+	state.motion_known = false;
+}
+
+PoseFilter::~PoseFilter() {
+
+}
+
+void PoseFilter::reset(tf::Transform w2b, ros::Time t)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->state.R = toMatx(w2b.getBasis());
+	this->state.p = cv::Vec3d(w2b.getOrigin().x(), w2b.getOrigin().y(), w2b.getOrigin().z());
+	this->state.v = cv::Vec3d(0, 0, 0);
+	this->state.w = cv::Vec3d(0, 0, 0);
+	this->state.t = t;
+	this->state.motion_known = false;
+
+	this->state.P = Matx1212d::zeros();
+	for(int i = 0; i < 3; i++)
+	{
+		this->state.P(i, i) = EKF_INITIAL_ROTATION_SIGMA * EKF_INITIAL_ROTATION_SIGMA;
+		this->state.P(3 + i, 3 + i) = EKF_INITIAL_POSITION_SIGMA * EKF_INITIAL_POSITION_SIGMA;
+		this->state.P(6 + i, 6 + i) = EKF_INITIAL_VELOCITY_SIGMA * EKF_INITIAL_VELOCITY_SIGMA;
+		this->state.P(9 + i, 9 + i) = EKF_INITIAL_OMEGA_SIGMA * EKF_INITIAL_OMEGA_SIGMA;
+	}
+
+	this->history.clear();
+
+	this->last_vo = w2b;
+	this->last_vo_t = t;
+	this->last_vo_set = true;
+
+	this->is_initialized = true;
+}
+
+void PoseFilter::addVO(tf::Transform w2b, ros::Time t)
+{
+	if(!this->initialized())
+	{
+		this->reset(w2b, t);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	Measurement m;
+	m.type = Measurement::VO;
+	m.t = t;
+	m.R = toMatx(w2b.getBasis());
+	m.p = cv::Vec3d(w2b.getOrigin().x(), w2b.getOrigin().y(), w2b.getOrigin().z());
+	m.sigma_position = EKF_VO_POSITION_SIGMA;
+	m.sigma_rotation = EKF_VO_ROTATION_SIGMA;
+	m.has_motion = false;
+
+	//the increment from the last vo pose measures the motion
+	double dt = (t - this->last_vo_t).toSec();
+	if(this->last_vo_set && this->last_vo_t != ros::Time(0) && dt > 0)
+	{
+		tf::Transform delta = this->last_vo.inverse() * w2b;
+
+		m.v = (m.p - cv::Vec3d(this->last_vo.getOrigin().x(), this->last_vo.getOrigin().y(), this->last_vo.getOrigin().z())) * (1.0 / dt);
+		m.w = PlanarPoseSolver::logSO3(toMatx(delta.getBasis())) * (1.0 / dt);
+		m.sigma_v = EKF_VO_INCREMENT_POSITION_SIGMA / dt;
+		m.sigma_w = EKF_VO_INCREMENT_ROTATION_SIGMA / dt;
+		m.has_motion = true;
+	}
+	else if(dt <= 0)
+	{
+		ROS_WARN_STREAM("can't derive the vo increment with dt: " << dt);
+	}
+
+	this->last_vo = w2b;
+	this->last_vo_t = t;
+	this->last_vo_set = true;
+
+	this->insert(m);
+}
+
+void PoseFilter::addAbsolutePose(tf::Transform w2b, ros::Time t, double sigma_position, double sigma_rotation)
+{
+	if(!this->initialized())
+	{
+		this->reset(w2b, t);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	Measurement m;
+	m.type = Measurement::POSE;
+	m.t = t;
+	m.R = toMatx(w2b.getBasis());
+	m.p = cv::Vec3d(w2b.getOrigin().x(), w2b.getOrigin().y(), w2b.getOrigin().z());
+	m.sigma_position = sigma_position;
+	m.sigma_rotation = sigma_rotation;
+	m.has_motion = false;
+
+	//vo continues from this pose so the next increment is taken from here
+	this->last_vo = w2b;
+	this->last_vo_t = std::max(t, this->last_vo_t);
+	this->last_vo_set = true;
+
+	this->insert(m);
+}
+
+void PoseFilter::addGyro(tf::Vector3 omega, ros::Time t)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	if(!this->is_initialized)
+	{
+		return;
+	}
+
+	Measurement m;
+	m.type = Measurement::GYRO;
+	m.t = t;
+	m.has_motion = true;
+	m.w = cv::Vec3d(omega.x(), omega.y(), omega.z());
+	m.sigma_w = EKF_GYRO_SIGMA;
+
+	this->insert(m);
+}
+
+bool PoseFilter::initialized()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->is_initialized;
+}
+
+bool PoseFilter::motionKnown()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->state.motion_known;
+}
+
+tf::Transform PoseFilter::getPose()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return toTransform(this->state.R, this->state.p);
+}
+
+ros::Time PoseFilter::getStamp()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->state.t;
+}
+
+tf::Transform PoseFilter::predict(ros::Time t)
+{
+	ros::Time from;
+	return this->predict(t, from);
+}
+
+tf::Transform PoseFilter::predict(ros::Time t, ros::Time& from)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	State s = this->state;
+
+	// the imu moves the filter past the frames. a stamp behind it starts from the posterior it had then
+	if(t < s.t)
+	{
+		for(int i = this->history.size() - 1; i >= 0; i--)
+		{
+			if(this->history[i].second.t <= t)
+			{
+				s = this->history[i].second;
+				break;
+			}
+		}
+	}
+
+	from = s.t;
+
+	if(s.t == ros::Time(0))
+	{
+		return toTransform(s.R, s.p);
+	}
+
+	propagate(s, t);
+
+	return toTransform(s.R, s.p);
+}
+
+tf::Vector3 PoseFilter::getBaseFrameVelocity()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	cv::Vec3d v = this->state.R.t() * this->state.v;
+	return tf::Vector3(v[0], v[1], v[2]);
+}
+
+tf::Vector3 PoseFilter::getBaseFrameOmega()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return tf::Vector3(this->state.w[0], this->state.w[1], this->state.w[2]);
+}
+
+/*
+ * must be called with the mutex held
+ */
+void PoseFilter::insert(const Measurement& m)
+{
+	if(this->history.empty() || m.t >= this->history.back().first.t)
+	{
+		apply(this->state, m);
+		this->history.push_back(std::make_pair(m, this->state));
+	}
+	else
+	{
+		// find the last measurement which is not newer than m
+		int i = this->history.size() - 1;
+		while(i >= 0 && this->history[i].first.t > m.t)
+		{
+			i--;
+		}
+
+		if(i < 0)
+		{
+			ROS_WARN_STREAM("dropping a measurement which is " << (this->history.front().first.t - m.t).toSec() << " seconds older than the filter history");
+			return;
+		}
+
+		ROS_DEBUG_STREAM("replaying " << this->history.size() - 1 - i << " measurements after an out of order measurement");
+
+		std::vector<Measurement> later;
+		for(int j = i + 1; j < this->history.size(); j++)
+		{
+			later.push_back(this->history[j].first);
+		}
+		this->history.resize(i + 1);
+
+		this->state = this->history.back().second;
+
+		apply(this->state, m);
+		this->history.push_back(std::make_pair(m, this->state));
+
+		for(auto& e : later)
+		{
+			apply(this->state, e);
+			this->history.push_back(std::make_pair(e, this->state));
+		}
+	}
+
+	while(this->history.size() > EKF_HISTORY_SIZE)
+	{
+		this->history.pop_front();
+	}
+}
+
+void PoseFilter::propagate(State& s, ros::Time t)
+{
+	if(s.t == ros::Time(0))
+	{
+		s.t = t; // the first pose had no stamp so this is where time starts
+		return;
+	}
+
+	double dt = (t - s.t).toSec();
+
+	if(dt == 0)
+	{
+		return;
+	}
+
+	cv::Matx33d dR = PlanarPoseSolver::expSO3(s.w * dt);
+
+	s.R = s.R * dR;
+	s.p = s.p + s.v * dt;
+
+	Matx1212d F = Matx1212d::eye();
+	for(int i = 0; i < 3; i++)
+	{
+		for(int j = 0; j < 3; j++)
+		{
+			F(i, j) = dR(j, i); // the rotation error is rotated back by the motion
+		}
+		F(i, 9 + i) = dt;
+		F(3 + i, 6 + i) = dt;
+	}
+
+	Matx1212d Q = Matx1212d::zeros();
+	for(int i = 0; i < 3; i++)
+	{
+		Q(6 + i, 6 + i) = EKF_ACCEL_NOISE * EKF_ACCEL_NOISE * fabs(dt);
+		Q(9 + i, 9 + i) = EKF_ANGULAR_ACCEL_NOISE * EKF_ANGULAR_ACCEL_NOISE * fabs(dt);
+	}
+
+	s.P = F * s.P * F.t() + Q;
+	s.t = t;
+}
+
+void PoseFilter::apply(State& s, const Measurement& m)
+{
+	propagate(s, m.t);
+
+	if(m.type == Measurement::GYRO)
+	{
+		cv::Matx<double, 3, 12> H;
+		cv::Matx33d noise;
+		for(int i = 0; i < 3; i++)
+		{
+			H(i, 9 + i) = 1;
+			noise(i, i) = m.sigma_w * m.sigma_w;
+		}
+
+		correct<3>(s, H, cv::Vec3d(m.w - s.w), noise);
+		return;
+	}
+
+	if(m.has_motion)
+	{
+		cv::Matx<double, 6, 12> H;
+		cv::Matx66d noise;
+		cv::Vec<double, 6> r;
+		for(int i = 0; i < 3; i++)
+		{
+			H(i, 6 + i) = 1;
+			H(3 + i, 9 + i) = 1;
+			noise(i, i) = m.sigma_v * m.sigma_v;
+			noise(3 + i, 3 + i) = m.sigma_w * m.sigma_w;
+			r[i] = m.v[i] - s.v[i];
+			r[3 + i] = m.w[i] - s.w[i];
+		}
+
+		correct<6>(s, H, r, noise);
+		s.motion_known = true;
+	}
+
+	cv::Matx<double, 6, 12> H;
+	cv::Matx66d noise;
+	cv::Vec<double, 6> r;
+
+	cv::Vec3d r_rot = PlanarPoseSolver::logSO3(s.R.t() * m.R);
+	for(int i = 0; i < 3; i++)
+	{
+		H(i, i) = 1;
+		H(3 + i, 3 + i) = 1;
+		noise(i, i) = m.sigma_rotation * m.sigma_rotation;
+		noise(3 + i, 3 + i) = m.sigma_position * m.sigma_position;
+		r[i] = r_rot[i];
+		r[3 + i] = m.p[i] - s.p[i];
+	}
+
+	correct<6>(s, H, r, noise);
+}
+
+template<int M>
+void PoseFilter::correct(State& s, const cv::Matx<double, M, 12>& H, const cv::Vec<double, M>& r, const cv::Matx<double, M, M>& noise)
+{
+	cv::Matx<double, 12, M> PHt = s.P * H.t();
+	cv::Matx<double, M, M> S = H * PHt + noise;
+	cv::Matx<double, 12, M> K = PHt * S.inv(cv::DECOMP_CHOLESKY);
+
+	cv::Vec<double, 12> dx = K * r;
+
+	s.R = s.R * PlanarPoseSolver::expSO3(cv::Vec3d(dx[0], dx[1], dx[2]));
+	s.p = s.p + cv::Vec3d(dx[3], dx[4], dx[5]);
+	s.v = s.v + cv::Vec3d(dx[6], dx[7], dx[8]);
+	s.w = s.w + cv::Vec3d(dx[9], dx[10], dx[11]);
+
+	Matx1212d P = (Matx1212d::eye() - K * H) * s.P;
+	s.P = 0.5 * (P + P.t());
+}
+
+cv::Matx33d PoseFilter::toMatx(const tf::Matrix3x3& m)
+{
+	return cv::Matx33d(m.getRow(0).x(), m.getRow(0).y(), m.getRow(0).z(),
+			m.getRow(1).x(), m.getRow(1).y(), m.getRow(1).z(),
+			m.getRow(2).x(), m.getRow(2).y(), m.getRow(2).z());
+}
+
+tf::Transform PoseFilter::toTransform(const cv::Matx33d& R, const cv::Vec3d& p)
+{
+	return tf::Transform(tf::Matrix3x3(R(0, 0), R(0, 1), R(0, 2),
+			R(1, 0), R(1, 1), R(1, 2),
+			R(2, 0), R(2, 1), R(2, 2)), tf::Vector3(p[0], p[1], p[2]));
+}
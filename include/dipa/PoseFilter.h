@@ -0,0 +1,149 @@
+/*
+ * PoseFilter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_POSEFILTER_H_
+#define DIPA_INCLUDE_DIPA_POSEFILTER_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+
+#include <tf/tf.h>
+
+#include <deque>
+#include <mutex>
+
+#include <dipa/DipaParams.h>
+
+/*
+ * error state kalman filter of the base pose, its world frame velocity and its base frame angular rate
+ *
+ * the nominal pose is a rotation and position. the 12 dimensional error state is
+ * [dtheta (base frame), dp, dv, domega] and the motion model is constant velocity and rate driven
+ * by white acceleration noise.
+ *
+ * measurements:
+ * 	vo poses. the increment from the last vo pose is a velocity and rate measurement and the pose
+ * 	itself a loose absolute pose measurement
+ * 	absolute poses from grid alignment or realignment which are tight
+ * 	gyro rates from an optional imu
+ *
+ * every measurement is kept with the posterior it produced. a measurement older than the filter
+ * is applied by restoring the posterior before it and replaying the newer measurements.
+ *
+ * all public methods lock so the imu callback can feed the filter while a frame is processed.
+ */
+class PoseFilter {
+public:
+
+	PoseFilter();
+	virtual ~PoseFilter();
+
+	/*
+	 * forgets everything and starts from this pose with an unknown motion
+	 */
+	void reset(tf::Transform w2b, ros::Time t);
+
+	void addVO(tf::Transform w2b, ros::Time t);
+
+	void addAbsolutePose(tf::Transform w2b, ros::Time t, double sigma_position, double sigma_rotation);
+
+	/*
+	 * omega is the angular rate in the base frame
+	 */
+	void addGyro(tf::Vector3 omega, ros::Time t);
+
+	bool initialized();
+
+	/*
+	 * true once the filter has observed the motion
+	 */
+	bool motionKnown();
+
+	tf::Transform getPose();
+	ros::Time getStamp();
+
+	/*
+	 * extrapolates the pose to t with the motion model without changing the filter.
+	 * a t older than the filter is extrapolated from the newest posterior not newer than t
+	 */
+	tf::Transform predict(ros::Time t);
+
+	/*
+	 * also gives the stamp of the state the pose was extrapolated from
+	 */
+	tf::Transform predict(ros::Time t, ros::Time& from);
+
+	tf::Vector3 getBaseFrameVelocity();
+	tf::Vector3 getBaseFrameOmega();
+
+	typedef cv::Matx<double, 12, 12> Matx1212d;
+
+private:
+
+	struct State{
+		cv::Matx33d R; // w2b rotation
+		cv::Vec3d p; // position in the world
+		cv::Vec3d v; // velocity in the world frame
+		cv::Vec3d w; // angular rate in the base frame
+
+		Matx1212d P;
+
+		ros::Time t;
+
+		bool motion_known;
+	};
+
+	struct Measurement{
+		enum Type{
+			VO,
+			POSE,
+			GYRO
+		} type;
+
+		ros::Time t;
+
+		// pose of VO and POSE
+		cv::Matx33d R;
+		cv::Vec3d p;
+		double sigma_position;
+		double sigma_rotation;
+
+		// increment of VO and rate of GYRO
+		bool has_motion;
+		cv::Vec3d v;
+		cv::Vec3d w;
+		double sigma_v;
+		double sigma_w;
+	};
+
+	State state;
+	bool is_initialized;
+
+	// every measurement in stamp order with the posterior after it
+	std::deque<std::pair<Measurement, State> > history;
+
+	tf::Transform last_vo;
+	ros::Time last_vo_t;
+	bool last_vo_set;
+
+	std::mutex mutex;
+
+	void insert(const Measurement& m);
+
+	static void propagate(State& s, ros::Time t);
+
+	static void apply(State& s, const Measurement& m);
+
+	template<int M>
+	static void correct(State& s, const cv::Matx<double, M, 12>& H, const cv::Vec<double, M>& r, const cv::Matx<double, M, M>& noise);
+
+	static cv::Matx33d toMatx(const tf::Matrix3x3& m);
+	static tf::Transform toTransform(const cv::Matx33d& R, const cv::Vec3d& p);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_POSEFILTER_H_ */
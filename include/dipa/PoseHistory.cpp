@@ -0,0 +1,206 @@
+/*
+ * PoseHistory.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/PoseHistory.h>
+
+PoseHistory::PoseHistory() : slots(new Slot[POSE_HISTORY_SIZE]), written(0) {
+	for(int i = 0; i < POSE_HISTORY_SIZE; i++)
+	{
+		this->slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+PoseHistory::~PoseHistory() {
+
+}
+
+void PoseHistory::record(ros::Time stamp, tf::Transform w2c)
+{
+	uint64_t n = this->written.load(std::memory_order_relaxed);
+
+	Entry e;
+	e.index = n;
+	e.stamp = stamp;
+	e.w2c = w2c;
+	e.aligned = false;
+	e.increment = tf::Transform::getIdentity();
+
+	if(n > 0)
+	{
+		// only this thread writes so the newest slot can't change under us
+		const Entry& last = this->slots[(n - 1) % POSE_HISTORY_SIZE].entry;
+
+		if(stamp <= last.stamp)
+		{
+			ROS_WARN_STREAM("pose history got a frame which is not newer than the last one. dt: " << (stamp - last.stamp).toSec());
+		}
+
+		e.increment = last.w2c.inverse() * w2c;
+	}
+
+	this->write(this->slots[n % POSE_HISTORY_SIZE], e);
+
+	this->written.store(n + 1, std::memory_order_release);
+}
+
+void PoseHistory::amendNewest(tf::Transform w2c, bool aligned)
+{
+	uint64_t n = this->written.load(std::memory_order_relaxed);
+
+	if(n == 0)
+	{
+		return;
+	}
+
+	Slot& slot = this->slots[(n - 1) % POSE_HISTORY_SIZE];
+
+	Entry e = slot.entry;
+	e.w2c = w2c;
+	e.aligned = e.aligned || aligned;
+
+	this->write(slot, e);
+}
+
+bool PoseHistory::propagate(ros::Time stamp, tf::Transform w2c, tf::Transform& w2c_newest, ros::Time& newest_stamp)
+{
+	uint64_t n = this->written.load(std::memory_order_acquire);
+
+	if(n == 0)
+	{
+		return false;
+	}
+
+	// walk back to the last frame at or before the stamp
+	Entry e;
+	bool found = false;
+
+	uint64_t oldest = (n > POSE_HISTORY_SIZE) ? n - POSE_HISTORY_SIZE : 0;
+	uint64_t base = 0;
+
+	for(uint64_t i = n; i-- > oldest;)
+	{
+		if(!this->read(i, e))
+		{
+			break; // the writer lapped us
+		}
+
+		if(e.stamp <= stamp)
+		{
+			found = true;
+			base = i;
+			break;
+		}
+	}
+
+	if(!found)
+	{
+		ROS_WARN_STREAM("the pose at " << stamp << " is older than the pose history");
+		return false;
+	}
+
+	if(base == n - 1)
+	{
+		// the pose is at least as new as the newest frame
+		w2c_newest = w2c;
+		newest_stamp = stamp;
+		return true;
+	}
+
+	// and forward again over the frames after it. the slots are read in place so nothing is allocated
+	tf::Transform pose = w2c;
+	Entry next;
+
+	for(uint64_t i = base + 1; i < n; i++)
+	{
+		if(!this->read(i, next))
+		{
+			ROS_WARN_STREAM("the pose history was overwritten while the pose at " << stamp << " was moved through it");
+			return false;
+		}
+
+		if(next.aligned)
+		{
+			ROS_WARN_STREAM("the frame at " << next.stamp << " was aligned after the pose at " << stamp << ". it is stale");
+			return false;
+		}
+
+		if(i == base + 1)
+		{
+			// the pose is between two frames so only the rest of the first increment is applied
+			double frame_dt = (next.stamp - e.stamp).toSec();
+			double alpha = (frame_dt > 0) ? (stamp - e.stamp).toSec() / frame_dt : 1.0;
+
+			pose = w2c * scale(next.increment, 1.0 - alpha);
+		}
+		else
+		{
+			pose = pose * next.increment;
+		}
+	}
+
+	ROS_DEBUG_STREAM("re-applied " << n - 1 - base << " vo increments to a pose " << (next.stamp - stamp).toSec() << " seconds old");
+
+	w2c_newest = pose;
+	newest_stamp = next.stamp;
+
+	return true;
+}
+
+bool PoseHistory::newest(Entry& e)
+{
+	uint64_t n = this->written.load(std::memory_order_acquire);
+
+	return n > 0 && this->read(n - 1, e);
+}
+
+void PoseHistory::write(Slot& slot, const Entry& e)
+{
+	uint32_t s = slot.sequence.load(std::memory_order_relaxed);
+
+	slot.sequence.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.entry = e;
+
+	slot.sequence.store(s + 2, std::memory_order_release);
+}
+
+bool PoseHistory::read(uint64_t index, Entry& e)
+{
+	const Slot& slot = this->slots[index % POSE_HISTORY_SIZE];
+
+	while(true)
+	{
+		uint32_t before = slot.sequence.load(std::memory_order_acquire);
+
+		if(before & 1)
+		{
+			continue; // being written
+		}
+
+		e = slot.entry;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if(slot.sequence.load(std::memory_order_relaxed) == before)
+		{
+			break;
+		}
+	}
+
+	return e.index == index;
+}
+
+/*
+ * the fraction s of a motion. the rotation is slerped and the translation scaled
+ */
+tf::Transform PoseHistory::scale(tf::Transform t, double s)
+{
+	tf::Quaternion q = tf::Quaternion::getIdentity().slerp(t.getRotation(), s);
+
+	return tf::Transform(q, t.getOrigin() * s);
+}
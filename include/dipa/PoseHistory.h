@@ -0,0 +1,91 @@
+/*
+ * PoseHistory.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_POSEHISTORY_H_
+#define DIPA_INCLUDE_DIPA_POSEHISTORY_H_
+
+#include <ros/ros.h>
+
+#include <tf/tf.h>
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+
+#include <dipa/DipaParams.h>
+
+/*
+ * fixed capacity ring of the last POSE_HISTORY_SIZE frames keyed by stamp.
+ *
+ * every frame stores the camera pose it ended with and the vo increment which took the previous
+ * frame's final pose to this frame's vo pose. a pose known for an old stamp is moved to the newest
+ * frame by re-applying the increments after it, read in place from the ring without allocating.
+ *
+ * there is one writer, the processing thread. every slot is guarded by a sequence counter which is
+ * odd while the slot is written so readers retry instead of locking.
+ */
+class PoseHistory {
+public:
+
+	struct Entry{
+		uint64_t index; // the number of frames recorded before this one
+		ros::Time stamp;
+		tf::Transform w2c; // the final pose of the frame
+		tf::Transform increment; // the vo motion from the previous frame's final pose
+		bool aligned; // the final pose came from an absolute alignment
+	};
+
+	PoseHistory();
+	virtual ~PoseHistory();
+
+	/*
+	 * adds a frame with the pose vo gave it. writer only
+	 */
+	void record(ros::Time stamp, tf::Transform w2c);
+
+	/*
+	 * replaces the final pose of the newest frame after it was aligned or corrected. writer only
+	 */
+	void amendNewest(tf::Transform w2c, bool aligned);
+
+	/*
+	 * moves w2c, the camera pose at stamp, to the newest frame.
+	 *
+	 * returns false if the stamp is older than the history or if a later frame was aligned which
+	 * makes the pose at stamp stale.
+	 */
+	bool propagate(ros::Time stamp, tf::Transform w2c, tf::Transform& w2c_newest, ros::Time& newest_stamp);
+
+	/*
+	 * copies the newest frame. returns false if there is none
+	 */
+	bool newest(Entry& e);
+
+	uint64_t size(){return std::min<uint64_t>(this->written.load(std::memory_order_acquire), POSE_HISTORY_SIZE);}
+
+private:
+
+	struct Slot{
+		std::atomic<uint32_t> sequence;
+		Entry entry;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+
+	std::atomic<uint64_t> written;
+
+	void write(Slot& slot, const Entry& e);
+
+	/*
+	 * copies the entry with this index. returns false if it was overwritten
+	 */
+	bool read(uint64_t index, Entry& e);
+
+	static tf::Transform scale(tf::Transform t, double s);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_POSEHISTORY_H_ */
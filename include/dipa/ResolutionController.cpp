@@ -0,0 +1,67 @@
+/*
+ * ResolutionController.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/ResolutionController.h>
+
+ResolutionController::ResolutionController() {
+	reset(INVERSE_IMAGE_SCALE);
+}
+
+ResolutionController::~ResolutionController() {
+
+}
+
+void ResolutionController::reset(double s)
+{
+	inverse_scale = std::max(1.0, s);
+	frames_wanting_change = 0;
+}
+
+double ResolutionController::update(double nominal_cost, double budget, double grid_spacing_px)
+{
+	// the coarsest scale which keeps the grid detectable
+	double quality_scale = RES_MAX_INVERSE_SCALE;
+	if(std::isfinite(grid_spacing_px) && grid_spacing_px > 0)
+	{
+		quality_scale = grid_spacing_px / RES_MIN_GRID_SPACING;
+	}
+
+	// the finest scale the cpu can afford
+	double cpu_scale = inverse_scale;
+	if(nominal_cost > 0 && budget > 0)
+	{
+		cpu_scale = inverse_scale * sqrt(nominal_cost / (RES_TARGET_LOAD * budget));
+	}
+
+	double target = quantize(std::max(1.0, std::min(RES_MAX_INVERSE_SCALE, std::max(RES_MIN_INVERSE_SCALE, std::min(cpu_scale, quality_scale)))));
+
+	if(fabs(target - inverse_scale) < RES_SCALE_STEP * 0.5)
+	{
+		frames_wanting_change = 0;
+		return inverse_scale;
+	}
+
+	frames_wanting_change++;
+
+	// the grid would become undetectable so don't wait
+	bool urgent = target < inverse_scale && inverse_scale > quality_scale;
+
+	if(urgent || frames_wanting_change >= RES_HOLD_FRAMES)
+	{
+		ROS_DEBUG_STREAM("changing the inverse image scale from " << inverse_scale << " to " << target << ". cpu wants " << cpu_scale << " and the grid needs " << quality_scale);
+
+		inverse_scale = target;
+		frames_wanting_change = 0;
+	}
+
+	return inverse_scale;
+}
+
+double ResolutionController::quantize(double s)
+{
+	return std::max(RES_SCALE_STEP, RES_SCALE_STEP * round(s / RES_SCALE_STEP));
+}
@@ -0,0 +1,60 @@
+/*
+ * ResolutionController.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_RESOLUTIONCONTROLLER_H_
+#define DIPA_INCLUDE_DIPA_RESOLUTIONCONTROLLER_H_
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <dipa/DipaParams.h>
+
+/*
+ * picks the inverse image scale of the next frame.
+ *
+ * the cost of a frame grows with its pixel count so the scale the cpu can afford is the current
+ * scale times the square root of the nominal cost over the target share of the budget. the grid
+ * spacing on the image shrinks with altitude so there is also a coarsest scale at which the corners
+ * can still be detected. the finer of the two wins so quality holds and the degradation ladder sheds
+ * the rest of the load.
+ *
+ * the scale is quantized to RES_SCALE_STEP and a change must be wanted for RES_HOLD_FRAMES frames
+ * so the latency model can settle between changes.
+ */
+class ResolutionController {
+public:
+
+	ResolutionController();
+	virtual ~ResolutionController();
+
+	/*
+	 * starts over from this inverse scale
+	 */
+	void reset(double inverse_scale);
+
+	/*
+	 * returns the inverse scale for the next frame
+	 *
+	 * nominal_cost is the predicted undegraded frame time at the current scale. 0 if unknown.
+	 * grid_spacing_px is the predicted distance between grid lines in the full resolution image.
+	 */
+	double update(double nominal_cost, double budget, double grid_spacing_px);
+
+	double getInverseScale(){return inverse_scale;}
+
+private:
+
+	double inverse_scale;
+
+	int frames_wanting_change;
+
+	double quantize(double s);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_RESOLUTIONCONTROLLER_H_ */
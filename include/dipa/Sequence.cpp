@@ -0,0 +1,106 @@
+/*
+ * Sequence.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/Sequence.h>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <dipa/GridRenderer.h>
+
+tf::Transform syntheticPose(double t)
+{
+	tf::Matrix3x3 rot;
+	rot.setRPY(CV_PI + 0.05 * sin(0.7 * t), 0.05 * cos(0.5 * t), 0.4 * sin(0.2 * t));
+
+	return tf::Transform(rot, tf::Vector3(2.0 * sin(0.3 * t), 1.5 * sin(0.4 * t), 1.2 + 0.2 * sin(0.5 * t)));
+}
+
+std::vector<SequenceFrame> renderSequence(int frames, cv::Size size, cv::Mat_<float> K, double noise, int threads)
+{
+	std::vector<SequenceFrame> seq(frames);
+
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+
+	for(int w = 0; w < threads; w++)
+	{
+		workers.push_back(std::thread([&](){
+			GridRenderer renderer;
+			renderer.setSize(size);
+			renderer.setIntrinsic(K);
+
+			for(int i = next++; i < frames; i = next++)
+			{
+				seq[i].stamp = ros::Time(1.0 + i / 30.0);
+				seq[i].w2b = syntheticPose(i / 30.0);
+
+				renderer.setW2C(seq[i].w2b);
+
+				cv::Mat gray, grain;
+				cv::cvtColor(renderer.renderGridByProjection(), gray, cv::COLOR_BGR2GRAY);
+				cv::GaussianBlur(gray, gray, cv::Size(0, 0), 1.0);
+
+				gray.convertTo(gray, CV_32F);
+				grain = cv::Mat(size, CV_32F);
+				cv::randn(grain, 0, noise);
+				gray += grain;
+				gray.convertTo(seq[i].img, CV_8U);
+			}
+		}));
+	}
+
+	for(auto& w : workers)
+	{
+		w.join();
+	}
+
+	return seq;
+}
+
+std::vector<SequenceFrame> loadSequence(std::string path)
+{
+	std::vector<SequenceFrame> seq;
+
+	std::string dir = path.substr(0, path.find_last_of('/') + 1);
+
+	std::ifstream file(path);
+	std::string line;
+	while(std::getline(file, line))
+	{
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::stringstream ss(line);
+
+		std::string img_path;
+		double stamp, x, y, z, qx, qy, qz, qw;
+		if(!(ss >> img_path >> stamp >> x >> y >> z >> qx >> qy >> qz >> qw))
+		{
+			continue; // header or blank line
+		}
+
+		SequenceFrame f;
+		f.img = cv::imread((img_path[0] == '/') ? img_path : dir + img_path, cv::IMREAD_GRAYSCALE);
+		f.stamp = ros::Time(stamp);
+		f.w2b = tf::Transform(tf::Quaternion(qx, qy, qz, qw), tf::Vector3(x, y, z));
+
+		if(f.img.empty())
+		{
+			ROS_WARN_STREAM("could not read " << img_path);
+			continue;
+		}
+
+		seq.push_back(f);
+	}
+
+	return seq;
+}
@@ -0,0 +1,47 @@
+/*
+ * Sequence.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_SEQUENCE_H_
+#define DIPA_INCLUDE_DIPA_SEQUENCE_H_
+
+#include <ros/ros.h>
+
+#include <tf/tf.h>
+
+#include "opencv2/core/core.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+ * image sequences with ground truth for the offline tools.
+ *
+ * a sequence is either rendered from the grid along a synthetic trajectory or read from a csv
+ * where every line is: image_path, stamp, x, y, z, qx, qy, qz, qw (the ground truth base pose)
+ */
+struct SequenceFrame{
+	cv::Mat img; // mono8 at full resolution
+	ros::Time stamp;
+	tf::Transform w2b; // ground truth
+};
+
+/*
+ * a smooth trajectory over the middle of the grid with the camera looking down
+ */
+tf::Transform syntheticPose(double t);
+
+/*
+ * renders the default grid along syntheticPose at 30 hz with gaussian noise on the intensities
+ */
+std::vector<SequenceFrame> renderSequence(int frames, cv::Size size, cv::Mat_<float> K, double noise, int threads);
+
+/*
+ * reads a csv sequence. image paths are relative to the csv
+ */
+std::vector<SequenceFrame> loadSequence(std::string path);
+
+#endif /* DIPA_INCLUDE_DIPA_SEQUENCE_H_ */
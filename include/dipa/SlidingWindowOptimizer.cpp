@@ -0,0 +1,470 @@
+/*
+ * SlidingWindowOptimizer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/SlidingWindowOptimizer.h>
+
+SlidingWindowOptimizer::SlidingWindowOptimizer() {
+	running = false;
+	reset_requested = false;
+	generation = 0;
+	window_generation = 0;
+}
+
+SlidingWindowOptimizer::~SlidingWindowOptimizer() {
+	this->stop();
+}
+
+void SlidingWindowOptimizer::start()
+{
+	this->running = true;
+	this->worker = std::thread(&SlidingWindowOptimizer::loop, this);
+}
+
+void SlidingWindowOptimizer::stop()
+{
+	this->running = false;
+	this->wake.notify_one();
+
+	if(this->worker.joinable())
+	{
+		this->worker.join();
+	}
+}
+
+void SlidingWindowOptimizer::post(std::unique_ptr<Frame> frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->pending_mutex);
+		this->pending.push_back(std::move(frame));
+
+		if(this->pending.size() > SWO_MAX_PENDING)
+		{
+			ROS_DEBUG("sliding window is behind. dropping its oldest pending frame");
+			this->pending.pop_front();
+		}
+	}
+	this->wake.notify_one();
+}
+
+void SlidingWindowOptimizer::reset()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->pending_mutex);
+		this->pending.clear();
+		this->reset_requested = true;
+		this->generation++;
+	}
+
+	this->corrections.take(); // a correction from the old window is no longer valid
+}
+
+std::unique_ptr<SlidingWindowOptimizer::Correction> SlidingWindowOptimizer::takeCorrection()
+{
+	std::unique_ptr<Correction> c = this->corrections.take();
+
+	// an optimization which was running during a reset still publishes from the old window
+	if(c && c->generation != this->generation.load())
+	{
+		ROS_DEBUG("dropping a sliding window correction from before the window was reset");
+		return std::unique_ptr<Correction>();
+	}
+
+	return c;
+}
+
+void SlidingWindowOptimizer::loop()
+{
+	while(this->running && ros::ok())
+	{
+		std::unique_ptr<Frame> frame;
+		bool reset_window;
+
+		{
+			std::unique_lock<std::mutex> lock(this->pending_mutex);
+			this->wake.wait_for(lock, std::chrono::duration<double>(0.1), [this]{return !this->pending.empty() || !this->running;});
+
+			if(!this->pending.empty())
+			{
+				frame = std::move(this->pending.front());
+				this->pending.pop_front();
+			}
+
+			// the frame and the reset which came before it belong to the same generation
+			reset_window = this->reset_requested.exchange(false);
+			this->window_generation = this->generation;
+		}
+
+		if(reset_window)
+		{
+			ROS_DEBUG("resetting the sliding window");
+			this->window.clear();
+			this->landmarks.clear();
+		}
+
+		if(!frame)
+		{
+			continue;
+		}
+
+		this->addFrame(std::move(frame));
+
+		this->optimize();
+
+		this->publishCorrection();
+	}
+}
+
+void SlidingWindowOptimizer::addFrame(std::unique_ptr<Frame> frame)
+{
+	WindowFrame wf;
+
+	tf::Transform c2w = frame->w2c.inverse();
+	wf.R = cv::Matx33d(c2w.getBasis().getRow(0).x(), c2w.getBasis().getRow(0).y(), c2w.getBasis().getRow(0).z(),
+			c2w.getBasis().getRow(1).x(), c2w.getBasis().getRow(1).y(), c2w.getBasis().getRow(1).z(),
+			c2w.getBasis().getRow(2).x(), c2w.getBasis().getRow(2).y(), c2w.getBasis().getRow(2).z());
+	wf.t = cv::Vec3d(c2w.getOrigin().x(), c2w.getOrigin().y(), c2w.getOrigin().z());
+
+	// new landmarks start where vo put them
+	for(int i = 0; i < frame->ids.size(); i++)
+	{
+		if(this->landmarks.find(frame->ids[i]) == this->landmarks.end())
+		{
+			this->landmarks[frame->ids[i]] = frame->objects[i];
+		}
+	}
+
+	wf.frame = std::move(frame);
+	this->window.push_back(std::move(wf));
+
+	if(this->window.size() > SWO_WINDOW_SIZE)
+	{
+		this->window.pop_front();
+
+		//forget the landmarks which only the dropped frame saw
+		std::map<int, cv::Point2f> kept;
+		for(auto& e : this->window)
+		{
+			for(auto id : e.frame->ids)
+			{
+				kept[id] = this->landmarks[id];
+			}
+		}
+		this->landmarks.swap(kept);
+	}
+}
+
+/*
+ * adds the prior that the pose of a frame is R_p, t_p to its diagonal block
+ * the pose is updated with R = exp(dtheta) R and t = exp(dtheta) t + dt
+ */
+static void addPosePrior(cv::Mat& S, cv::Mat& b, int f, const cv::Matx33d& R, const cv::Vec3d& t, const cv::Matx33d& R_p, const cv::Vec3d& t_p, double weight)
+{
+	cv::Vec3d r_rot = PlanarPoseSolver::logSO3(R_p * R.t());
+	cv::Vec3d r_trans = t_p - t;
+
+	double r[6] = {r_rot[0], r_rot[1], r_rot[2], r_trans[0], r_trans[1], r_trans[2]};
+
+	// rows are the residuals and columns the pose parameters
+	double J[6][6] = {{1, 0, 0, 0, 0, 0},
+			{0, 1, 0, 0, 0, 0},
+			{0, 0, 1, 0, 0, 0},
+			{0, t[2], -t[1], 1, 0, 0},
+			{-t[2], 0, t[0], 0, 1, 0},
+			{t[1], -t[0], 0, 0, 0, 1}};
+
+	for(int a = 0; a < 6; a++)
+	{
+		for(int c = 0; c < 6; c++)
+		{
+			double h = 0;
+			for(int k = 0; k < 6; k++)
+			{
+				h += J[k][a] * J[k][c];
+			}
+			S.at<double>(6 * f + a, 6 * f + c) += weight * h;
+		}
+
+		double g = 0;
+		for(int k = 0; k < 6; k++)
+		{
+			g += J[k][a] * r[k];
+		}
+		b.at<double>(6 * f + a) += weight * g;
+	}
+}
+
+void SlidingWindowOptimizer::optimize()
+{
+	const int F = this->window.size();
+
+	if(F < 2)
+	{
+		return;
+	}
+
+	// only landmarks seen by two frames constrain the poses
+	std::map<int, int> seen;
+	for(auto& e : this->window)
+	{
+		for(auto id : e.frame->ids)
+		{
+			seen[id]++;
+		}
+	}
+
+	std::map<int, int> index;
+	std::vector<int> lm_ids;
+	std::vector<cv::Vec2d> lm_pos;
+	for(auto e : seen)
+	{
+		if(e.second >= 2)
+		{
+			index[e.first] = lm_ids.size();
+			lm_ids.push_back(e.first);
+			lm_pos.push_back(cv::Vec2d(this->landmarks[e.first].x, this->landmarks[e.first].y));
+		}
+	}
+
+	const int N = lm_ids.size();
+
+	struct Block{
+		cv::Matx22d Hll;
+		cv::Vec2d bl;
+		std::vector<int> frames;
+		std::vector<cv::Matx<double, 6, 2> > Hpl;
+	};
+
+	std::vector<Block> blocks(N);
+
+	// the oldest pose is held where it is when the optimization starts
+	cv::Matx33d anchor_R = this->window.front().R;
+	cv::Vec3d anchor_t = this->window.front().t;
+
+	for(int it = 0; it < SWO_ITERATIONS; it++)
+	{
+		cv::Mat S = cv::Mat::zeros(6 * F, 6 * F, CV_64F);
+		cv::Mat bp = cv::Mat::zeros(6 * F, 1, CV_64F);
+
+		for(auto& e : blocks)
+		{
+			e.Hll = cv::Matx22d();
+			e.bl = cv::Vec2d();
+			e.frames.clear();
+			e.Hpl.clear();
+		}
+
+		for(int f = 0; f < F; f++)
+		{
+			const WindowFrame& wf = this->window[f];
+			const cv::Mat_<float>& K = wf.frame->K;
+			double fx = K(0), cx = K(2), fy = K(4), cy = K(5);
+			double huber = SWO_HUBER_THRESH * wf.frame->pixel_scale;
+
+			for(int j = 0; j < wf.frame->ids.size(); j++)
+			{
+				auto found = index.find(wf.frame->ids[j]);
+				if(found == index.end())
+				{
+					continue;
+				}
+
+				int l = found->second;
+
+				cv::Vec3d Xc = wf.R * cv::Vec3d(lm_pos[l][0], lm_pos[l][1], 0) + wf.t;
+
+				if(Xc[2] <= 0)
+				{
+					continue;
+				}
+
+				double iz = 1.0 / Xc[2];
+
+				double ru = wf.frame->pixels[j].x - (fx * Xc[0] * iz + cx);
+				double rv = wf.frame->pixels[j].y - (fy * Xc[1] * iz + cy);
+
+				double norm = sqrt(ru * ru + rv * rv);
+				double w = (norm <= huber) ? 1.0 : huber / norm;
+
+				double du_dx = fx * iz;
+				double du_dz = -fx * Xc[0] * iz * iz;
+				double dv_dy = fy * iz;
+				double dv_dz = -fy * Xc[1] * iz * iz;
+
+				// the camera point moves by dtheta x Xc + dt
+				double Ju[6] = {du_dz * Xc[1], du_dx * Xc[2] - du_dz * Xc[0], -du_dx * Xc[1], du_dx, 0, du_dz};
+				double Jv[6] = {-dv_dy * Xc[2] + dv_dz * Xc[1], -dv_dz * Xc[0], dv_dy * Xc[0], 0, dv_dy, dv_dz};
+
+				// the landmark moves along the first two columns of R
+				double Lu[2] = {du_dx * wf.R(0, 0) + du_dz * wf.R(2, 0), du_dx * wf.R(0, 1) + du_dz * wf.R(2, 1)};
+				double Lv[2] = {dv_dy * wf.R(1, 0) + dv_dz * wf.R(2, 0), dv_dy * wf.R(1, 1) + dv_dz * wf.R(2, 1)};
+
+				cv::Matx<double, 6, 2> Hpl;
+
+				for(int a = 0; a < 6; a++)
+				{
+					for(int c = 0; c < 6; c++)
+					{
+						S.at<double>(6 * f + a, 6 * f + c) += w * (Ju[a] * Ju[c] + Jv[a] * Jv[c]);
+					}
+					bp.at<double>(6 * f + a) += w * (Ju[a] * ru + Jv[a] * rv);
+
+					for(int c = 0; c < 2; c++)
+					{
+						Hpl(a, c) = w * (Ju[a] * Lu[c] + Jv[a] * Lv[c]);
+					}
+				}
+
+				Block& blk = blocks[l];
+				for(int a = 0; a < 2; a++)
+				{
+					for(int c = 0; c < 2; c++)
+					{
+						blk.Hll(a, c) += w * (Lu[a] * Lu[c] + Lv[a] * Lv[c]);
+					}
+					blk.bl[a] += w * (Lu[a] * ru + Lv[a] * rv);
+				}
+
+				blk.frames.push_back(f);
+				blk.Hpl.push_back(Hpl);
+			}
+
+			if(wf.frame->grid_aligned)
+			{
+				tf::Transform c2w_p = wf.frame->grid_w2c.inverse();
+				cv::Matx33d R_p = cv::Matx33d(c2w_p.getBasis().getRow(0).x(), c2w_p.getBasis().getRow(0).y(), c2w_p.getBasis().getRow(0).z(),
+						c2w_p.getBasis().getRow(1).x(), c2w_p.getBasis().getRow(1).y(), c2w_p.getBasis().getRow(1).z(),
+						c2w_p.getBasis().getRow(2).x(), c2w_p.getBasis().getRow(2).y(), c2w_p.getBasis().getRow(2).z());
+				cv::Vec3d t_p = cv::Vec3d(c2w_p.getOrigin().x(), c2w_p.getOrigin().y(), c2w_p.getOrigin().z());
+
+				addPosePrior(S, bp, f, wf.R, wf.t, R_p, t_p, SWO_GRID_PRIOR_WEIGHT);
+			}
+		}
+
+		addPosePrior(S, bp, 0, this->window.front().R, this->window.front().t, anchor_R, anchor_t, SWO_ANCHOR_WEIGHT);
+
+		// eliminate the landmarks
+		std::vector<cv::Matx22d> Hll_inv(N);
+		for(int l = 0; l < N; l++)
+		{
+			Block& blk = blocks[l];
+
+			blk.Hll(0, 0) += 1e-9;
+			blk.Hll(1, 1) += 1e-9;
+			Hll_inv[l] = blk.Hll.inv();
+
+			for(int a = 0; a < blk.frames.size(); a++)
+			{
+				cv::Matx<double, 6, 2> HW = blk.Hpl[a] * Hll_inv[l];
+				cv::Vec<double, 6> g = HW * blk.bl;
+
+				int fa = blk.frames[a];
+				for(int r = 0; r < 6; r++)
+				{
+					bp.at<double>(6 * fa + r) -= g(r);
+				}
+
+				for(int c = 0; c < blk.frames.size(); c++)
+				{
+					cv::Matx66d H = HW * blk.Hpl[c].t();
+					int fc = blk.frames[c];
+
+					for(int r = 0; r < 6; r++)
+					{
+						for(int k = 0; k < 6; k++)
+						{
+							S.at<double>(6 * fa + r, 6 * fc + k) -= H(r, k);
+						}
+					}
+				}
+			}
+		}
+
+		// frames which share no landmarks with the others stay where they are
+		for(int i = 0; i < 6 * F; i++)
+		{
+			S.at<double>(i, i) += SWO_DAMPING;
+		}
+
+		cv::Mat dp;
+		if(!cv::solve(S, bp, dp, cv::DECOMP_CHOLESKY))
+		{
+			ROS_DEBUG("sliding window system is degenerate");
+			return;
+		}
+
+		for(int f = 0; f < F; f++)
+		{
+			WindowFrame& wf = this->window[f];
+
+			cv::Matx33d dR = PlanarPoseSolver::expSO3(cv::Vec3d(dp.at<double>(6 * f), dp.at<double>(6 * f + 1), dp.at<double>(6 * f + 2)));
+
+			wf.R = dR * wf.R;
+			wf.t = dR * wf.t + cv::Vec3d(dp.at<double>(6 * f + 3), dp.at<double>(6 * f + 4), dp.at<double>(6 * f + 5));
+		}
+
+		// back substitute the landmarks
+		for(int l = 0; l < N; l++)
+		{
+			Block& blk = blocks[l];
+			cv::Vec2d rhs = blk.bl;
+
+			for(int a = 0; a < blk.frames.size(); a++)
+			{
+				int fa = blk.frames[a];
+				for(int c = 0; c < 2; c++)
+				{
+					for(int r = 0; r < 6; r++)
+					{
+						rhs[c] -= blk.Hpl[a](r, c) * dp.at<double>(6 * fa + r);
+					}
+				}
+			}
+
+			lm_pos[l] += Hll_inv[l] * rhs;
+		}
+
+		if(cv::norm(dp) < 1e-8)
+		{
+			break;
+		}
+	}
+
+	for(int l = 0; l < N; l++)
+	{
+		this->landmarks[lm_ids[l]] = cv::Point2f(lm_pos[l][0], lm_pos[l][1]);
+	}
+}
+
+void SlidingWindowOptimizer::publishCorrection()
+{
+	if(this->window.size() < 2)
+	{
+		return;
+	}
+
+	const WindowFrame& newest = this->window.back();
+
+	std::unique_ptr<Correction> c(new Correction);
+
+	c->stamp = newest.frame->stamp;
+	c->window_start = this->window.front().frame->stamp;
+	c->estimate_w2c = newest.frame->w2c;
+	c->refined_w2c = tf::Transform(tf::Matrix3x3(newest.R(0, 0), newest.R(0, 1), newest.R(0, 2),
+			newest.R(1, 0), newest.R(1, 1), newest.R(1, 2),
+			newest.R(2, 0), newest.R(2, 1), newest.R(2, 2)), tf::Vector3(newest.t[0], newest.t[1], newest.t[2])).inverse();
+
+	c->generation = this->window_generation;
+
+	c->ids = newest.frame->ids;
+	c->objects.reserve(c->ids.size());
+	for(auto id : c->ids)
+	{
+		c->objects.push_back(this->landmarks[id]);
+	}
+
+	this->corrections.post(std::move(c));
+}
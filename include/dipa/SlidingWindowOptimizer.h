@@ -0,0 +1,130 @@
+/*
+ * SlidingWindowOptimizer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_SLIDINGWINDOWOPTIMIZER_H_
+#define DIPA_INCLUDE_DIPA_SLIDINGWINDOWOPTIMIZER_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+
+#include <tf/tf.h>
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include <dipa/DipaParams.h>
+
+#include <dipa/Mailbox.h>
+
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+/*
+ * jointly refines the last SWO_WINDOW_SIZE camera poses and the plane positions of the features
+ * they observe on its own thread.
+ *
+ * every feature is on z = 0 so a landmark is only its xy position and the landmarks are eliminated
+ * with 2x2 schur complements leaving a 6 * SWO_WINDOW_SIZE system. grid alignments enter as
+ * priors on the pose of their frame. the oldest pose is held by a strong prior in place of a
+ * marginalization prior which fixes the gauge when no grid alignment is in the window.
+ *
+ * the processing thread posts frames and takes the latest correction between frames so it never
+ * waits on the optimizer.
+ */
+class SlidingWindowOptimizer {
+public:
+
+	struct Frame{
+		ros::Time stamp;
+		cv::Mat_<float> K;
+		double pixel_scale; // the pixel thresholds are multiplied by this at the resolution of K
+
+		tf::Transform w2c; // the pose the frame ended with after vo and grid alignment
+
+		// observations in the vo state's order
+		std::vector<int> ids;
+		std::vector<cv::Point2f> pixels;
+		std::vector<cv::Point2f> objects;
+
+		bool grid_aligned;
+		tf::Transform grid_w2c; // the grid alignment of this frame if grid_aligned
+	};
+
+	struct Correction{
+		ros::Time stamp;
+		ros::Time window_start; // the stamp of the oldest frame in the window
+		tf::Transform estimate_w2c; // the pose of the newest frame when it was posted
+		tf::Transform refined_w2c; // and after refinement
+
+		// refined landmarks seen by the newest frame in the order of its ids
+		std::vector<int> ids;
+		std::vector<cv::Point2f> objects;
+		uint32_t generation; // the number of resets before the window it came from
+	};
+
+	SlidingWindowOptimizer();
+	virtual ~SlidingWindowOptimizer();
+
+	void start();
+
+	void stop();
+
+	void post(std::unique_ptr<Frame> frame);
+
+	/*
+	 * drops the window. used when tracking is lost and the poses in it are no longer trusted
+	 */
+	void reset();
+
+	/*
+	 * the latest correction. one from a window which was reset since it was computed is dropped
+	 */
+	std::unique_ptr<Correction> takeCorrection();
+
+private:
+
+	struct WindowFrame{
+		std::unique_ptr<Frame> frame;
+
+		// c2w of the frame. takes world points into the camera
+		cv::Matx33d R;
+		cv::Vec3d t;
+	};
+
+	// frames waiting for the worker
+	std::deque<std::unique_ptr<Frame>> pending;
+	std::mutex pending_mutex;
+	std::condition_variable wake;
+
+	std::deque<WindowFrame> window;
+	std::map<int, cv::Point2f> landmarks;
+
+	Mailbox<Correction> corrections;
+
+	std::thread worker;
+	std::atomic<bool> running;
+	std::atomic<bool> reset_requested;
+
+	// bumped by every reset. the worker copies it when it takes a frame
+	std::atomic<uint32_t> generation;
+	uint32_t window_generation;
+
+	void loop();
+
+	void addFrame(std::unique_ptr<Frame> frame);
+
+	void optimize();
+
+	void publishCorrection();
+};
+
+#endif /* DIPA_INCLUDE_DIPA_SLIDINGWINDOWOPTIMIZER_H_ */
@@ -0,0 +1,240 @@
+/*
+ * EDLineDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/EDLineDetector.h>
+
+#include <algorithm>
+
+EDLineDetector::EDLineDetector() {
+
+}
+
+EDLineDetector::~EDLineDetector() {
+
+}
+
+void EDLineDetector::detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines)
+{
+	cv::GaussianBlur(img, this->blur, cv::Size(0, 0), this->params.canny_blur_sigma);
+
+	this->computeGradient();
+	this->findAnchors();
+
+	this->edge.create(img.size());
+	this->edge.setTo(0);
+
+	this->segments.clear();
+
+	for(auto& a : this->anchors)
+	{
+		if(this->edge(a))
+		{
+			continue; // already on a chain
+		}
+
+		this->edge(a) = 1;
+
+		bool horizontal = (this->dir(a) == HORIZONTAL);
+		this->walk(a, horizontal, -1, this->walk_back);
+		this->walk(a, horizontal, 1, this->walk_forward);
+
+		if(this->walk_back.size() + this->walk_forward.size() + 1 < LINE_MIN_SEGMENT_LENGTH)
+		{
+			continue;
+		}
+
+		this->chain.assign(this->walk_back.rbegin(), this->walk_back.rend());
+		this->chain.push_back(a);
+		this->chain.insert(this->chain.end(), this->walk_forward.begin(), this->walk_forward.end());
+
+		this->fitSegments(this->chain);
+	}
+
+	ROS_DEBUG_STREAM("edge drawing found " << this->segments.size() << " segments from " << this->anchors.size() << " anchors");
+
+	this->fitLineFamilies(this->segments, LINE_MERGE_RHO * this->pixel_scale, lines);
+}
+
+void EDLineDetector::computeGradient()
+{
+	cv::Sobel(this->blur, this->dx, CV_16S, 1, 0, 3);
+	cv::Sobel(this->blur, this->dy, CV_16S, 0, 1, 3);
+
+	this->mag.create(this->blur.size());
+	this->dir.create(this->blur.size());
+
+	for(int y = 0; y < this->mag.rows; y++)
+	{
+		const short* gx = this->dx.ptr<short>(y);
+		const short* gy = this->dy.ptr<short>(y);
+		short* m = this->mag[y];
+		uchar* d = this->dir[y];
+
+		bool border_row = (y == 0 || y == this->mag.rows - 1);
+
+		for(int x = 0; x < this->mag.cols; x++)
+		{
+			int ax = abs(gx[x]), ay = abs(gy[x]);
+			int sum = ax + ay;
+
+			// the border is cleared so walks never need a bounds check
+			if(sum < ED_GRADIENT_THRESH || border_row || x == 0 || x == this->mag.cols - 1)
+			{
+				m[x] = 0;
+				d[x] = NONE;
+			}
+			else
+			{
+				m[x] = sum;
+				d[x] = (ax >= ay) ? VERTICAL : HORIZONTAL;
+			}
+		}
+	}
+}
+
+void EDLineDetector::findAnchors()
+{
+	this->anchors.clear();
+
+	for(int y = 1; y < this->mag.rows - 1; y += ED_SCAN_INTERVAL)
+	{
+		for(int x = 1; x < this->mag.cols - 1; x += ED_SCAN_INTERVAL)
+		{
+			short m = this->mag(y, x);
+			if(m == 0)
+			{
+				continue;
+			}
+
+			bool anchor = (this->dir(y, x) == HORIZONTAL) ?
+					(m - this->mag(y - 1, x) >= ED_ANCHOR_THRESH && m - this->mag(y + 1, x) >= ED_ANCHOR_THRESH) :
+					(m - this->mag(y, x - 1) >= ED_ANCHOR_THRESH && m - this->mag(y, x + 1) >= ED_ANCHOR_THRESH);
+
+			if(anchor)
+			{
+				this->anchors.push_back(cv::Point(x, y));
+			}
+		}
+	}
+
+	// the strongest anchors start the chains
+	std::sort(this->anchors.begin(), this->anchors.end(), [this](const cv::Point& a, const cv::Point& b){return this->mag(a) > this->mag(b);});
+}
+
+void EDLineDetector::walk(cv::Point p, bool horizontal, int sign, std::vector<cv::Point>& out)
+{
+	out.clear();
+
+	while(true)
+	{
+		// the strongest of the three pixels ahead
+		cv::Point next = horizontal ? cv::Point(p.x + sign, p.y) : cv::Point(p.x, p.y + sign);
+		cv::Point side = horizontal ? cv::Point(0, 1) : cv::Point(1, 0);
+
+		if(this->mag(next - side) > this->mag(next) && this->mag(next - side) >= this->mag(next + side))
+		{
+			next -= side;
+		}
+		else if(this->mag(next + side) > this->mag(next))
+		{
+			next += side;
+		}
+
+		if(this->mag(next) == 0 || this->edge(next))
+		{
+			break;
+		}
+
+		this->edge(next) = 1;
+		out.push_back(next);
+
+		// the edge turned so keep going towards its stronger side
+		uchar d = this->dir(next);
+		if(horizontal && d == VERTICAL)
+		{
+			horizontal = false;
+			sign = (this->mag(next.y + 1, next.x) >= this->mag(next.y - 1, next.x)) ? 1 : -1;
+		}
+		else if(!horizontal && d == HORIZONTAL)
+		{
+			horizontal = true;
+			sign = (this->mag(next.y, next.x + 1) >= this->mag(next.y, next.x - 1)) ? 1 : -1;
+		}
+
+		p = next;
+	}
+}
+
+void EDLineDetector::fitSegments(const std::vector<cv::Point>& chain)
+{
+	int n = chain.size();
+	int i = 0;
+	cv::Vec3d line;
+
+	while(n - i >= LINE_MIN_SEGMENT_LENGTH)
+	{
+		// slide the initial window until it is straight
+		if(fitLine(chain, i, i + LINE_MIN_SEGMENT_LENGTH, line) > ED_LINE_FIT_ERROR)
+		{
+			i++;
+			continue;
+		}
+
+		// grow it until a pixel leaves the line
+		int j = i + LINE_MIN_SEGMENT_LENGTH;
+		while(j < n && fabs(line[0] * chain[j].x + line[1] * chain[j].y - line[2]) <= ED_LINE_FIT_ERROR)
+		{
+			j++;
+		}
+
+		fitLine(chain, i, j, line);
+
+		// the ends projected onto the line
+		cv::Point2d a(chain[i].x, chain[i].y), b(chain[j - 1].x, chain[j - 1].y);
+		double da = line[0] * a.x + line[1] * a.y - line[2];
+		double db = line[0] * b.x + line[1] * b.y - line[2];
+
+		this->segments.push_back(cv::Vec4f(a.x - da * line[0], a.y - da * line[1], b.x - db * line[0], b.y - db * line[1]));
+
+		i = j;
+	}
+}
+
+double EDLineDetector::fitLine(const std::vector<cv::Point>& chain, int begin, int end, cv::Vec3d& line)
+{
+	int n = end - begin;
+
+	double mx = 0, my = 0;
+	for(int i = begin; i < end; i++)
+	{
+		mx += chain[i].x;
+		my += chain[i].y;
+	}
+	mx /= n;
+	my /= n;
+
+	double sxx = 0, sxy = 0, syy = 0;
+	for(int i = begin; i < end; i++)
+	{
+		double x = chain[i].x - mx, y = chain[i].y - my;
+		sxx += x * x;
+		sxy += x * y;
+		syy += y * y;
+	}
+
+	// the normal is perpendicular to the major axis
+	double theta = 0.5 * atan2(2 * sxy, sxx - syy) + CV_PI / 2;
+	line = cv::Vec3d(cos(theta), sin(theta), cos(theta) * mx + sin(theta) * my);
+
+	double worst = 0;
+	for(int i = begin; i < end; i++)
+	{
+		worst = std::max(worst, fabs(line[0] * chain[i].x + line[1] * chain[i].y - line[2]));
+	}
+
+	return worst;
+}
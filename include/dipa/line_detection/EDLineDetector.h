@@ -0,0 +1,75 @@
+/*
+ * EDLineDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_EDLINEDETECTOR_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_EDLINEDETECTOR_H_
+
+#include <dipa/line_detection/LineDetector.h>
+
+/*
+ * edlines style detector.
+ *
+ * edge drawing finds anchors (pixels which are much stronger than their neighbors across the edge)
+ * on a sparse scan grid and walks from the strongest ones along the gradient ridge to get one pixel
+ * wide edge chains. each chain is split into straight segments by growing least squares fits until
+ * a pixel leaves the line. the segments are then fitted to the grid line families.
+ *
+ * only the pixels on a walk are visited after the gradient so it is much cheaper than voting every
+ * edge pixel into a hough accumulator.
+ */
+class EDLineDetector : public LineDetector {
+public:
+
+	EDLineDetector();
+	virtual ~EDLineDetector();
+
+	void detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines);
+
+	std::string name(){return "edlines";}
+
+	const std::vector<cv::Vec4f>& getSegments(){return segments;}
+
+private:
+
+	// the way an edge runs through a pixel
+	enum Direction{
+		NONE = 0,
+		HORIZONTAL,
+		VERTICAL
+	};
+
+	cv::Mat blur, dx, dy;
+	cv::Mat_<short> mag; // |dx| + |dy| or 0 below ED_GRADIENT_THRESH and on the border
+	cv::Mat_<uchar> dir;
+	cv::Mat_<uchar> edge; // pixels already on a chain
+
+	std::vector<cv::Point> anchors;
+	std::vector<cv::Point> chain, walk_back, walk_forward;
+
+	std::vector<cv::Vec4f> segments;
+
+	void computeGradient();
+
+	void findAnchors();
+
+	/*
+	 * follows the ridge from p until the gradient ends or another chain is hit
+	 */
+	void walk(cv::Point p, bool horizontal, int sign, std::vector<cv::Point>& out);
+
+	/*
+	 * splits the chain into segments which stay within ED_LINE_FIT_ERROR of their line
+	 */
+	void fitSegments(const std::vector<cv::Point>& chain);
+
+	/*
+	 * total least squares line nx * x + ny * y = c through chain[begin, end). returns the largest distance
+	 */
+	static double fitLine(const std::vector<cv::Point>& chain, int begin, int end, cv::Vec3d& line);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_EDLINEDETECTOR_H_ */
@@ -0,0 +1,40 @@
+/*
+ * HoughLineDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/HoughLineDetector.h>
+
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+
+HoughLineDetector::HoughLineDetector() {
+
+}
+
+HoughLineDetector::~HoughLineDetector() {
+
+}
+
+void HoughLineDetector::detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines)
+{
+	this->detectEdges(img);
+
+	// the votes of a line grow with its length in pixels
+	cv::HoughLines(this->canny, lines, 1, CV_PI/180, std::max(1, cvRound(this->params.hough_thresh * this->pixel_scale)), 0, 0);
+}
+
+void HoughLineDetector::detectEdges(const cv::Mat& img)
+{
+	cv::GaussianBlur(img, this->blur, cv::Size(0, 0), this->params.canny_blur_sigma);
+
+	cv::Canny(this->blur, this->canny, this->params.canny_thresh_1, this->params.canny_thresh_2);
+
+#if SUPER_DEBUG
+	cv::imshow("raw canny", this->canny);
+	cv::waitKey(30);
+#endif
+}
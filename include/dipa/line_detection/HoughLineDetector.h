@@ -0,0 +1,36 @@
+/*
+ * HoughLineDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_HOUGHLINEDETECTOR_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_HOUGHLINEDETECTOR_H_
+
+#include <dipa/line_detection/LineDetector.h>
+
+/*
+ * blurs, runs canny and votes every edge pixel into cv::HoughLines with one degree bins
+ */
+class HoughLineDetector : public LineDetector {
+public:
+
+	HoughLineDetector();
+	virtual ~HoughLineDetector();
+
+	void detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines);
+
+	std::string name(){return "hough";}
+
+protected:
+
+	cv::Mat blur, canny;
+
+	/*
+	 * blurs img and fills canny with its edges
+	 */
+	void detectEdges(const cv::Mat& img);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_HOUGHLINEDETECTOR_H_ */
@@ -0,0 +1,30 @@
+/*
+ * LSDLineDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/LSDLineDetector.h>
+
+LSDLineDetector::LSDLineDetector() {
+	// the refinement splits curved edges which the grid does not have
+	this->lsd = cv::createLineSegmentDetector(cv::LSD_REFINE_NONE);
+}
+
+LSDLineDetector::~LSDLineDetector() {
+
+}
+
+void LSDLineDetector::detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines)
+{
+	this->segments.clear();
+
+	try {
+		this->lsd->detect(img, this->segments);
+	} catch (cv::Exception& e) {
+		ROS_ERROR_STREAM_ONCE("lsd is not available in this opencv: " << e.what());
+	}
+
+	this->fitLineFamilies(this->segments, LINE_MERGE_RHO * this->pixel_scale, lines);
+}
@@ -0,0 +1,36 @@
+/*
+ * LSDLineDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_LSDLINEDETECTOR_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_LSDLINEDETECTOR_H_
+
+#include <dipa/line_detection/LineDetector.h>
+
+/*
+ * finds segments with opencv's line segment detector and fits them to the grid line families.
+ *
+ * lsd does its own smoothing and needs no thresholds. it was removed from opencv between 3.4.6
+ * and 4.5.1 so those versions return no segments.
+ */
+class LSDLineDetector : public LineDetector {
+public:
+
+	LSDLineDetector();
+	virtual ~LSDLineDetector();
+
+	void detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines);
+
+	std::string name(){return "lsd";}
+
+private:
+
+	cv::Ptr<cv::LineSegmentDetector> lsd;
+
+	std::vector<cv::Vec4f> segments;
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_LSDLINEDETECTOR_H_ */
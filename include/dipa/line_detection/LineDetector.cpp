@@ -0,0 +1,239 @@
+/*
+ * LineDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/LineDetector.h>
+
+#include <algorithm>
+
+namespace {
+
+struct Segment{
+	double theta; // direction of the normal in [0, pi)
+	double length;
+	cv::Point2d mid;
+	cv::Point2d d; // end - start
+	double r; // offset along the normal of the family it belongs to
+};
+
+/*
+ * the angle between two line normals ignoring their sign
+ */
+double angleDistance(double a, double b)
+{
+	double d = fmod(fabs(a - b), CV_PI);
+	return std::min(d, CV_PI - d);
+}
+
+bool inBounds(cv::Point2f testPt, cv::Rect bounds)
+{
+	return (testPt.x >= bounds.x && testPt.y >= bounds.y && testPt.x <= bounds.width && testPt.y <= bounds.height);
+}
+
+}
+
+LineDetector::LineDetector() {
+	this->pixel_scale = 1;
+}
+
+LineDetector::~LineDetector() {
+
+}
+
+void LineDetector::setParameters(const DipaParameters& p)
+{
+	this->params = p;
+}
+
+std::vector<cv::Point2f> LineDetector::findLineIntersections(const std::vector<cv::Vec2f>& lines, cv::Rect boundingBox)
+{
+	std::vector<std::pair<cv::Vec2f, cv::Vec2f> > pairs;
+	return findLineIntersections(lines, boundingBox, pairs);
+}
+
+std::vector<cv::Point2f> LineDetector::findLineIntersections(const std::vector<cv::Vec2f>& lines, cv::Rect boundingBox, std::vector<std::pair<cv::Vec2f, cv::Vec2f> >& pairs)
+{
+	std::vector<cv::Point2f> pts;
+	pairs.clear();
+
+	for(int i = 0; i < (int)lines.size() - 1; i++)
+	{
+		for(int j = i+1; j < lines.size(); j++)
+		{
+			float t1 = (lines[i][1]);
+			float t2 = (lines[j][1]);
+
+			float r1 = lines[i][0];
+			float r2 = lines[j][0];
+
+			float ct1=cos(t1);     //matrix element a
+			float st1=sin(t1);     //b
+			float ct2=cos(t2);     //c
+			float st2=sin(t2);     //d
+			float d=ct1*st2-st1*ct2;        //determinative (rearranged matrix for inverse)
+
+			//check if the vectors are parallel
+			if(fabs(d) < PARALLEL_THRESH)
+			{
+				continue;
+			}
+
+			cv::Point2f pt = cv::Point2f((st2*r1-st1*r2)/d, (-ct2*r1+ct1*r2)/d);
+
+			if(inBounds(pt, boundingBox))
+			{
+				pts.push_back(pt);
+				pairs.push_back(std::make_pair(lines[i], lines[j]));
+			}
+		}
+	}
+
+	return pts;
+}
+
+void LineDetector::fitLineFamilies(const std::vector<cv::Vec4f>& segments, double merge_rho, std::vector<cv::Vec2f>& lines)
+{
+	lines.clear();
+
+	std::vector<Segment> segs;
+	segs.reserve(segments.size());
+
+	for(auto& e : segments)
+	{
+		Segment s;
+		s.d = cv::Point2d(e[2] - e[0], e[3] - e[1]);
+		s.length = sqrt(s.d.x * s.d.x + s.d.y * s.d.y);
+
+		if(s.length < LINE_MIN_SEGMENT_LENGTH)
+		{
+			continue;
+		}
+
+		s.mid = cv::Point2d(0.5 * (e[0] + e[2]), 0.5 * (e[1] + e[3]));
+		s.theta = atan2(s.d.x, -s.d.y);
+		if(s.theta < 0){s.theta += CV_PI;}
+		if(s.theta >= CV_PI){s.theta -= CV_PI;}
+
+		segs.push_back(s);
+	}
+
+	if(segs.empty())
+	{
+		return;
+	}
+
+	// length weighted orientation histogram with one degree bins
+	const int bins = 180;
+	std::vector<double> hist(bins, 0), smooth(bins, 0);
+	for(auto& s : segs)
+	{
+		hist[(int)(s.theta / CV_PI * bins) % bins] += s.length;
+	}
+	for(int i = 0; i < bins; i++)
+	{
+		for(int k = -2; k <= 2; k++)
+		{
+			smooth[i] += hist[(i + k + bins) % bins];
+		}
+	}
+
+	// the strongest orientation and the strongest one which is not the same family
+	double families[2] = {-1, -1};
+	for(int f = 0; f < 2; f++)
+	{
+		double best = 0;
+		for(int i = 0; i < bins; i++)
+		{
+			double theta = (i + 0.5) * CV_PI / bins;
+			if(f == 1 && angleDistance(theta, families[0]) < 2 * LINE_FAMILY_ANGLE_TOL)
+			{
+				continue;
+			}
+			if(smooth[i] > best)
+			{
+				best = smooth[i];
+				families[f] = theta;
+			}
+		}
+	}
+
+	for(int f = 0; f < 2; f++)
+	{
+		if(families[f] < 0)
+		{
+			continue;
+		}
+
+		cv::Point2d n(cos(families[f]), sin(families[f]));
+
+		std::vector<Segment> members;
+		for(auto& s : segs)
+		{
+			if(angleDistance(s.theta, families[f]) < LINE_FAMILY_ANGLE_TOL)
+			{
+				members.push_back(s);
+				members.back().r = n.dot(s.mid);
+			}
+		}
+
+		std::sort(members.begin(), members.end(), [](const Segment& a, const Segment& b){return a.r < b.r;});
+
+		// runs of segments whose offsets are within merge_rho of the previous one lie on one line
+		for(int start = 0, end = 0; start < members.size(); start = end)
+		{
+			end = start + 1;
+			while(end < members.size() && members[end].r - members[end - 1].r <= merge_rho)
+			{
+				end++;
+			}
+
+			double support = 0;
+			cv::Point2d mean(0, 0);
+			for(int i = start; i < end; i++)
+			{
+				support += members[i].length;
+				mean += members[i].length * members[i].mid;
+			}
+
+			if(support < LINE_MIN_SUPPORT)
+			{
+				continue;
+			}
+
+			mean *= 1.0 / support;
+
+			// scatter of the segments treated as uniform densities along their length
+			double sxx = 0, sxy = 0, syy = 0;
+			for(int i = start; i < end; i++)
+			{
+				const Segment& s = members[i];
+				cv::Point2d dm = s.mid - mean;
+				sxx += s.length * (dm.x * dm.x + s.d.x * s.d.x / 12.0);
+				sxy += s.length * (dm.x * dm.y + s.d.x * s.d.y / 12.0);
+				syy += s.length * (dm.y * dm.y + s.d.y * s.d.y / 12.0);
+			}
+
+			// the normal is perpendicular to the major axis
+			double theta = 0.5 * atan2(2 * sxy, sxx - syy) + CV_PI / 2;
+			double rho = cos(theta) * mean.x + sin(theta) * mean.y;
+
+			if(theta >= CV_PI)
+			{
+				theta -= CV_PI;
+				rho = -rho;
+			}
+			else if(theta < 0)
+			{
+				theta += CV_PI;
+				rho = -rho;
+			}
+
+			lines.push_back(cv::Vec2f(rho, theta));
+		}
+	}
+
+	ROS_DEBUG_STREAM("fitted " << lines.size() << " lines to " << segs.size() << " segments");
+}
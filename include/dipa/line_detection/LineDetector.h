@@ -0,0 +1,85 @@
+/*
+ * LineDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_LINEDETECTOR_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_LINEDETECTOR_H_
+
+#include <ros/ros.h>
+
+#include <opencv2/imgproc.hpp>
+#include "opencv2/core/core.hpp"
+
+#include <string>
+#include <vector>
+
+#include <dipa/DipaParams.h>
+#include <dipa/DipaParameters.h>
+
+/*
+ * finds the grid lines in a grayscale image.
+ *
+ * every backend returns infinite lines as (rho, theta) in the convention of cv::HoughLines so the
+ * corners are found the same way whichever backend is used. backends which find segments fit them
+ * to the two grid line families first.
+ */
+class LineDetector {
+public:
+
+	LineDetector();
+	virtual ~LineDetector();
+
+	/*
+	 * takes the canny, blur and hough settings
+	 */
+	virtual void setParameters(const DipaParameters& p);
+
+	/*
+	 * the factor from the resolution the pixel thresholds were tuned at to the one of the images
+	 */
+	void setPixelScale(double s)
+	{
+		this->pixel_scale = s;
+	}
+
+	/*
+	 * replaces lines with the lines found in img
+	 */
+	virtual void detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines) = 0;
+
+	virtual std::string name() = 0;
+
+	/*
+	 * the visible segments (x1, y1, x2, y2) of the lines expected in the next image. backends which
+	 * can use them restrict their search to them. empty means nothing is known
+	 */
+	virtual void setPrior(const std::vector<cv::Vec4f>& predicted){}
+
+	/*
+	 * intersects every pair of lines which are not close to parallel and keeps the intersections
+	 * inside of the bounding box
+	 */
+	static std::vector<cv::Point2f> findLineIntersections(const std::vector<cv::Vec2f>& lines, cv::Rect boundingBox);
+
+	/*
+	 * also returns the pair of lines which made every intersection
+	 */
+	static std::vector<cv::Point2f> findLineIntersections(const std::vector<cv::Vec2f>& lines, cv::Rect boundingBox, std::vector<std::pair<cv::Vec2f, cv::Vec2f> >& pairs);
+
+protected:
+
+	DipaParameters params;
+	double pixel_scale;
+
+	/*
+	 * splits the segments (x1, y1, x2, y2) into the two dominant orientations, merges the
+	 * segments of each orientation whose offsets are within merge_rho pixels and fits one line to
+	 * each group
+	 */
+	static void fitLineFamilies(const std::vector<cv::Vec4f>& segments, double merge_rho, std::vector<cv::Vec2f>& lines);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_LINEDETECTOR_H_ */
@@ -0,0 +1,399 @@
+/*
+ * LineTracker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/LineTracker.h>
+
+#include <algorithm>
+
+LineTracker::LineTracker() {
+	this->pixel_scale = 1;
+	this->profile.resize(2 * LINE_TRACK_SEARCH + 3);
+	this->scores.resize(2 * LINE_TRACK_SEARCH + 1);
+}
+
+LineTracker::~LineTracker() {
+
+}
+
+void LineTracker::track(const cv::Mat& img, const cv::Matx33d& H, bool motion_known, LineDetector& detector, std::vector<cv::Vec2f>& lines)
+{
+	if(!motion_known)
+	{
+		this->hypotheses.clear();
+	}
+
+	// predict and refine the lines of the last frame
+	cv::Matx33d H_inv_t = H.inv().t();
+
+	this->survivors.clear();
+	for(auto& h : this->hypotheses)
+	{
+		Hypothesis moved = h;
+		moved.line = transfer(h.line, H_inv_t);
+
+		if(this->refine(img, moved))
+		{
+			moved.age++;
+			this->survivors.push_back(moved);
+		}
+	}
+
+	int tracked = this->survivors.size();
+
+	// the two grid directions are 90 degrees apart so they share one angle at four times theta
+	double c4 = 0, s4 = 0;
+	for(auto& s : this->survivors)
+	{
+		c4 += cos(4 * s.line[1]);
+		s4 += sin(4 * s.line[1]);
+	}
+	double axis = 0.25 * atan2(s4, c4);
+
+	int count[2] = {0, 0};
+	for(auto& s : this->survivors)
+	{
+		count[family(s.line, axis)]++;
+	}
+
+	bool short_of[2] = {count[0] < LINE_TRACK_MIN_FAMILY_LINES, count[1] < LINE_TRACK_MIN_FAMILY_LINES};
+
+	// detect again if a grid direction is slipping away
+	if(short_of[0] || short_of[1])
+	{
+		detector.detect(img, this->detected);
+
+		for(auto& l : this->detected)
+		{
+			if(this->survivors.size() >= LINE_TRACK_MAX_LINES)
+			{
+				break;
+			}
+
+			// without survivors there is no axis and every direction is short
+			if(tracked > 0 && !short_of[family(l, axis)])
+			{
+				continue;
+			}
+
+			bool duplicate = false;
+			for(auto& s : this->survivors)
+			{
+				if(similar(s.line, l, LINE_MERGE_RHO * this->pixel_scale))
+				{
+					duplicate = true;
+					break;
+				}
+			}
+
+			Hypothesis h;
+			h.line = l;
+			h.polarity = 0;
+			h.age = 0;
+
+			if(!duplicate && this->refine(img, h))
+			{
+				this->survivors.push_back(h);
+			}
+		}
+
+		ROS_DEBUG_STREAM("line tracker kept " << count[0] << " + " << count[1] << " lines and detected " << this->survivors.size() - tracked << " new ones");
+	}
+	else
+	{
+		ROS_DEBUG_STREAM("line tracker kept " << tracked << " of " << this->hypotheses.size() << " lines");
+	}
+
+	this->hypotheses.swap(this->survivors);
+
+	lines.clear();
+	for(auto& h : this->hypotheses)
+	{
+		lines.push_back(h.line);
+	}
+}
+
+bool LineTracker::refine(const cv::Mat& img, Hypothesis& h)
+{
+	cv::Point2f a, b;
+	if(!visibleSegment(h.line, img.size(), a, b))
+	{
+		return false;
+	}
+
+	cv::Point2f along = b - a;
+	float length = sqrt(along.x * along.x + along.y * along.y);
+	if(length < LINE_MIN_SEGMENT_LENGTH)
+	{
+		return false;
+	}
+
+	cv::Point2f n(cos(h.line[1]), sin(h.line[1]));
+	cv::Point2f d = along * (1.0f / length);
+
+	this->edge_points.clear();
+	this->edge_signs.clear();
+
+	const int R = std::max(1, cvRound(LINE_TRACK_SEARCH * this->pixel_scale));
+
+	// only grows when the resolution does
+	this->profile.resize(2 * R + 3);
+	this->scores.resize(2 * R + 1);
+
+	for(int k = 0; k < LINE_TRACK_SAMPLES; k++)
+	{
+		cv::Point2f p = a + ((k + 0.5f) / LINE_TRACK_SAMPLES) * along;
+
+		// intensity profile across the line averaged over three pixels along it
+		bool inside = true;
+		for(int s = -R - 1; s <= R + 1 && inside; s++)
+		{
+			float sum = 0;
+			for(int j = -1; j <= 1 && inside; j++)
+			{
+				float v;
+				inside = interpolate(img, p + (float)s * n + (float)j * d, v);
+				sum += v;
+			}
+			this->profile[s + R + 1] = sum / 3.0f;
+		}
+
+		if(!inside)
+		{
+			continue;
+		}
+
+		// the strongest edge of the right polarity
+		int best = 0;
+		float best_score = -1;
+		for(int s = -R; s <= R; s++)
+		{
+			float g = 0.5f * (this->profile[s + R + 2] - this->profile[s + R]);
+			float score = (h.polarity == 0) ? fabs(g) : h.polarity * g;
+			this->scores[s + R] = score;
+			if(score > best_score)
+			{
+				best_score = score;
+				best = s;
+			}
+		}
+
+		if(best_score < LINE_TRACK_MIN_GRADIENT)
+		{
+			continue;
+		}
+
+		// sub pixel peak of the parabola through the neighbors
+		float offset = best;
+		if(best > -R && best < R)
+		{
+			float l = this->scores[best + R - 1], c = this->scores[best + R], r = this->scores[best + R + 1];
+			float denom = l - 2 * c + r;
+			if(denom < 0)
+			{
+				offset += 0.5f * (l - r) / denom;
+			}
+		}
+
+		this->edge_points.push_back(p + offset * n);
+		this->edge_signs.push_back((this->profile[best + R + 2] > this->profile[best + R]) ? 1 : -1);
+	}
+
+	int needed = cvCeil(LINE_TRACK_MIN_INLIERS * LINE_TRACK_SAMPLES);
+
+	// fit twice dropping the edges which are far from the first fit
+	std::vector<uchar> keep(this->edge_points.size(), 1);
+	cv::Vec2f fitted = h.line;
+
+	for(int pass = 0; pass < 2; pass++)
+	{
+		int count = 0;
+		cv::Point2d mean(0, 0);
+		for(int i = 0; i < this->edge_points.size(); i++)
+		{
+			if(keep[i])
+			{
+				mean += cv::Point2d(this->edge_points[i].x, this->edge_points[i].y);
+				count++;
+			}
+		}
+
+		if(count < needed)
+		{
+			return false;
+		}
+
+		mean *= 1.0 / count;
+
+		double sxx = 0, sxy = 0, syy = 0;
+		for(int i = 0; i < this->edge_points.size(); i++)
+		{
+			if(keep[i])
+			{
+				double x = this->edge_points[i].x - mean.x, y = this->edge_points[i].y - mean.y;
+				sxx += x * x;
+				sxy += x * y;
+				syy += y * y;
+			}
+		}
+
+		double theta = 0.5 * atan2(2 * sxy, sxx - syy) + CV_PI / 2;
+		double rho = cos(theta) * mean.x + sin(theta) * mean.y;
+
+		// keep the normal on the side it was on so the polarity stays meaningful
+		if(cos(theta) * n.x + sin(theta) * n.y < 0)
+		{
+			theta -= CV_PI;
+			rho = -rho;
+		}
+
+		for(int i = 0; i < this->edge_points.size(); i++)
+		{
+			keep[i] = fabs(cos(theta) * this->edge_points[i].x + sin(theta) * this->edge_points[i].y - rho) < LINE_TRACK_REFIT_DIST * this->pixel_scale;
+		}
+
+		fitted = cv::Vec2f(rho, theta);
+	}
+
+	if(h.polarity == 0)
+	{
+		int sum = 0;
+		for(int i = 0; i < this->edge_signs.size(); i++)
+		{
+			sum += keep[i] ? this->edge_signs[i] : 0;
+		}
+		h.polarity = (sum >= 0) ? 1 : -1;
+	}
+
+	// back into the cv::HoughLines range. the polarity flips with the normal
+	if(fitted[1] < 0)
+	{
+		fitted = cv::Vec2f(-fitted[0], fitted[1] + CV_PI);
+		h.polarity = -h.polarity;
+	}
+	else if(fitted[1] >= CV_PI)
+	{
+		fitted = cv::Vec2f(-fitted[0], fitted[1] - CV_PI);
+		h.polarity = -h.polarity;
+	}
+
+	h.line = fitted;
+
+	return true;
+}
+
+cv::Matx33d LineTracker::planeHomography(tf::Transform w2c, const cv::Mat_<float>& K)
+{
+	tf::Transform c2w = w2c.inverse();
+	tf::Matrix3x3 R = c2w.getBasis();
+	tf::Vector3 t = c2w.getOrigin();
+
+	// the plane points have z = 0 so only the first two columns of the rotation remain
+	cv::Matx33d M(R[0][0], R[0][1], t.x(),
+			R[1][0], R[1][1], t.y(),
+			R[2][0], R[2][1], t.z());
+
+	cv::Matx33d Kd(K(0), K(1), K(2), K(3), K(4), K(5), K(6), K(7), K(8));
+
+	return Kd * M;
+}
+
+/*
+ * a line l with l . x = 0 moves to H^-T l
+ */
+cv::Vec2f LineTracker::transfer(cv::Vec2f line, const cv::Matx33d& H_inv_t)
+{
+	cv::Vec3d l(cos(line[1]), sin(line[1]), -line[0]);
+	cv::Vec3d m = H_inv_t * l;
+
+	double norm = sqrt(m[0] * m[0] + m[1] * m[1]);
+	double theta = atan2(m[1], m[0]);
+	double rho = -m[2] / norm;
+
+	// keep the side of the normal so the polarity carries over
+	if(cos(theta) * l[0] + sin(theta) * l[1] < 0)
+	{
+		theta += CV_PI;
+		rho = -rho;
+	}
+
+	// the polarity is kept in refine so the range is only fixed there
+	return cv::Vec2f(rho, theta);
+}
+
+bool LineTracker::visibleSegment(cv::Vec2f line, cv::Size sz, cv::Point2f& a, cv::Point2f& b)
+{
+	cv::Point2f n(cos(line[1]), sin(line[1]));
+	cv::Point2f d(-n.y, n.x);
+	cv::Point2f p0 = line[0] * n;
+
+	float t0 = -1e6, t1 = 1e6;
+	float lo[2] = {0, 0}, hi[2] = {(float)sz.width - 1, (float)sz.height - 1};
+	float p[2] = {p0.x, p0.y}, v[2] = {d.x, d.y};
+
+	for(int i = 0; i < 2; i++)
+	{
+		if(fabs(v[i]) < 1e-9)
+		{
+			if(p[i] < lo[i] || p[i] > hi[i]){return false;}
+			continue;
+		}
+
+		float ta = (lo[i] - p[i]) / v[i], tb = (hi[i] - p[i]) / v[i];
+		t0 = std::max(t0, std::min(ta, tb));
+		t1 = std::min(t1, std::max(ta, tb));
+	}
+
+	if(t0 >= t1)
+	{
+		return false;
+	}
+
+	a = p0 + t0 * d;
+	b = p0 + t1 * d;
+
+	return true;
+}
+
+bool LineTracker::interpolate(const cv::Mat& img, cv::Point2f p, float& value)
+{
+	int x0 = cvFloor(p.x);
+	int y0 = cvFloor(p.y);
+
+	if(x0 < 0 || y0 < 0 || x0 >= img.cols - 1 || y0 >= img.rows - 1)
+	{
+		value = 0;
+		return false;
+	}
+
+	float ax = p.x - x0;
+	float ay = p.y - y0;
+
+	const uchar* row0 = img.ptr<uchar>(y0);
+	const uchar* row1 = img.ptr<uchar>(y0 + 1);
+
+	value = (1 - ay) * ((1 - ax) * row0[x0] + ax * row0[x0 + 1]) + ay * ((1 - ax) * row1[x0] + ax * row1[x0 + 1]);
+
+	return true;
+}
+
+int LineTracker::family(cv::Vec2f line, double axis)
+{
+	double d = fmod(fabs(line[1] - axis), CV_PI);
+	return (std::min(d, CV_PI - d) < CV_PI / 4) ? 0 : 1;
+}
+
+bool LineTracker::similar(cv::Vec2f a, cv::Vec2f b, double max_rho)
+{
+	double dt = fabs(a[1] - b[1]);
+	if(dt > CV_PI / 2)
+	{
+		// the same line across the theta wrap has the opposite rho
+		return CV_PI - dt < 2 * CV_PI / 180 && fabs(a[0] + b[0]) < max_rho;
+	}
+
+	return dt < 2 * CV_PI / 180 && fabs(a[0] - b[0]) < max_rho;
+}
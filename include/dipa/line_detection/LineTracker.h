@@ -0,0 +1,98 @@
+/*
+ * LineTracker.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_LINETRACKER_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_LINETRACKER_H_
+
+#include <tf/tf.h>
+
+#include <dipa/line_detection/LineDetector.h>
+
+/*
+ * keeps the grid lines between frames.
+ *
+ * every line is moved into the new frame with the homography the plane induces between the two
+ * camera poses. it is then refined by searching LINE_TRACK_SAMPLES short intensity profiles along
+ * its normal for the edge with the polarity it had and refitting the line through the edges. lines
+ * which lose their edge are dropped and the detector only runs when fewer than
+ * LINE_TRACK_MIN_FAMILY_LINES of one grid direction survive. only the new lines of the directions
+ * which ran short are kept, so a frame normally costs a bounded number of profiles instead of a full
+ * detection.
+ */
+class LineTracker {
+public:
+
+	LineTracker();
+	virtual ~LineTracker();
+
+	/*
+	 * replaces lines with the lines of img. H maps the previous image to img and is only used if
+	 * motion_known is set. detector finds new lines when too few survive
+	 */
+	void track(const cv::Mat& img, const cv::Matx33d& H, bool motion_known, LineDetector& detector, std::vector<cv::Vec2f>& lines);
+
+	/*
+	 * forgets every line so the next frame is detected from scratch
+	 */
+	void reset(){this->hypotheses.clear();}
+
+	int size(){return this->hypotheses.size();}
+
+	/*
+	 * the factor from the resolution the pixel thresholds were tuned at to the one of the images
+	 */
+	void setPixelScale(double s)
+	{
+		this->pixel_scale = s;
+	}
+
+	/*
+	 * the homography from the z = 0 plane to the image of a camera at w2c
+	 */
+	static cv::Matx33d planeHomography(tf::Transform w2c, const cv::Mat_<float>& K);
+
+private:
+
+	struct Hypothesis{
+		cv::Vec2f line; // (rho, theta)
+		int polarity; // sign of the intensity change along the normal. 0 until the first refinement
+		int age; // frames tracked
+	};
+
+	std::vector<Hypothesis> hypotheses;
+	std::vector<Hypothesis> survivors;
+
+	std::vector<cv::Vec2f> detected;
+
+	double pixel_scale;
+
+	// scratch for the refinement
+	std::vector<cv::Point2f> edge_points;
+	std::vector<int> edge_signs;
+	std::vector<float> profile;
+	std::vector<float> scores;
+
+	/*
+	 * moves the edge of the line onto the image. returns false if too little of it was found
+	 */
+	bool refine(const cv::Mat& img, Hypothesis& h);
+
+	static cv::Vec2f transfer(cv::Vec2f line, const cv::Matx33d& H_inv_t);
+
+	static bool visibleSegment(cv::Vec2f line, cv::Size sz, cv::Point2f& a, cv::Point2f& b);
+
+	static bool interpolate(const cv::Mat& img, cv::Point2f p, float& value);
+
+	static bool similar(cv::Vec2f a, cv::Vec2f b, double max_rho);
+
+	/*
+	 * 0 if the line is within 45 degrees of the axis, 1 otherwise
+	 */
+	static int family(cv::Vec2f line, double axis);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_LINETRACKER_H_ */
@@ -0,0 +1,183 @@
+/*
+ * PriorHoughLineDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/line_detection/PriorHoughLineDetector.h>
+
+#include <algorithm>
+
+PriorHoughLineDetector::PriorHoughLineDetector() {
+	for(int b = 0; b < THETA_BINS; b++)
+	{
+		cos_table[b] = cos(b * CV_PI / THETA_BINS);
+		sin_table[b] = sin(b * CV_PI / THETA_BINS);
+	}
+
+	max_rho = 0;
+	num_rho = 0;
+}
+
+PriorHoughLineDetector::~PriorHoughLineDetector() {
+
+}
+
+void PriorHoughLineDetector::detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines)
+{
+	if(this->prior.empty())
+	{
+		HoughLineDetector::detect(img, lines);
+		return;
+	}
+
+	this->detectEdges(img);
+
+	this->xs.clear();
+	this->ys.clear();
+	for(int y = 0; y < this->canny.rows; y++)
+	{
+		const uchar* row = this->canny.ptr<uchar>(y);
+		for(int x = 0; x < this->canny.cols; x++)
+		{
+			if(row[x])
+			{
+				this->xs.push_back(x);
+				this->ys.push_back(y);
+			}
+		}
+	}
+	this->rho_idx.resize(this->xs.size());
+
+	this->max_rho = cvCeil(sqrt(this->canny.cols * this->canny.cols + this->canny.rows * this->canny.rows));
+	this->num_rho = 2 * this->max_rho + 1;
+
+	this->buildWindows();
+
+	this->acc.resize(THETA_BINS * this->num_rho);
+
+	int voted = 0;
+	for(int b = 0; b < THETA_BINS; b++)
+	{
+		if(this->active[b])
+		{
+			std::fill(this->acc.begin() + b * this->num_rho, this->acc.begin() + (b + 1) * this->num_rho, 0);
+			this->vote(b);
+			voted++;
+		}
+	}
+
+	// local maxima above the threshold like cv::HoughLines
+	const int thresh = std::max(1, cvRound(this->params.hough_thresh * this->pixel_scale));
+	this->peaks.clear();
+	for(int b = 0; b < THETA_BINS; b++)
+	{
+		if(!this->active[b])
+		{
+			continue;
+		}
+
+		const int* row = &this->acc[b * this->num_rho];
+		const int* prev = (b > 0 && this->active[b - 1]) ? &this->acc[(b - 1) * this->num_rho] : NULL;
+		const int* next = (b < THETA_BINS - 1 && this->active[b + 1]) ? &this->acc[(b + 1) * this->num_rho] : NULL;
+
+		for(int r = 1; r < this->num_rho - 1; r++)
+		{
+			int v = row[r];
+			if(v >= thresh && v > row[r - 1] && v >= row[r + 1] &&
+					(!prev || v > prev[r]) && (!next || v >= next[r]))
+			{
+				Peak p;
+				p.votes = v;
+				p.theta = b;
+				p.rho = r;
+				this->peaks.push_back(p);
+			}
+		}
+	}
+
+	std::sort(this->peaks.begin(), this->peaks.end(), [](const Peak& a, const Peak& b){return a.votes > b.votes;});
+
+	lines.clear();
+	for(auto& p : this->peaks)
+	{
+		lines.push_back(cv::Vec2f(p.rho - this->max_rho, p.theta * CV_PI / THETA_BINS));
+	}
+
+	ROS_DEBUG_STREAM("prior hough voted " << this->xs.size() << " edge pixels into " << voted << " of " << THETA_BINS << " theta bins and found " << lines.size() << " lines");
+}
+
+void PriorHoughLineDetector::buildWindows()
+{
+	this->active.assign(THETA_BINS, 0);
+	this->allowed.assign(THETA_BINS * this->num_rho, 0);
+
+	int tw = cvCeil(PRIOR_HOUGH_THETA_WINDOW * THETA_BINS / CV_PI);
+	int rw = cvCeil(PRIOR_HOUGH_RHO_WINDOW * this->pixel_scale);
+
+	for(auto& p : this->prior)
+	{
+		float mx = 0.5 * (p[0] + p[2]);
+		float my = 0.5 * (p[1] + p[3]);
+
+		double theta = atan2(p[2] - p[0], -(p[3] - p[1]));
+		int center = cvRound(theta * THETA_BINS / CV_PI);
+
+		for(int k = -tw; k <= tw; k++)
+		{
+			int b = ((center + k) % THETA_BINS + THETA_BINS) % THETA_BINS;
+
+			this->active[b] = 1;
+
+			// the predicted line rotated to this bin about the middle of its visible part
+			int rho = cvRound(mx * this->cos_table[b] + my * this->sin_table[b]) + this->max_rho;
+
+			int r0 = std::max(0, rho - rw);
+			int r1 = std::min(this->num_rho - 1, rho + rw);
+
+			uchar* row = &this->allowed[b * this->num_rho];
+			for(int r = r0; r <= r1; r++)
+			{
+				row[r] = 1;
+			}
+		}
+	}
+}
+
+void PriorHoughLineDetector::vote(int b)
+{
+	const float c = this->cos_table[b];
+	const float s = this->sin_table[b];
+
+	const float* x = this->xs.data();
+	const float* y = this->ys.data();
+	int* idx = this->rho_idx.data();
+	int n = this->xs.size();
+
+	int i = 0;
+#if CV_SIMD128
+	cv::v_float32x4 vc = cv::v_setall_f32(c);
+	cv::v_float32x4 vs = cv::v_setall_f32(s);
+	cv::v_float32x4 voff = cv::v_setall_f32((float)this->max_rho);
+
+	for(; i <= n - 4; i += 4)
+	{
+		cv::v_float32x4 vx = cv::v_load(x + i);
+		cv::v_float32x4 vy = cv::v_load(y + i);
+		cv::v_store(idx + i, cv::v_round(vx * vc + vy * vs + voff));
+	}
+#endif
+	for(; i < n; i++)
+	{
+		idx[i] = cvRound(x[i] * c + y[i] * s + this->max_rho);
+	}
+
+	// votes outside of the windows add 0 so the loop has no branch
+	int* row = &this->acc[b * this->num_rho];
+	const uchar* ok = &this->allowed[b * this->num_rho];
+	for(i = 0; i < n; i++)
+	{
+		row[idx[i]] += ok[idx[i]];
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * PriorHoughLineDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_LINE_DETECTION_PRIORHOUGHLINEDETECTOR_H_
+#define DIPA_INCLUDE_DIPA_LINE_DETECTION_PRIORHOUGHLINEDETECTOR_H_
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <dipa/line_detection/HoughLineDetector.h>
+
+/*
+ * hough transform which only votes near the predicted grid lines.
+ *
+ * a theta bin is only voted into if it is within PRIOR_HOUGH_THETA_WINDOW of a predicted line and
+ * only the rho bins within PRIOR_HOUGH_RHO_WINDOW of the predicted line rotated about the middle of
+ * its visible part count. this skips most of the 180 bins and rejects lines which are not part of
+ * the grid.
+ *
+ * the rho of every edge pixel in a bin is computed four at a time with opencv's universal
+ * intrinsics. without a prior it is the plain hough detector.
+ */
+class PriorHoughLineDetector : public HoughLineDetector {
+public:
+
+	PriorHoughLineDetector();
+	virtual ~PriorHoughLineDetector();
+
+	void detect(const cv::Mat& img, std::vector<cv::Vec2f>& lines);
+
+	std::string name(){return "prior_hough";}
+
+	void setPrior(const std::vector<cv::Vec4f>& predicted){this->prior = predicted;}
+
+private:
+
+	static const int THETA_BINS = 180;
+
+	std::vector<cv::Vec4f> prior;
+
+	float cos_table[THETA_BINS];
+	float sin_table[THETA_BINS];
+
+	int max_rho; // rho bin i is the rho i - max_rho
+	int num_rho;
+
+	// the edge pixels as separate coordinate arrays for the vector loads
+	std::vector<float> xs, ys;
+	std::vector<int> rho_idx;
+
+	// THETA_BINS rows of num_rho. only the rows of active bins are valid
+	std::vector<int> acc;
+	std::vector<uchar> allowed;
+	std::vector<uchar> active;
+
+	struct Peak{
+		int votes;
+		int theta;
+		int rho;
+	};
+	std::vector<Peak> peaks;
+
+	void buildWindows();
+
+	void vote(int bin);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_LINE_DETECTION_PRIORHOUGHLINEDETECTOR_H_ */
@@ -0,0 +1,443 @@
+/*
+ * DirectTracker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/DirectTracker.h>
+
+DirectTracker::DirectTracker() {
+	this->state.reserve(NUM_FEATURES);
+	this->state.keyframe_levels = 0;
+
+	this->keep.reserve(NUM_FEATURES);
+	this->sample_ref.reserve(NUM_FEATURES * DIRECT_PATCH_SIZE * DIRECT_PATCH_SIZE);
+	this->sample_obj.reserve(NUM_FEATURES * DIRECT_PATCH_SIZE * DIRECT_PATCH_SIZE);
+	this->sample_valid.reserve(NUM_FEATURES * DIRECT_PATCH_SIZE * DIRECT_PATCH_SIZE);
+}
+
+DirectTracker::~DirectTracker() {
+
+}
+
+void DirectTracker::updateFeatures(cv::Mat img) {
+	this->track(img, this->state.currentPose);
+}
+
+void DirectTracker::updateFeatures(cv::Mat img, tf::Transform w2c_predicted) {
+	this->track(img, w2c_predicted);
+}
+
+void DirectTracker::track(cv::Mat img, tf::Transform w2c_guess) {
+	ROS_ASSERT(this->state.size() > 0);
+
+	int levels = std::min(DIRECT_PYRAMID_LEVELS - 1, this->state.keyframe_levels);
+	cv::buildPyramid(img, this->pyr, levels);
+
+	tf::Transform c2w = w2c_guess.inverse();
+
+	cv::Matx33d R = cv::Matx33d(c2w.getBasis().getRow(0).x(), c2w.getBasis().getRow(0).y(), c2w.getBasis().getRow(0).z(),
+			c2w.getBasis().getRow(1).x(), c2w.getBasis().getRow(1).y(), c2w.getBasis().getRow(1).z(),
+			c2w.getBasis().getRow(2).x(), c2w.getBasis().getRow(2).y(), c2w.getBasis().getRow(2).z());
+	cv::Vec3d t = cv::Vec3d(c2w.getOrigin().x(), c2w.getOrigin().y(), c2w.getOrigin().z());
+
+	ROS_DEBUG("before direct alignment");
+
+	//coarse to fine. the samples of level 0 are left for the patch alignment
+	for(int level = levels; level >= 0; level--)
+	{
+		this->sampleKeyframe(level);
+		this->alignPose(level, R, t);
+	}
+
+	this->alignPatches(R, t);
+
+	ROS_DEBUG("after direct alignment");
+
+	this->state.currentImg = img; // the new image is now the old image
+}
+
+void DirectTracker::sampleKeyframe(int level) {
+	const cv::Mat& ref = this->state.keyframePyr.at(level);
+	const int P = DIRECT_PATCH_SIZE;
+	const int half = P / 2;
+	const float scale = (float)(1 << level);
+
+	int n = this->state.size();
+
+	this->sample_ref.resize(n * P * P);
+	this->sample_obj.resize(n * P * P);
+	this->sample_valid.resize(n * P * P);
+
+	for(int i = 0; i < n; i++)
+	{
+		//the patch is placed relative to the current plane point of its center so it follows realignments
+		cv::Point2f center_obj;
+		bool center_valid = projectToPlane(this->state.anchors[i], this->keyframe_pose, this->K, center_obj);
+		cv::Point2f shift = this->state.objects[i] - center_obj;
+
+		cv::Point2f a = this->state.anchors[i] * (1.0f / scale);
+
+		for(int dy = 0; dy < P; dy++)
+		{
+			for(int dx = 0; dx < P; dx++)
+			{
+				int k = i * P * P + dy * P + dx;
+
+				cv::Point2f q = cv::Point2f(a.x + dx - half, a.y + dy - half);
+
+				this->sample_valid[k] = 0;
+
+				if(!center_valid || q.x < 1 || q.y < 1 || q.x > ref.cols - 2 || q.y > ref.rows - 2)
+				{
+					continue;
+				}
+
+				cv::Point2f obj;
+				if(!projectToPlane(q * scale, this->keyframe_pose, this->K, obj))
+				{
+					continue;
+				}
+
+				this->sample_ref[k] = interpolate(ref, q.x, q.y);
+				this->sample_obj[k] = obj + shift;
+				this->sample_valid[k] = 1;
+			}
+		}
+	}
+}
+
+void DirectTracker::alignPose(int level, cv::Matx33d& R, cv::Vec3d& t) {
+	const cv::Mat& img = this->pyr.at(level);
+	const double s = 1.0 / (double)(1 << level);
+
+	double fx = this->K(0) * s, cx = this->K(2) * s, fy = this->K(4) * s, cy = this->K(5) * s;
+
+	for(int it = 0; it < DIRECT_ITERATIONS; it++)
+	{
+		cv::Matx66d JtJ;
+		cv::Matx61d Jtr;
+		int count = 0;
+
+		for(int k = 0; k < this->sample_obj.size(); k++)
+		{
+			if(!this->sample_valid[k])
+			{
+				continue;
+			}
+
+			cv::Vec3d Xc = R * cv::Vec3d(this->sample_obj[k].x, this->sample_obj[k].y, 0) + t;
+
+			if(Xc[2] <= 0)
+			{
+				continue;
+			}
+
+			double iz = 1.0 / Xc[2];
+			float u = fx * Xc[0] * iz + cx;
+			float v = fy * Xc[1] * iz + cy;
+
+			if(u < 2 || v < 2 || u > img.cols - 3 || v > img.rows - 3)
+			{
+				continue;
+			}
+
+			double r = this->sample_ref[k] - interpolate(img, u, v);
+			double gx = 0.5 * (interpolate(img, u + 1, v) - interpolate(img, u - 1, v));
+			double gy = 0.5 * (interpolate(img, u, v + 1) - interpolate(img, u, v - 1));
+
+			double w = (fabs(r) <= DIRECT_HUBER_THRESH) ? 1.0 : DIRECT_HUBER_THRESH / fabs(r);
+
+			double du_dx = fx * iz;
+			double du_dz = -fx * Xc[0] * iz * iz;
+			double dv_dy = fy * iz;
+			double dv_dz = -fy * Xc[1] * iz * iz;
+
+			// the camera point moves by dtheta x Xc + dt
+			double J[6] = {gx * du_dz * Xc[1] + gy * (-dv_dy * Xc[2] + dv_dz * Xc[1]),
+					gx * (du_dx * Xc[2] - du_dz * Xc[0]) + gy * (-dv_dz * Xc[0]),
+					gx * (-du_dx * Xc[1]) + gy * dv_dy * Xc[0],
+					gx * du_dx,
+					gy * dv_dy,
+					gx * du_dz + gy * dv_dz};
+
+			for(int a = 0; a < 6; a++)
+			{
+				for(int b = 0; b < 6; b++)
+				{
+					JtJ(a, b) += w * J[a] * J[b];
+				}
+				Jtr(a) += w * J[a] * r;
+			}
+
+			count++;
+		}
+
+		if(count < 6)
+		{
+			ROS_DEBUG_STREAM("too few patch samples to align level " << level);
+			return;
+		}
+
+		cv::Matx61d delta;
+		if(!cv::solve(JtJ, Jtr, delta, cv::DECOMP_CHOLESKY))
+		{
+			ROS_DEBUG("direct gauss newton step is degenerate");
+			return;
+		}
+
+		cv::Matx33d dR = PlanarPoseSolver::expSO3(cv::Vec3d(delta(0), delta(1), delta(2)));
+
+		R = dR * R;
+		t = dR * t + cv::Vec3d(delta(3), delta(4), delta(5));
+
+		if(cv::norm(delta) < 1e-6)
+		{
+			break;
+		}
+	}
+}
+
+void DirectTracker::alignPatches(const cv::Matx33d& R, const cv::Vec3d& t) {
+	const cv::Mat& img = this->pyr.at(0);
+	const int P2 = DIRECT_PATCH_SIZE * DIRECT_PATCH_SIZE;
+
+	double fx = this->K(0), cx = this->K(2), fy = this->K(4), cy = this->K(5);
+
+	this->keep.assign(this->state.size(), 0);
+
+	for(int i = 0; i < this->state.size(); i++)
+	{
+		cv::Vec3d Xc = R * cv::Vec3d(this->state.objects[i].x, this->state.objects[i].y, 0) + t;
+
+		if(Xc[2] <= 0)
+		{
+			continue;
+		}
+
+		cv::Point2f center = cv::Point2f(fx * Xc[0] / Xc[2] + cx, fy * Xc[1] / Xc[2] + cy);
+
+		cv::Point2f delta = cv::Point2f(0, 0);
+		double err = 0;
+		int count = 0;
+
+		// the last pass only measures the error
+		for(int it = 0; it <= DIRECT_PATCH_ITERATIONS; it++)
+		{
+			double H00 = 0, H01 = 0, H11 = 0, b0 = 0, b1 = 0;
+			err = 0;
+			count = 0;
+
+			for(int k = i * P2; k < (i + 1) * P2; k++)
+			{
+				if(!this->sample_valid[k])
+				{
+					continue;
+				}
+
+				cv::Vec3d Xk = R * cv::Vec3d(this->sample_obj[k].x, this->sample_obj[k].y, 0) + t;
+
+				if(Xk[2] <= 0)
+				{
+					continue;
+				}
+
+				float u = fx * Xk[0] / Xk[2] + cx + delta.x;
+				float v = fy * Xk[1] / Xk[2] + cy + delta.y;
+
+				if(u < 2 || v < 2 || u > img.cols - 3 || v > img.rows - 3)
+				{
+					continue;
+				}
+
+				double r = this->sample_ref[k] - interpolate(img, u, v);
+				double gx = 0.5 * (interpolate(img, u + 1, v) - interpolate(img, u - 1, v));
+				double gy = 0.5 * (interpolate(img, u, v + 1) - interpolate(img, u, v - 1));
+
+				H00 += gx * gx;
+				H01 += gx * gy;
+				H11 += gy * gy;
+				b0 += gx * r;
+				b1 += gy * r;
+
+				err += fabs(r);
+				count++;
+			}
+
+			double det = H00 * H11 - H01 * H01;
+
+			if(it == DIRECT_PATCH_ITERATIONS || count == 0 || fabs(det) < 1e-9)
+			{
+				break;
+			}
+
+			delta.x += (H11 * b0 - H01 * b1) / det;
+			delta.y += (H00 * b1 - H01 * b0) / det;
+		}
+
+		if(count < P2 / 2)
+		{
+			continue; // mostly out of the image
+		}
+
+		if(err / count > DIRECT_MAX_PATCH_ERROR)
+		{
+			continue; // occluded or not a match
+		}
+
+		cv::Point2f px = center + delta;
+
+		if(px.x < 0 || px.y < 0 || px.x > img.cols - 1 || px.y > img.rows - 1)
+		{
+			continue;
+		}
+
+		this->state.pixels[i] = px;
+		this->keep[i] = 1;
+	}
+
+	int lostFeatures = this->state.compact(this->keep);
+
+	ROS_DEBUG_STREAM("VO LOST " << lostFeatures << "FEATURES");
+}
+
+bool DirectTracker::computePose(double& perPixelError) {
+	ROS_DEBUG("computing motion");
+	ROS_ASSERT(this->state.size() >= 4);
+
+	tf::Transform c2w;
+	double ppe;
+
+	if(!this->planar_solver.solve(this->state.objects, this->state.pixels, this->K, c2w, ppe))
+	{
+		ROS_WARN("the planar pose solver failed to compute motion!");
+		return false;
+	}
+
+	this->state.ppe = ppe;
+	perPixelError = this->state.ppe;
+
+	ROS_DEBUG_STREAM("VO PPE: " << this->state.ppe);
+
+	this->state.currentPose = c2w.inverse(); // invert back to w2c
+
+	ROS_DEBUG("done computing motion");
+
+	return true;
+}
+
+/*
+ * new patches are only added at keyframes. each empty cell of min_feature_dist gets the pixel
+ * with the strongest gradient so even weak texture gives some patches
+ */
+void DirectTracker::replenishFeatures(cv::Mat img, int num_features) {
+	if(!this->needKeyframe())
+	{
+		return;
+	}
+
+	if(this->state.size() < num_features)
+	{
+		int needed = num_features - this->state.size();
+
+		cv::Mat gx, gy, mag;
+		cv::Sobel(img, gx, CV_16S, 1, 0);
+		cv::Sobel(img, gy, CV_16S, 0, 1);
+		cv::convertScaleAbs(gx, gx);
+		cv::convertScaleAbs(gy, gy);
+		cv::add(gx, gy, mag);
+
+		const int cell = std::max(1, cvRound(this->min_feature_dist));
+		const int border = DIRECT_PATCH_SIZE << (DIRECT_PYRAMID_LEVELS - 1);
+		const int grid_cols = (img.cols + cell - 1) / cell;
+		const int grid_rows = (img.rows + cell - 1) / cell;
+
+		std::vector<unsigned char> occupied(grid_cols * grid_rows, 0);
+		for(auto e : this->state.pixels)
+		{
+			int c = std::min(std::max((int)(e.x / cell), 0), grid_cols - 1);
+			int r = std::min(std::max((int)(e.y / cell), 0), grid_rows - 1);
+			occupied.at(r * grid_cols + c) = 1;
+		}
+
+		std::vector<std::pair<int, cv::Point2f>> candidates;
+
+		for(int r = 0; r < grid_rows; r++)
+		{
+			for(int c = 0; c < grid_cols; c++)
+			{
+				if(occupied.at(r * grid_cols + c))
+				{
+					continue;
+				}
+
+				cv::Rect cell_rect = cv::Rect(c * cell, r * cell, cell, cell) & cv::Rect(border, border, img.cols - 2 * border, img.rows - 2 * border);
+
+				if(cell_rect.area() <= 0)
+				{
+					continue;
+				}
+
+				double max_val;
+				cv::Point max_loc;
+				cv::minMaxLoc(mag(cell_rect), NULL, &max_val, NULL, &max_loc);
+
+				if(max_val >= DIRECT_MIN_GRADIENT)
+				{
+					candidates.push_back(std::make_pair((int)max_val, cv::Point2f(cell_rect.x + max_loc.x, cell_rect.y + max_loc.y)));
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const std::pair<int, cv::Point2f>& a, const std::pair<int, cv::Point2f>& b){return a.first > b.first;});
+
+		for(int i = 0; needed > 0 && i < candidates.size(); i++)
+		{
+			cv::Point2f obj;
+
+			if(projectToPlane(candidates.at(i).second, this->state.currentPose, this->K, obj))
+			{
+				ROS_DEBUG("adding new patch to vo");
+				this->state.push(candidates.at(i).second, obj);
+				needed--;
+			}
+		}
+	}
+
+	this->state.currentImg = img;
+
+	this->takeKeyframe(img);
+}
+
+void DirectTracker::takeKeyframe(cv::Mat img) {
+	this->state.anchors.assign(this->state.pixels.begin(), this->state.pixels.end());
+
+	this->state.keyframeImg = img;
+	this->buildKeyframePyramid();
+
+	this->keyframe_pose = this->state.currentPose;
+
+	this->state.keyframe_features = this->state.size();
+
+	this->force_keyframe = false;
+
+	ROS_DEBUG_STREAM("new direct keyframe with " << this->state.keyframe_features << " patches");
+}
+
+void DirectTracker::buildKeyframePyramid() {
+	cv::buildPyramid(this->state.keyframeImg, this->state.keyframePyr, DIRECT_PYRAMID_LEVELS - 1);
+	this->state.keyframe_levels = this->state.keyframePyr.size() - 1;
+}
+
+float DirectTracker::interpolate(const cv::Mat& img, float x, float y) {
+	int x0 = (int)x;
+	int y0 = (int)y;
+	float ax = x - x0;
+	float ay = y - y0;
+
+	const uchar* row0 = img.ptr<uchar>(y0);
+	const uchar* row1 = img.ptr<uchar>(y0 + 1);
+
+	return (1 - ay) * ((1 - ax) * row0[x0] + ax * row0[x0 + 1]) + ay * ((1 - ax) * row1[x0] + ax * row1[x0 + 1]);
+}
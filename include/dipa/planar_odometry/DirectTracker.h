@@ -0,0 +1,89 @@
+/*
+ * DirectTracker.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_DIRECTTRACKER_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_DIRECTTRACKER_H_
+
+#include <ros/ros.h>
+
+#include <opencv2/imgproc.hpp>
+#include "opencv2/core/core.hpp"
+#include <vector>
+#include <algorithm>
+
+#include <tf/tf.h>
+
+#include <dipa/DipaParams.h>
+
+#include <dipa/planar_odometry/PlanarOdometry.h>
+
+/*
+ * sparse direct planar odometry
+ *
+ * small patches around high gradient pixels of the keyframe are aligned with the new frame by their
+ * photometric error. the patch pixels are points on the plane so the warp between the keyframe and
+ * the new frame is the homography induced by the plane.
+ *
+ * 1. the camera pose is aligned coarse to fine on the image pyramid with all patches at once
+ * 2. each patch is then aligned on its own at full resolution to get its pixel
+ * 3. computePose solves the pose from those pixels exactly like the feature tracker does
+ */
+class DirectTracker : public PlanarOdometry {
+public:
+
+	DirectTracker();
+	virtual ~DirectTracker();
+
+	void updateFeatures(cv::Mat img);
+
+	void updateFeatures(cv::Mat img, tf::Transform w2c_predicted);
+
+	bool computePose(double& perPixelError);
+
+	void replenishFeatures(cv::Mat img, int num_features);
+
+private:
+
+	std::vector<cv::Mat> pyr; // pyramid of the frame being tracked
+
+	tf::Transform keyframe_pose; // w2c of the keyframe
+
+	// patch samples of the level being aligned. DIRECT_PATCH_SIZE^2 per point in state order
+	std::vector<float> sample_ref;
+	std::vector<cv::Point2f> sample_obj;
+	std::vector<uchar> sample_valid;
+
+	std::vector<uchar> keep;
+
+	void takeKeyframe(cv::Mat img);
+
+	void buildKeyframePyramid();
+
+	/*
+	 * fills the samples with the keyframe intensities around each anchor at this level and the
+	 * plane points under them
+	 */
+	void sampleKeyframe(int level);
+
+	/*
+	 * gauss newton on the photometric error of every patch at this level
+	 * R and t take plane points into the camera frame
+	 */
+	void alignPose(int level, cv::Matx33d& R, cv::Vec3d& t);
+
+	/*
+	 * moves each patch on its own to minimize its error at full resolution and drops the ones which
+	 * do not match. the pixels of the state are set to the aligned patch centers
+	 */
+	void alignPatches(const cv::Matx33d& R, const cv::Vec3d& t);
+
+	void track(cv::Mat img, tf::Transform w2c_guess);
+
+	static float interpolate(const cv::Mat& img, float x, float y);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_DIRECTTRACKER_H_ */
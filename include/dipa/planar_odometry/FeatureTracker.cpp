@@ -7,9 +7,78 @@
 
 #include <dipa/planar_odometry/FeatureTracker.h>
 
+/*
+ * tracks a block of the features forward into the new frame and straight back again
+ * the blocks run in parallel so the backward pass of one block overlaps the forward pass of another
+ *
+ * each block works on row ranges of the shared buffers so nothing is copied per block
+ */
+class ForwardBackwardFlow : public cv::ParallelLoopBody {
+public:
+	ForwardBackwardFlow(const std::vector<cv::Mat>& oldPyr, const std::vector<cv::Mat>& newPyr, std::vector<cv::Point2f>& oldPoints,
+			std::vector<cv::Point2f>& newPoints, std::vector<cv::Point2f>& backPoints, std::vector<uchar>& status, std::vector<uchar>& statusBack,
+			cv::Size window, int levels, int flags, int blocks, float max_error) :
+				oldPyr(oldPyr), newPyr(newPyr), oldPoints(oldPoints), newPoints(newPoints), backPoints(backPoints), status(status), statusBack(statusBack),
+				window(window), levels(levels), flags(flags), blocks(blocks), max_error(max_error) {}
+
+	virtual void operator()(const cv::Range& range) const
+	{
+		for(int b = range.start; b < range.end; b++)
+		{
+			int start = (oldPoints.size() * b) / blocks;
+			int end = (oldPoints.size() * (b + 1)) / blocks;
+
+			if(start == end)
+			{
+				continue;
+			}
+
+			cv::Mat prev = cv::Mat(oldPoints).rowRange(start, end);
+			cv::Mat next = cv::Mat(newPoints).rowRange(start, end);
+			cv::Mat back = cv::Mat(backPoints).rowRange(start, end);
+			cv::Mat st = cv::Mat(status).rowRange(start, end);
+			cv::Mat st_back = cv::Mat(statusBack).rowRange(start, end);
+
+			prev.copyTo(back);
+
+			cv::TermCriteria term = cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01);
+
+			cv::calcOpticalFlowPyrLK(oldPyr, newPyr, prev, next, st, cv::noArray(), window, levels, term, flags, KLT_MIN_EIGEN);
+			cv::calcOpticalFlowPyrLK(newPyr, oldPyr, next, back, st_back, cv::noArray(), window, levels, term, cv::OPTFLOW_USE_INITIAL_FLOW, KLT_MIN_EIGEN);
+
+			for(int i = start; i < end; i++)
+			{
+				float dx = backPoints[i].x - oldPoints[i].x;
+				float dy = backPoints[i].y - oldPoints[i].y;
+
+				status[i] = (status[i] && statusBack[i] && dx * dx + dy * dy <= max_error * max_error);
+			}
+		}
+	}
+
+private:
+	const std::vector<cv::Mat>& oldPyr;
+	const std::vector<cv::Mat>& newPyr;
+	std::vector<cv::Point2f>& oldPoints;
+	std::vector<cv::Point2f>& newPoints;
+	std::vector<cv::Point2f>& backPoints;
+	std::vector<uchar>& status;
+	std::vector<uchar>& statusBack;
+	cv::Size window;
+	int levels;
+	int flags;
+	int blocks;
+	float max_error; // pixels a feature may miss its start by on the way back
+};
+
 FeatureTracker::FeatureTracker() {
-	// TODO Auto-generated constructor stub
+	this->state.reserve(NUM_FEATURES);
+	this->state.keyframe_levels = 0;
 
+	this->flowed.reserve(NUM_FEATURES);
+	this->back.reserve(NUM_FEATURES);
+	this->status.reserve(NUM_FEATURES);
+	this->status_back.reserve(NUM_FEATURES);
 }
 
 FeatureTracker::~FeatureTracker() {
@@ -17,44 +86,132 @@ FeatureTracker::~FeatureTracker() {
 }
 
 void FeatureTracker::updateFeatures(cv::Mat img) {
+	this->flowFeatures(img, false);
+}
 
-	std::vector<cv::Point2f> oldPoints = this->state.getPixels2fInOrder();
+/*
+ * flows the features starting from where the predicted camera pose says they should be
+ * a good guess lets klt use a smaller window and fewer pyramid levels
+ */
+void FeatureTracker::updateFeatures(cv::Mat img, tf::Transform w2c_predicted) {
+	this->predictPixels(w2c_predicted, this->flowed);
+	this->flowFeatures(img, true);
+}
 
-	ROS_ASSERT(oldPoints.size() > 0);
+/*
+ * projects each feature's plane point into the predicted camera through the plane homography
+ * features which would end up behind the camera keep their current pixel
+ */
+void FeatureTracker::predictPixels(tf::Transform w2c_predicted, std::vector<cv::Point2f>& guesses) {
+	tf::Transform c2w = w2c_predicted.inverse();
 
-	//ROS_DEBUG_STREAM_ONCE("got " << oldPoints.size() << " old point2fs from the oldframe which has " << oldFrame.features.size() << " features");
-	std::vector<cv::Point2f> newPoints;
+	//every object lies on z = 0 so the third column of the rotation drops out
+	cv::Matx33d Rt = cv::Matx33d(c2w.getBasis().getRow(0).x(), c2w.getBasis().getRow(0).y(), c2w.getOrigin().x(),
+			c2w.getBasis().getRow(1).x(), c2w.getBasis().getRow(1).y(), c2w.getOrigin().y(),
+			c2w.getBasis().getRow(2).x(), c2w.getBasis().getRow(2).y(), c2w.getOrigin().z());
 
-	std::vector<uchar> status; // status vector for each point
-	cv::Mat error; // error vector for each point
+	cv::Matx33d Km = cv::Matx33d(this->K(0), this->K(1), this->K(2),
+			this->K(3), this->K(4), this->K(5),
+			this->K(6), this->K(7), this->K(8));
 
-	ROS_DEBUG("before klt");
+	cv::Matx33d H = Km * Rt;
 
-	cv::calcOpticalFlowPyrLK(this->state.currentImg, img, oldPoints, newPoints,
-			status, error, cv::Size(21, 21), 3,
-			cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS,
-					30, 0.01), 0, KLT_MIN_EIGEN);
+	guesses.resize(this->state.size());
 
-	ROS_DEBUG("after klt");
+	for(int i = 0; i < this->state.size(); i++)
+	{
+		const cv::Point2f& obj = this->state.objects[i];
 
-	std::vector<Feature> flowedFeatures;
+		double w = H(2, 0) * obj.x + H(2, 1) * obj.y + H(2, 2);
 
-	int lostFeatures = 0;
+		if(w <= 0)
+		{
+			guesses[i] = this->state.pixels[i];
+			continue;
+		}
 
-	for (int i = 0; i < status.size(); i++) {
-		if (status.at(i) == 1) {
-			Feature updated_feature = this->state.features.at(i);
+		guesses[i] = cv::Point2f((H(0, 0) * obj.x + H(0, 1) * obj.y + H(0, 2)) / w,
+				(H(1, 0) * obj.x + H(1, 1) * obj.y + H(1, 2)) / w);
+	}
+}
 
-			updated_feature.px = newPoints.at(i);
+void FeatureTracker::flowFeatures(cv::Mat img, bool use_guesses) {
 
-			flowedFeatures.push_back(updated_feature);
+#if USE_KEYFRAMES
+	//the features are flowed from where they were in the keyframe so errors do not pile up frame after frame
+	std::vector<cv::Point2f>& oldPoints = this->state.anchors;
+#else
+	std::vector<cv::Point2f>& oldPoints = this->state.pixels;
+#endif
 
-		} else {
-			lostFeatures++;
-		}
+	ROS_ASSERT(oldPoints.size() > 0);
+
+	int window = KLT_WINDOW_SIZE;
+	int levels = KLT_PYRAMID_LEVELS;
+	int flags = 0;
+
+	if(use_guesses)
+	{
+		ROS_ASSERT(this->flowed.size() == oldPoints.size());
+		window = KLT_PREDICTED_WINDOW_SIZE;
+		levels = KLT_PREDICTED_PYRAMID_LEVELS;
+		flags = cv::OPTFLOW_USE_INITIAL_FLOW;
+	}
+	else
+	{
+#if USE_KEYFRAMES
+		//the last frame is much closer to this one than the keyframe is
+		this->flowed.assign(this->state.pixels.begin(), this->state.pixels.end());
+		flags = cv::OPTFLOW_USE_INITIAL_FLOW;
+#else
+		this->flowed.assign(oldPoints.begin(), oldPoints.end());
+#endif
 	}
 
-	this->state.features = flowedFeatures;
+	this->status.assign(oldPoints.size(), 0);
+
+	ROS_DEBUG("before klt");
+
+#if USE_KEYFRAMES
+	//the keyframe pyramid was built with the largest window and levels so it serves either setting
+	std::vector<cv::Mat>& oldPyr = this->state.keyframePyr;
+	std::vector<cv::Mat> newPyr;
+	int newLevels = cv::buildOpticalFlowPyramid(img, newPyr, cv::Size(KLT_WINDOW_SIZE, KLT_WINDOW_SIZE), levels);
+	levels = std::min(this->state.keyframe_levels, newLevels);
+#elif USE_FORWARD_BACKWARD_CHECK
+	std::vector<cv::Mat> oldPyr, newPyr;
+	int oldLevels = cv::buildOpticalFlowPyramid(this->state.currentImg, oldPyr, cv::Size(window, window), levels);
+	int newLevels = cv::buildOpticalFlowPyramid(img, newPyr, cv::Size(window, window), levels);
+	levels = std::min(oldLevels, newLevels); // small images can have fewer levels than asked for
+#endif
+
+#if USE_FORWARD_BACKWARD_CHECK
+	//both passes share the pyramids so they are only built once
+	this->back.resize(oldPoints.size());
+	this->status_back.assign(oldPoints.size(), 0);
+
+	int blocks = std::min((int)oldPoints.size(), KLT_PARALLEL_BLOCKS);
+
+	cv::parallel_for_(cv::Range(0, blocks), ForwardBackwardFlow(oldPyr, newPyr, oldPoints, this->flowed, this->back, this->status, this->status_back,
+			cv::Size(window, window), levels, flags, blocks, MAX_FORWARD_BACKWARD_ERROR * this->pixel_scale));
+#elif USE_KEYFRAMES
+	cv::calcOpticalFlowPyrLK(oldPyr, newPyr, oldPoints, this->flowed,
+			this->status, cv::noArray(), cv::Size(window, window), levels,
+			cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS,
+					30, 0.01), flags, KLT_MIN_EIGEN);
+#else
+	cv::calcOpticalFlowPyrLK(this->state.currentImg, img, oldPoints, this->flowed,
+			this->status, cv::noArray(), cv::Size(window, window), levels,
+			cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS,
+					30, 0.01), flags, KLT_MIN_EIGEN);
+#endif
+
+	ROS_DEBUG("after klt");
+
+	//the flowed pixels become the feature pixels and the old buffer is kept for the next frame
+	std::swap(this->state.pixels, this->flowed);
+
+	int lostFeatures = this->state.compact(this->status);
 
 	this->state.currentImg = img; // the new image is now the old image
 
@@ -65,40 +222,70 @@ void FeatureTracker::updateFeatures(cv::Mat img) {
 bool FeatureTracker::computePose(double& perPixelError) {
 
 	ROS_DEBUG("computing motion");
-	ROS_ASSERT(this->state.features.size() >= 4);
+	ROS_ASSERT(this->state.size() >= 4);
+
+	this->gate_homography = cv::Mat();
+
+#if USE_HOMOGRAPHY_GATE
+	if(!this->rejectHomographyOutliers())
+	{
+		ROS_WARN("too few features agree with the plane homography to compute motion!");
+		return false;
+	}
+#endif
+
+#if USE_PLANAR_POSE_SOLVER
+	tf::Transform c2w;
+	double ppe;
+
+	//the gate has already found the homography of the inliers so it is reused as the starting point
+	if(!this->planar_solver.solve(this->state.objects, this->state.pixels, this->K, c2w, ppe, this->gate_homography))
+	{
+		ROS_WARN("the planar pose solver failed to compute motion!");
+		return false;
+	}
+
+	this->state.ppe = ppe;
+	perPixelError = this->state.ppe;
 
-	std::vector<cv::Point2d> img_pts;
-	std::vector<cv::Point3d> obj_pts;
+	ROS_DEBUG_STREAM("VO PPE: " << this->state.ppe);
+
+	this->state.currentPose = c2w.inverse(); // invert back to w2c
+#else
+	const std::vector<cv::Point2f>& img_pts = this->state.pixels;
 
-	img_pts = this->state.getPixelsInOrder();
-	obj_pts = this->state.getObjectsInOrder();
+	this->objects3.resize(this->state.size());
+	for(int i = 0; i < this->state.size(); i++)
+	{
+		this->objects3[i] = cv::Point3f(this->state.objects[i].x, this->state.objects[i].y, 0);
+	}
 
 	cv::Mat rvec, tvec;
 
 	//set the initial inv w2c guess
 	this->tf2rvecAndtvec(this->state.currentPose.inverse(), tvec, rvec);
 
-	cv::solvePnP(obj_pts, img_pts, this->K, cv::noArray(), rvec, tvec, true, cv::SOLVEPNP_ITERATIVE);
+	cv::solvePnP(this->objects3, img_pts, this->K, cv::noArray(), rvec, tvec, true, cv::SOLVEPNP_ITERATIVE);
 
 
 	//compute the error for this solution
-	std::vector<cv::Point2d> proj;
-	cv::projectPoints(obj_pts, rvec, tvec, this->K, cv::noArray(), proj);
+	cv::projectPoints(this->objects3, rvec, tvec, this->K, cv::noArray(), this->back);
 	double err = 0;
-	for(int i = 0; i < proj.size(); i++)
+	for(int i = 0; i < this->back.size(); i++)
 	{
-		double dx = proj[i].x-img_pts[i].x;
-		double dy = proj[i].y-img_pts[i].y;
+		double dx = this->back[i].x-img_pts[i].x;
+		double dy = this->back[i].y-img_pts[i].y;
 		err += sqrt(dx*dx + dy*dy);
 	}
 
-	this->state.ppe = err / (double)proj.size();
+	this->state.ppe = err / (double)this->back.size();
 	perPixelError = this->state.ppe;
 
 	ROS_DEBUG_STREAM("VO PPE: " << this->state.ppe);
 
 	//get the updated transform back
 	this->state.currentPose = this->rvecAndtvec2tf(tvec, rvec).inverse(); // invert back to w2c
+#endif
 
 	ROS_DEBUG_STREAM("VO w2c: " << this->state.currentPose.getOrigin().x()  << ", " << this->state.currentPose.getOrigin().y() << ", " << this->state.currentPose.getOrigin().z());
 
@@ -107,102 +294,203 @@ bool FeatureTracker::computePose(double& perPixelError) {
 	return true;
 }
 
-void FeatureTracker::updatePose(tf::Transform w2c, ros::Time t) {
-	this->state.currentPose = w2c; // set the new pose
+/*
+ * every feature is on the plane so its pixel and plane point are related by one homography
+ * features which are outliers to the ransac homography are removed from the state
+ *
+ * returns false if too few features are left to compute the pose
+ */
+bool FeatureTracker::rejectHomographyOutliers() {
+	cv::Mat H = cv::findHomography(this->state.objects, this->state.pixels, cv::RANSAC, HOMOGRAPHY_RANSAC_THRESH * this->pixel_scale, this->status);
 
-	ROS_INFO("GRID HAS ALIGNED: UPDATING THE VO POSE AND OBJECT POSITIONS TO CORRECT FOR DRIFT" );
+	if(H.empty())
+	{
+		ROS_DEBUG("ransac could not find a homography. skipping the gate");
+		return true;
+	}
+
+	int removed = this->state.compact(this->status);
+
+	ROS_DEBUG_STREAM("homography gate removed " << removed << " features");
 
-	this->state.updateObjectPositions(this->K); // update the object positions to eliminate the drift
+	this->gate_homography = H;
 
-	//set the time at this update
-	this->state.time_at_last_realignment = t;
+	return this->state.size() >= MINIMUM_TRACKABLE_FEATURES;
 }
 
 /*
- * get more features after updating the pose
+ * the current pixels become the anchors and img becomes the image they are tracked from
  */
-void FeatureTracker::replenishFeatures(cv::Mat in) {
-	//add more features if needed
-	cv::Mat img;
-	cv::GaussianBlur(in, img, cv::Size(5, 5), FAST_BLUR_SIGMA);
+void FeatureTracker::takeKeyframe(cv::Mat img) {
+	this->state.anchors.assign(this->state.pixels.begin(), this->state.pixels.end());
 
-	if (this->state.features.size() < NUM_FEATURES) {
-		std::vector<cv::KeyPoint> fast_kp;
+	this->state.keyframeImg = img;
+	this->buildKeyframePyramid();
+
+	this->state.keyframe_features = this->state.size();
+
+	this->force_keyframe = false;
 
-		cv::FAST(img, fast_kp, FAST_THRESHOLD, true);
+	ROS_DEBUG_STREAM("new keyframe with " << this->state.keyframe_features << " features");
+}
+
+void FeatureTracker::buildKeyframePyramid() {
+	this->state.keyframe_levels = cv::buildOpticalFlowPyramid(this->state.keyframeImg, this->state.keyframePyr, cv::Size(KLT_WINDOW_SIZE, KLT_WINDOW_SIZE), KLT_PYRAMID_LEVELS);
+}
+
+/*
+ * get more features after updating the pose
+ * tops the feature count up to num_features
+ *
+ * the image is split into cells of min_feature_dist. FAST only runs on the cells which hold no
+ * feature, each padded by min_feature_dist so corners near the cell border see their whole circle,
+ * and the strongest corner inside of each cell is its candidate. the strongest candidates are added
+ * first and only if no feature in the 3x3 cell neighborhood is closer than min_feature_dist, so the
+ * features stay spread over the image.
+ *
+ * in keyframe mode features are only added when a new keyframe is taken so every feature is anchored
+ * in the keyframe it is tracked from
+ */
+void FeatureTracker::replenishFeatures(cv::Mat in, int num_features) {
+#if USE_KEYFRAMES
+	if(!this->needKeyframe())
+	{
+		return;
+	}
+#endif
 
-		int needed = NUM_FEATURES - this->state.features.size();
+	// the blurred image is only used to find new corners. tracking uses the image as it came in
+	if (this->state.size() < num_features) {
+		int needed = num_features - this->state.size();
 
 		ROS_DEBUG_STREAM("need " << needed << "more features");
 
-		/*cv::flann::Index tree;
+		const int cell = std::max(1, cvRound(this->min_feature_dist));
+		const int grid_cols = (in.cols + cell - 1) / cell;
+		const int grid_rows = (in.rows + cell - 1) / cell;
+		const cv::Rect image_rect(0, 0, in.cols, in.rows);
+
+		auto cellOf = [&](cv::Point2f pt, int& c, int& r){
+			c = std::min(std::max((int)(pt.x / cell), 0), grid_cols - 1);
+			r = std::min(std::max((int)(pt.y / cell), 0), grid_rows - 1);
+		};
 
-		if (this->state.features.size() > 0) {
-			std::vector<cv::Point2f> prev = this->state.getPixels2fInOrder();
-			tree = cv::flann::Index(cv::Mat(prev).reshape(1),
-					cv::flann::KDTreeIndexParams());
-		}*/
+		//the features in each cell, tracked and new
+		std::vector<std::vector<cv::Point2f> > cells(grid_cols * grid_rows);
 
-		//image which is used to check if a close feature already exists
-		cv::Mat checkImg = cv::Mat::zeros(img.size(), CV_8U);
-		for(auto e : this->state.features)
+		for(auto e : this->state.pixels)
 		{
-			cv::drawMarker(checkImg, e.px, cv::Scalar(255), cv::MARKER_SQUARE, MIN_NEW_FEATURE_DIST * 2, MIN_NEW_FEATURE_DIST);
+			int c, r;
+			cellOf(e, c, r);
+			cells.at(r * grid_cols + c).push_back(e);
 		}
 
+		// the strongest corner of every empty cell
+		std::vector<cv::KeyPoint> candidates;
+		std::vector<cv::KeyPoint> fast_kp;
+		cv::Mat patch;
 
+		for(int r = 0; r < grid_rows; r++)
+		{
+			for(int c = 0; c < grid_cols; c++)
+			{
+				if(!cells.at(r * grid_cols + c).empty())
+				{
+					continue;
+				}
 
-		for (int i = 0; i < needed && i < fast_kp.size(); i++) {
-			/*if (this->state.features.size() > 0) {
-				//make sure that this corner is not too close to any old corners
-				std::vector<float> query;
-				query.push_back(fast_kp.at(i).pt.x);
-				query.push_back(fast_kp.at(i).pt.y);
+				cv::Rect cell_rect = cv::Rect(c * cell, r * cell, cell, cell) & image_rect;
+				cv::Rect search = cv::Rect(cell_rect.x - cell, cell_rect.y - cell, cell_rect.width + 2 * cell, cell_rect.height + 2 * cell) & image_rect;
 
-				std::vector<int> indexes;
-				std::vector<float> dists;
+				// the blur reads the pixels around the roi so the patches match a blur of the whole image
+				cv::GaussianBlur(in(search), patch, cv::Size(5, 5), FAST_BLUR_SIGMA);
 
-				tree.knnSearch(query, indexes, dists, 1);
+				fast_kp.clear();
+				cv::FAST(patch, fast_kp, this->fast_threshold, true);
 
-				if (dists.front() < MIN_NEW_FEATURE_DIST) // if this featrue is too close to a already tracked feature skip it
+				int best = -1;
+				for(int i = 0; i < fast_kp.size(); i++)
 				{
-					continue;
+					fast_kp.at(i).pt.x += search.x;
+					fast_kp.at(i).pt.y += search.y;
+
+					if(!cell_rect.contains(cv::Point((int)fast_kp.at(i).pt.x, (int)fast_kp.at(i).pt.y)))
+					{
+						continue;
+					}
+
+					if(best == -1 || fast_kp.at(i).response > fast_kp.at(best).response)
+					{
+						best = i;
+					}
 				}
-			}*/
 
-			//check if there is already a close feature
-			if(checkImg.at<unsigned char>(fast_kp.at(i).pt))
+				if(best != -1)
+				{
+					candidates.push_back(fast_kp.at(best));
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const cv::KeyPoint& a, const cv::KeyPoint& b){return a.response > b.response;});
+
+		// any feature closer than a cell is in the 3x3 neighborhood
+		auto isFree = [&](cv::Point2f pt, int c, int r){
+			for(int rr = std::max(r - 1, 0); rr <= std::min(r + 1, grid_rows - 1); rr++)
 			{
-				ROS_DEBUG("feature too close to previous feature, not adding");
-				needed++; // we need one more now
-				continue;
+				for(int cc = std::max(c - 1, 0); cc <= std::min(c + 1, grid_cols - 1); cc++)
+				{
+					for(auto& f : cells.at(rr * grid_cols + cc))
+					{
+						cv::Point2f d = f - pt;
+						if(d.x * d.x + d.y * d.y < cell * cell)
+						{
+							return false;
+						}
+					}
+				}
 			}
+			return true;
+		};
 
-			Feature new_ft;
+		for (int i = 0; needed > 0 && i < candidates.size(); i++) {
+			cv::Point2f pt = candidates.at(i).pt;
 
-			new_ft.px = fast_kp.at(i).pt;
+			int c, r;
+			cellOf(pt, c, r);
 
-			bool valid = new_ft.computeObjectPosition(this->state.currentPose, this->K); // corresponf to a 3d point
+			if(!isFree(pt, c, r))
+			{
+				continue;
+			}
+
+			cv::Point2f obj;
+
+			bool valid = projectToPlane(pt, this->state.currentPose, this->K, obj); // corresponf to a 3d point
 
 			if(valid) // feature is valid add it
 			{
 				ROS_DEBUG("adding new feature to vo");
-				this->state.features.push_back(new_ft);
+				this->state.push(pt, obj);
+				cells.at(r * grid_cols + c).push_back(pt);
+				needed--;
 			}
-			else //feature is aff the grid remove it
+			else
 			{
-				needed++; // we still need a new feature
-				continue;
+				ROS_DEBUG("not adding NEW feature to planar odom because it is not on the xy plane");
 			}
-
 		}
 	}
 
-	this->state.currentImg = img;
+	this->state.currentImg = in;
+
+#if USE_KEYFRAMES
+	this->takeKeyframe(in);
+#endif
 
 #if SUPER_DEBUG
 
-	cv::Mat copy = img.clone();
+	cv::Mat copy = in.clone();
 
 	copy = this->draw(copy);
 
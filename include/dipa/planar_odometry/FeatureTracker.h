@@ -19,6 +19,7 @@
 #include "opencv2/video.hpp"
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include <tf2_ros/transform_broadcaster.h>
 #include <tf2_ros/message_filter.h>
@@ -30,147 +31,50 @@
 
 #include <dipa/DipaParams.h>
 
-class FeatureTracker {
-public:
+#include <dipa/planar_odometry/PlanarOdometry.h>
 
-	struct Feature{
-		cv::Point2f px;
-		tf::Vector3 obj;
-
-		bool computeObjectPosition(tf::Transform w2c, cv::Mat_<float> K)
-		{
-			tf::Vector3 pixel = tf::Vector3((px.x - K(2)) / K(0), (px.y - K(5)) / K(4), 1.0);
-
-			tf::Vector3 dir = w2c * pixel - w2c.getOrigin();
-
-			double dt = (-w2c.getOrigin().z() / dir.z());
-
-			if(dt <= 0)
-			{
-				ROS_DEBUG("removing NEW feature from planar odom because it is not on the xy plane");
-				return false;
-			}
-			else
-			{
-				obj = w2c.getOrigin() + dir * dt;
-				return true;
-			}
-		}
-	};
-
-	struct VOState{
-		std::vector<Feature> features;
-
-		ros::Time time_at_last_realignment;
-
-		double ppe;
-
-		cv::Mat currentImg; // the image that the features are currently in
-
-		tf::Transform currentPose; // w2c transform
-
-		std::vector<cv::Point2d> getPixelsInOrder(){
-			std::vector<cv::Point2d> pixels;
-
-			for(auto e : features)
-			{
-				pixels.push_back(cv::Point2d(e.px.x, e.px.y));
-			}
-
-			return pixels;
-		}
-
-		std::vector<cv::Point2f> getPixels2fInOrder(){
-			std::vector<cv::Point2f> pixels;
-
-			for(auto e : features)
-			{
-				pixels.push_back(e.px);
-			}
-
-			return pixels;
-		}
-
-		std::vector<cv::Point3d> getObjectsInOrder(){
-			std::vector<cv::Point3d> obj;
-
-			for(auto e : features)
-			{
-				obj.push_back(cv::Point3d(e.obj.x(), e.obj.y(), e.obj.z()));
-			}
-
-			return obj;
-		}
-
-		double getTimeSinceLastRealignment(ros::Time t){
-			if(this->time_at_last_realignment == ros::Time(0))
-			{
-				ROS_DEBUG("setting the first alignment time for dataset");
-				this->time_at_last_realignment = t;
-			}
-			return (t - this->time_at_last_realignment).toSec();
-		}
-
-		/*
-		 * uses the current pose and current pixels to determine the 3d position of the objects
-		 * assumes that all pixels lie on a plane
-		 */
-		void updateObjectPositions(cv::Mat_<float> K)
-		{
-			for(int i = 0; i < features.size(); i++)
-			{
-				tf::Vector3 pixel = tf::Vector3((features.at(i).px.x - K(2)) / K(0), (features.at(i).px.y - K(5)) / K(4), 1.0);
-
-				tf::Vector3 dir = currentPose * pixel - currentPose.getOrigin();
-
-				double dt = (-currentPose.getOrigin().z() / dir.z());
-
-				if(dt <= 0)
-				{
-					ROS_DEBUG("removing feature from planar odom because it is not on the xy plane");
-					//remove this feature it is not on the plane
-					features.erase(features.begin() + i);
-					i--;
-				}
-				else
-				{
-					features.at(i).obj = currentPose.getOrigin() + dir * dt;
-				}
-			}
-
-			if(features.size() <= 4)
-			{
-				ROS_WARN("planar odometry has too few features!");
-			}
-		}
-	};
-
-	cv::Mat_<float> K;
-	VOState state;
+class FeatureTracker : public PlanarOdometry {
+public:
 
 	FeatureTracker();
 	virtual ~FeatureTracker();
 
 	void updateFeatures(cv::Mat img);
 
+	void updateFeatures(cv::Mat img, tf::Transform w2c_predicted);
+
+	void predictPixels(tf::Transform w2c_predicted, std::vector<cv::Point2f>& guesses);
+
 	bool computePose(double& perPixelError);
 
-	void updatePose(tf::Transform w2c, ros::Time t);
+	bool rejectHomographyOutliers();
 
-	void replenishFeatures(cv::Mat img);
+	void replenishFeatures(cv::Mat img, int num_features);
 
 	void tf2rvecAndtvec(tf::Transform tf, cv::Mat& tvec, cv::Mat& rvec);
 
 	tf::Transform rvecAndtvec2tf(cv::Mat tvec, cv::Mat rvec);
 
-	cv::Mat draw(cv::Mat in)
-	{
-		for(auto e : this->state.features)
-		{
-			cv::drawMarker(in, e.px, cv::Scalar(255, 0, 0));
-		}
-		return in;
-	}
+private:
+
+	// the ransac homography of the gate for the current frame. empty if the gate did not run
+	cv::Mat gate_homography;
+
+	// scratch buffers reused every frame so tracking does not allocate once they have grown
+	std::vector<cv::Point2f> flowed;
+	std::vector<cv::Point2f> back;
+	std::vector<uchar> status;
+	std::vector<uchar> status_back;
+	std::vector<cv::Point3f> objects3; // only used by the solvePnP path
+
+	void takeKeyframe(cv::Mat img);
+
+	void buildKeyframePyramid();
+
+	/*
+	 * flows the features into img. if use_guesses is set flowed already holds the starting pixels
+	 */
+	void flowFeatures(cv::Mat img, bool use_guesses);
 };
 
 #endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_FEATURETRACKER_H_ */
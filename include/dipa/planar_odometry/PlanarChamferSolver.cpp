@@ -0,0 +1,218 @@
+/*
+ * PlanarChamferSolver.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/PlanarChamferSolver.h>
+
+PlanarChamferSolver::PlanarChamferSolver() {
+	this->truncation = 0;
+}
+
+PlanarChamferSolver::~PlanarChamferSolver() {
+
+}
+
+void PlanarChamferSolver::setDistance(const cv::Mat_<float>& dist, cv::Rect roi, double truncation)
+{
+	this->truncation = truncation;
+	this->roi = roi;
+
+	cv::threshold(dist, this->dist, truncation, truncation, cv::THRESH_TRUNC);
+
+	// central differences
+	cv::Sobel(this->dist, this->dx, CV_32F, 1, 0, 1, 0.5);
+	cv::Sobel(this->dist, this->dy, CV_32F, 0, 1, 1, 0.5);
+}
+
+void PlanarChamferSolver::clear()
+{
+	this->dist.release();
+	this->dx.release();
+	this->dy.release();
+}
+
+void PlanarChamferSolver::project(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t)
+{
+	int n = pts.size();
+
+	this->xc.resize(n);
+	this->yc.resize(n);
+	this->zc.resize(n);
+	this->u.resize(n);
+	this->v.resize(n);
+
+	float fx = K(0), cx = K(2), fy = K(4), cy = K(5);
+
+	// the points are on z = 0 so only the first two columns of R are needed
+	float r00 = R(0, 0), r01 = R(0, 1), r10 = R(1, 0), r11 = R(1, 1), r20 = R(2, 0), r21 = R(2, 1);
+	float t0 = t[0], t1 = t[1], t2 = t[2];
+
+	const cv::Point2d* p = pts.data();
+	float* X = this->xc.data();
+	float* Y = this->yc.data();
+	float* Z = this->zc.data();
+	float* U = this->u.data();
+	float* V = this->v.data();
+
+	for(int i = 0; i < n; i++)
+	{
+		float px = p[i].x, py = p[i].y;
+		X[i] = r00 * px + r01 * py + t0;
+		Y[i] = r10 * px + r11 * py + t1;
+		Z[i] = r20 * px + r21 * py + t2;
+	}
+
+	for(int i = 0; i < n; i++)
+	{
+		float iz = 1.0f / Z[i];
+		U[i] = fx * X[i] * iz + cx;
+		V[i] = fy * Y[i] * iz + cy;
+	}
+}
+
+bool PlanarChamferSolver::sample(int i, float& d, float& gx, float& gy)
+{
+	float x = this->u[i], y = this->v[i];
+
+	if(this->zc[i] <= 0 || x < this->roi.x || y < this->roi.y || x >= this->roi.x + this->roi.width - 1 || y >= this->roi.y + this->roi.height - 1)
+	{
+		return false;
+	}
+
+	int x0 = (int)x, y0 = (int)y;
+	float ax = x - x0, ay = y - y0;
+
+	float w00 = (1 - ax) * (1 - ay), w01 = ax * (1 - ay), w10 = (1 - ax) * ay, w11 = ax * ay;
+
+	auto bilinear = [&](const cv::Mat_<float>& m){
+		const float* r0 = m.ptr<float>(y0) + x0;
+		const float* r1 = m.ptr<float>(y0 + 1) + x0;
+		return w00 * r0[0] + w01 * r0[1] + w10 * r1[0] + w11 * r1[1];
+	};
+
+	d = bilinear(this->dist);
+	gx = bilinear(this->dx);
+	gy = bilinear(this->dy);
+
+	return true;
+}
+
+double PlanarChamferSolver::step(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, double huber, cv::Matx33d& R, cv::Vec3d& t)
+{
+	if(this->empty())
+	{
+		return -1;
+	}
+
+	this->project(pts, K, R, t);
+
+	double fx = K(0), fy = K(4);
+
+	cv::Matx66d JtJ;
+	cv::Matx61d Jtr;
+	double sse = 0;
+	int n = 0;
+
+	for(int i = 0; i < pts.size(); i++)
+	{
+		float d, gx, gy;
+
+		// truncated points have no gradient to follow
+		if(!this->sample(i, d, gx, gy) || d >= this->truncation)
+		{
+			continue;
+		}
+
+		double iz = 1.0 / this->zc[i];
+		cv::Vec3d Xc(this->xc[i], this->yc[i], this->zc[i]);
+
+		// the point should be on an edge
+		double r = -d;
+
+		sse += r * r;
+		n++;
+
+		// derivative of the sampled distance by the camera point
+		cv::Vec3d g(gx * fx * iz, gy * fy * iz, -(gx * fx * Xc[0] + gy * fy * Xc[1]) * iz * iz);
+
+		// the camera point moves by dtheta x Xc + dt
+		cv::Vec3d g_theta = Xc.cross(g);
+		double J[6] = {g_theta[0], g_theta[1], g_theta[2], g[0], g[1], g[2]};
+
+		double w = (fabs(r) <= huber) ? 1.0 : huber / fabs(r);
+
+		for(int a = 0; a < 6; a++)
+		{
+			for(int b = a; b < 6; b++)
+			{
+				JtJ(a, b) += w * J[a] * J[b];
+			}
+			Jtr(a) += w * J[a] * r;
+		}
+	}
+
+	if(n < 6)
+	{
+		return -1;
+	}
+
+	for(int a = 0; a < 6; a++)
+	{
+		for(int b = 0; b < a; b++)
+		{
+			JtJ(a, b) = JtJ(b, a);
+		}
+	}
+
+	cv::Matx61d delta;
+	if(!cv::solve(JtJ, Jtr, delta, cv::DECOMP_CHOLESKY))
+	{
+		ROS_DEBUG("planar chamfer step is degenerate");
+		return -1;
+	}
+
+	cv::Matx33d dR = PlanarPoseSolver::expSO3(cv::Vec3d(delta(0), delta(1), delta(2)));
+
+	R = dR * R;
+	t = dR * t + cv::Vec3d(delta(3), delta(4), delta(5));
+
+	return sqrt(sse / n);
+}
+
+double PlanarChamferSolver::error(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t, int& visible, int& inliers)
+{
+	visible = 0;
+	inliers = 0;
+
+	if(this->empty())
+	{
+		return -1;
+	}
+
+	this->project(pts, K, R, t);
+
+	double sum = 0;
+
+	for(int i = 0; i < pts.size(); i++)
+	{
+		float d, gx, gy;
+
+		if(!this->sample(i, d, gx, gy))
+		{
+			continue;
+		}
+
+		visible++;
+
+		if(d < this->truncation)
+		{
+			sum += d;
+			inliers++;
+		}
+	}
+
+	return (inliers > 0) ? sum / inliers : -1;
+}
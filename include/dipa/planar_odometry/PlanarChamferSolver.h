@@ -0,0 +1,72 @@
+/*
+ * PlanarChamferSolver.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARCHAMFERSOLVER_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARCHAMFERSOLVER_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#include <dipa/DipaParams.h>
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+/*
+ * refines the pose of a camera by pulling points on the z = 0 plane onto the edges of an image.
+ *
+ * the edges are given as a truncated distance transform which is built once per frame. every point
+ * is projected and the distance map is sampled under it so there is no nearest neighbour search.
+ * points far from every edge sit on the flat truncated part of the map and stop pulling, which lets
+ * the alignment degrade smoothly when parts of the grid are occluded.
+ */
+class PlanarChamferSolver {
+public:
+	PlanarChamferSolver();
+	virtual ~PlanarChamferSolver();
+
+	/*
+	 * takes the distance in pixels to the nearest edge over the whole image. only points inside of
+	 * the roi are considered visible. distances are truncated at truncation
+	 */
+	void setDistance(const cv::Mat_<float>& dist, cv::Rect roi, double truncation);
+
+	void clear();
+
+	bool empty(){return this->dist.empty();}
+
+	/*
+	 * one gauss newton step with huber weights on the pose (R, t take world points into the camera)
+	 *
+	 * returns the rms distance of the inlier points before the step or -1 if the step is degenerate
+	 */
+	double step(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, double huber, cv::Matx33d& R, cv::Vec3d& t);
+
+	/*
+	 * the mean distance of the visible points closer than the truncation to an edge
+	 */
+	double error(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t, int& visible, int& inliers);
+
+private:
+
+	cv::Mat_<float> dist, dx, dy;
+	cv::Rect roi;
+	double truncation;
+
+	// the projected points as flat arrays so the projection vectorizes
+	std::vector<float> xc, yc, zc, u, v;
+
+	void project(const std::vector<cv::Point2d>& pts, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t);
+
+	/*
+	 * bilinear sample of the map at the projection of point i. returns false if it is not visible
+	 */
+	bool sample(int i, float& d, float& gx, float& gy);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARCHAMFERSOLVER_H_ */
@@ -0,0 +1,285 @@
+/*
+ * PlanarESM.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/PlanarESM.h>
+
+PlanarESM::PlanarESM() {
+	this->template_points.reserve(ESM_MAX_SAMPLES);
+	this->template_values.reserve(ESM_MAX_SAMPLES);
+	this->template_gradients.reserve(ESM_MAX_SAMPLES);
+}
+
+PlanarESM::~PlanarESM() {
+
+}
+
+void PlanarESM::setTemplate(const cv::Mat& img, tf::Transform w2c, cv::Mat_<float> K, cv::Rect region) {
+	this->K = K;
+
+	this->template_points.clear();
+	this->template_values.clear();
+	this->template_gradients.clear();
+
+	const int border = 2;
+
+	// only the pixels inside of the region which have room for their gradient
+	region &= cv::Rect(border, border, img.cols - 2 * border, img.rows - 2 * border);
+
+	if(region.area() <= 0)
+	{
+		return;
+	}
+
+	//count the gradient pixels first so the samples can be spread evenly over the region
+	int candidates = 0;
+	for(int y = region.y; y < region.y + region.height; y += ESM_SAMPLE_STEP)
+	{
+		const uchar* row = img.ptr<uchar>(y);
+		for(int x = region.x; x < region.x + region.width; x += ESM_SAMPLE_STEP)
+		{
+			int gx = row[x + 1] - row[x - 1];
+			int gy = img.ptr<uchar>(y + 1)[x] - img.ptr<uchar>(y - 1)[x];
+
+			if(abs(gx) + abs(gy) >= 2 * ESM_MIN_GRADIENT)
+			{
+				candidates++;
+			}
+		}
+	}
+
+	int stride = std::max((candidates + ESM_MAX_SAMPLES - 1) / ESM_MAX_SAMPLES, 1);
+	int index = 0;
+
+	tf::Vector3 origin = w2c.getOrigin();
+
+	// the template camera takes plane points to Xc = r1 * x + r2 * y + t
+	tf::Matrix3x3 Rc = w2c.getBasis().transpose();
+	tf::Vector3 r1 = Rc.getColumn(0), r2 = Rc.getColumn(1);
+	tf::Vector3 tc = -(Rc * origin);
+
+	for(int y = region.y; y < region.y + region.height; y += ESM_SAMPLE_STEP)
+	{
+		const uchar* row = img.ptr<uchar>(y);
+		for(int x = region.x; x < region.x + region.width; x += ESM_SAMPLE_STEP)
+		{
+			int gx = row[x + 1] - row[x - 1];
+			int gy = img.ptr<uchar>(y + 1)[x] - img.ptr<uchar>(y - 1)[x];
+
+			if(abs(gx) + abs(gy) < 2 * ESM_MIN_GRADIENT)
+			{
+				continue;
+			}
+
+			if((index++) % stride != 0)
+			{
+				continue;
+			}
+
+			tf::Vector3 dir = w2c * tf::Vector3((x - K(2)) / K(0), (y - K(5)) / K(4), 1.0) - origin;
+
+			double dt = -origin.z() / dir.z();
+
+			if(dt <= 0)
+			{
+				continue; // the plane is not under this pixel
+			}
+
+			tf::Vector3 obj = origin + dir * dt;
+
+			// move the pixel gradient onto the plane through the derivative of the projection
+			tf::Vector3 Xc = r1 * obj.x() + r2 * obj.y() + tc;
+			double iz = 1.0 / Xc.z();
+			double gu = 0.5 * gx, gv = 0.5 * gy;
+
+			tf::Vector3 g_cam(gu * K(0) * iz, gv * K(4) * iz, -(gu * K(0) * Xc.x() + gv * K(4) * Xc.y()) * iz * iz);
+
+			this->template_points.push_back(cv::Point2f(obj.x(), obj.y()));
+			this->template_values.push_back(row[x]);
+			this->template_gradients.push_back(cv::Point2f(g_cam.dot(r1), g_cam.dot(r2)));
+		}
+	}
+
+	ROS_DEBUG_STREAM("esm template has " << this->template_points.size() << " samples");
+}
+
+void PlanarESM::rescale(double factor) {
+	if(this->K.empty())
+	{
+		return;
+	}
+
+	// K may be shared with frames which still use the old resolution
+	this->K = this->K.clone();
+	this->K(0, 0) *= factor;
+	this->K(0, 2) *= factor;
+	this->K(1, 1) *= factor;
+	this->K(1, 2) *= factor;
+
+	// the template gradients are on the plane so they do not depend on the resolution
+}
+
+bool PlanarESM::align(const cv::Mat& img, tf::Transform& w2c, double& rms) {
+	if(!this->hasTemplate())
+	{
+		return false;
+	}
+
+	ros::WallTime start = ros::WallTime::now();
+
+	tf::Transform c2w = w2c.inverse();
+
+	cv::Matx33d R = cv::Matx33d(c2w.getBasis().getRow(0).x(), c2w.getBasis().getRow(0).y(), c2w.getBasis().getRow(0).z(),
+			c2w.getBasis().getRow(1).x(), c2w.getBasis().getRow(1).y(), c2w.getBasis().getRow(1).z(),
+			c2w.getBasis().getRow(2).x(), c2w.getBasis().getRow(2).y(), c2w.getBasis().getRow(2).z());
+	cv::Vec3d t = cv::Vec3d(c2w.getOrigin().x(), c2w.getOrigin().y(), c2w.getOrigin().z());
+
+	double fx = this->K(0), cx = this->K(2), fy = this->K(4), cy = this->K(5);
+
+	int count = 0;
+	double sse = 0;
+
+	// the last pass only measures the error of the final pose
+	for(int it = 0; it <= ESM_ITERATIONS; it++)
+	{
+		cv::Matx66d JtJ;
+		cv::Matx61d Jtr;
+		count = 0;
+		sse = 0;
+
+		for(int k = 0; k < this->template_points.size(); k++)
+		{
+			cv::Vec3d Xc = R * cv::Vec3d(this->template_points[k].x, this->template_points[k].y, 0) + t;
+
+			if(Xc[2] <= 0)
+			{
+				continue;
+			}
+
+			double iz = 1.0 / Xc[2];
+			float u = fx * Xc[0] * iz + cx;
+			float v = fy * Xc[1] * iz + cy;
+
+			if(u < 2 || v < 2 || u > img.cols - 3 || v > img.rows - 3)
+			{
+				continue;
+			}
+
+			double r = this->template_values[k] - interpolate(img, u, v);
+
+			sse += r * r;
+			count++;
+
+			if(it == ESM_ITERATIONS)
+			{
+				continue;
+			}
+
+			double du_dx = fx * iz;
+			double du_dz = -fx * Xc[0] * iz * iz;
+			double dv_dy = fy * iz;
+			double dv_dz = -fy * Xc[1] * iz * iz;
+
+			// the derivative of the pixel by the plane point
+			double a = du_dx * R(0, 0) + du_dz * R(2, 0), b = du_dx * R(0, 1) + du_dz * R(2, 1);
+			double c = dv_dy * R(1, 0) + dv_dz * R(2, 0), d = dv_dy * R(1, 1) + dv_dz * R(2, 1);
+			double det = a * d - b * c;
+
+			if(fabs(det) < 1e-12)
+			{
+				continue;
+			}
+
+			// the template gradient in this image's pixels is the gradient on the plane through the inverse warp
+			double tgx = (this->template_gradients[k].x * d - this->template_gradients[k].y * c) / det;
+			double tgy = (-this->template_gradients[k].x * b + this->template_gradients[k].y * a) / det;
+
+			//esm uses the mean of the current image gradient and the template gradient
+			double gx = 0.5 * (0.5 * (interpolate(img, u + 1, v) - interpolate(img, u - 1, v)) + tgx);
+			double gy = 0.5 * (0.5 * (interpolate(img, u, v + 1) - interpolate(img, u, v - 1)) + tgy);
+
+			// the camera point moves by dtheta x Xc + dt
+			double J[6] = {gx * du_dz * Xc[1] + gy * (-dv_dy * Xc[2] + dv_dz * Xc[1]),
+					gx * (du_dx * Xc[2] - du_dz * Xc[0]) + gy * (-dv_dz * Xc[0]),
+					gx * (-du_dx * Xc[1]) + gy * dv_dy * Xc[0],
+					gx * du_dx,
+					gy * dv_dy,
+					gx * du_dz + gy * dv_dz};
+
+			for(int i = 0; i < 6; i++)
+			{
+				for(int j = 0; j < 6; j++)
+				{
+					JtJ(i, j) += J[i] * J[j];
+				}
+				Jtr(i) += J[i] * r;
+			}
+		}
+
+		if(it == ESM_ITERATIONS)
+		{
+			break;
+		}
+
+		if(count < ESM_MIN_SAMPLES)
+		{
+			ROS_DEBUG("esm lost the template");
+			return false;
+		}
+
+		cv::Matx61d delta;
+		if(!cv::solve(JtJ, Jtr, delta, cv::DECOMP_CHOLESKY))
+		{
+			ROS_DEBUG("esm step is degenerate");
+			return false;
+		}
+
+		cv::Matx33d dR = PlanarPoseSolver::expSO3(cv::Vec3d(delta(0), delta(1), delta(2)));
+
+		R = dR * R;
+		t = dR * t + cv::Vec3d(delta(3), delta(4), delta(5));
+
+		if(cv::norm(delta) < 1e-6)
+		{
+			it = ESM_ITERATIONS - 1; // converged. skip to the measuring pass
+		}
+	}
+
+	if(count < ESM_MIN_SAMPLES)
+	{
+		return false;
+	}
+
+	rms = sqrt(sse / count);
+
+	double elapsed = (ros::WallTime::now() - start).toSec();
+
+	ROS_DEBUG_STREAM("esm rms: " << rms << " with " << count << " samples in " << elapsed * 1000 << " ms");
+	ROS_WARN_STREAM_COND(elapsed > ESM_TARGET_TIME, "esm took " << elapsed * 1000 << " ms which is over its target of " << ESM_TARGET_TIME * 1000 << " ms");
+
+	if(rms > ESM_MAX_RMS)
+	{
+		return false;
+	}
+
+	w2c = tf::Transform(tf::Matrix3x3(R(0, 0), R(0, 1), R(0, 2),
+			R(1, 0), R(1, 1), R(1, 2),
+			R(2, 0), R(2, 1), R(2, 2)), tf::Vector3(t[0], t[1], t[2])).inverse();
+
+	return true;
+}
+
+float PlanarESM::interpolate(const cv::Mat& img, float x, float y) {
+	int x0 = (int)x;
+	int y0 = (int)y;
+	float ax = x - x0;
+	float ay = y - y0;
+
+	const uchar* row0 = img.ptr<uchar>(y0);
+	const uchar* row1 = img.ptr<uchar>(y0 + 1);
+
+	return (1 - ay) * ((1 - ax) * row0[x0] + ax * row0[x0 + 1]) + ay * ((1 - ax) * row1[x0] + ax * row1[x0 + 1]);
+}
@@ -0,0 +1,76 @@
+/*
+ * PlanarESM.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARESM_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARESM_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+#include <tf/tf.h>
+
+#include <dipa/DipaParams.h>
+
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+/*
+ * dense alignment of a frame to the previous one with efficient second order minimization
+ *
+ * the warp is the homography the z = 0 plane induces between the two cameras so the unknowns are
+ * the 6 dof of the new camera pose instead of the 8 of a free homography.
+ *
+ * the template gradient is stored on the plane. every iteration maps it into the current image
+ * through the inverse of the local warp, which is the gradient the warped image has at the
+ * solution. the jacobian is the mean of that and the current image gradient, both around the
+ * current pose, which gives esm second order convergence without computing an image hessian.
+ *
+ * all buffers are sized once so aligning a frame does not allocate.
+ */
+class PlanarESM {
+public:
+
+	PlanarESM();
+	virtual ~PlanarESM();
+
+	/*
+	 * samples the gradient pixels of img inside of region and the plane points under them
+	 * w2c is the pose of the camera which took img
+	 */
+	void setTemplate(const cv::Mat& img, tf::Transform w2c, cv::Mat_<float> K, cv::Rect region);
+
+	void clearTemplate(){this->template_points.clear();}
+
+	bool hasTemplate(){return this->template_points.size() > 0;}
+
+	/*
+	 * moves the template to a processing resolution factor times the old one
+	 */
+	void rescale(double factor);
+
+	/*
+	 * w2c is the guess for the pose of the camera which took img and is set to the aligned pose
+	 * rms is the root mean square intensity error of the aligned samples
+	 *
+	 * returns false if the alignment did not converge to a good pose
+	 */
+	bool align(const cv::Mat& img, tf::Transform& w2c, double& rms);
+
+private:
+
+	cv::Mat_<float> K;
+
+	// one entry per sample of the template
+	std::vector<cv::Point2f> template_points; // plane xy
+	std::vector<float> template_values;
+	std::vector<cv::Point2f> template_gradients; // intensity per meter along plane x and y
+
+	static float interpolate(const cv::Mat& img, float x, float y);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARESM_H_ */
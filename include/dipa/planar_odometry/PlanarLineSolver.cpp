@@ -0,0 +1,98 @@
+/*
+ * PlanarLineSolver.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/PlanarLineSolver.h>
+
+PlanarLineSolver::PlanarLineSolver() {
+
+}
+
+PlanarLineSolver::~PlanarLineSolver() {
+
+}
+
+double PlanarLineSolver::step(const std::vector<Correspondence>& c, cv::Mat_<float> K, double huber, cv::Matx33d& R, cv::Vec3d& t)
+{
+	double fx = K(0), cx = K(2), fy = K(4), cy = K(5);
+
+	cv::Matx66d JtJ;
+	cv::Matx61d Jtr;
+	double sse = 0;
+	int n = 0;
+
+	for(auto& e : c)
+	{
+		const cv::Point2d pts[2] = {e.a, e.b};
+
+		for(int k = 0; k < 2; k++)
+		{
+			cv::Vec3d Xc = R * cv::Vec3d(pts[k].x, pts[k].y, 0) + t;
+
+			if(Xc[2] <= 0)
+			{
+				return -1;
+			}
+
+			double iz = 1.0 / Xc[2];
+			double u = fx * Xc[0] * iz + cx;
+			double v = fy * Xc[1] * iz + cy;
+
+			// the point should be on the line
+			double r = e.line[2] - (e.line[0] * u + e.line[1] * v);
+
+			sse += r * r;
+			n++;
+
+			// derivative of the predicted distance by the camera point
+			cv::Vec3d g(e.line[0] * fx * iz, e.line[1] * fy * iz, -(e.line[0] * fx * Xc[0] + e.line[1] * fy * Xc[1]) * iz * iz);
+
+			// the camera point moves by dtheta x Xc + dt
+			cv::Vec3d g_theta = Xc.cross(g);
+			double J[6] = {g_theta[0], g_theta[1], g_theta[2], g[0], g[1], g[2]};
+
+			double w = (fabs(r) <= huber) ? 1.0 : huber / fabs(r);
+
+			for(int i = 0; i < 6; i++)
+			{
+				for(int j = 0; j < 6; j++)
+				{
+					JtJ(i, j) += w * J[i] * J[j];
+				}
+				Jtr(i) += w * J[i] * r;
+			}
+		}
+	}
+
+	if(n == 0)
+	{
+		return -1;
+	}
+
+	cv::Matx61d delta;
+	if(!cv::solve(JtJ, Jtr, delta, cv::DECOMP_CHOLESKY))
+	{
+		ROS_DEBUG("planar line step is degenerate");
+		return -1;
+	}
+
+	cv::Matx33d dR = PlanarPoseSolver::expSO3(cv::Vec3d(delta(0), delta(1), delta(2)));
+
+	R = dR * R;
+	t = dR * t + cv::Vec3d(delta(3), delta(4), delta(5));
+
+	return sqrt(sse / n);
+}
+
+double PlanarLineSolver::distance(const cv::Vec3d& line, cv::Point2d plane_pt, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t)
+{
+	cv::Vec3d Xc = R * cv::Vec3d(plane_pt.x, plane_pt.y, 0) + t;
+
+	double u = K(0) * Xc[0] / Xc[2] + K(2);
+	double v = K(4) * Xc[1] / Xc[2] + K(5);
+
+	return line[0] * u + line[1] * v - line[2];
+}
@@ -0,0 +1,51 @@
+/*
+ * PlanarLineSolver.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARLINESOLVER_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARLINESOLVER_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+#include <dipa/DipaParams.h>
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+/*
+ * refines the pose of a camera from lines on the z = 0 plane matched to lines in the image
+ *
+ * every correspondence gives two plane points on the model line. the residual of each is the pixel
+ * distance of its projection from the detected line, so a line constrains the pose across itself
+ * but not along itself. lines from both grid directions are needed for a full pose.
+ */
+class PlanarLineSolver {
+public:
+
+	struct Correspondence{
+		cv::Point2d a, b; // plane xy of two points on the model line
+		cv::Vec3d line; // the detected line nx * u + ny * v = rho as (nx, ny, rho) in pixels
+	};
+
+	PlanarLineSolver();
+	virtual ~PlanarLineSolver();
+
+	/*
+	 * one gauss newton step with huber weights on the pose (R, t take world points into the camera)
+	 *
+	 * returns the rms point to line distance in pixels before the step or -1 if a point is behind
+	 * the camera or the step is degenerate
+	 */
+	double step(const std::vector<Correspondence>& c, cv::Mat_<float> K, double huber, cv::Matx33d& R, cv::Vec3d& t);
+
+	/*
+	 * signed pixel distance of the projection of a plane point from the line
+	 */
+	static double distance(const cv::Vec3d& line, cv::Point2d plane_pt, cv::Mat_<float> K, const cv::Matx33d& R, const cv::Vec3d& t);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARLINESOLVER_H_ */
@@ -0,0 +1,95 @@
+/*
+ * PlanarOdometry.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/PlanarOdometry.h>
+
+PlanarOdometry::PlanarOdometry() {
+	this->state.keyframe_features = 0;
+	this->state.next_id = 0;
+
+	this->force_keyframe = false;
+
+	this->fast_threshold = FAST_THRESHOLD;
+	this->min_feature_dist = MIN_NEW_FEATURE_DIST;
+	this->pixel_scale = 1;
+}
+
+PlanarOdometry::~PlanarOdometry() {
+
+}
+
+void PlanarOdometry::updatePose(tf::Transform w2c, ros::Time t) {
+	this->state.currentPose = w2c; // set the new pose
+
+	ROS_INFO("GRID HAS ALIGNED: UPDATING THE VO POSE AND OBJECT POSITIONS TO CORRECT FOR DRIFT" );
+
+	this->state.updateObjectPositions(this->K); // update the object positions to eliminate the drift
+
+	//set the time at this update
+	this->state.time_at_last_realignment = t;
+
+	//the anchors belong to the old objects so the next frame has to start a new keyframe
+	this->force_keyframe = true;
+}
+
+void PlanarOdometry::rescale(double factor, cv::Size size) {
+	for(int i = 0; i < this->state.size(); i++)
+	{
+		this->state.pixels[i] *= factor;
+		this->state.anchors[i] *= factor;
+	}
+
+	int interp = (factor < 1) ? cv::INTER_AREA : cv::INTER_LINEAR;
+
+	if(!this->state.currentImg.empty())
+	{
+		cv::Mat resized;
+		cv::resize(this->state.currentImg, resized, size, 0, 0, interp);
+		this->state.currentImg = resized;
+	}
+
+	if(!this->state.keyframeImg.empty())
+	{
+		cv::Mat resized;
+		cv::resize(this->state.keyframeImg, resized, size, 0, 0, interp);
+		this->state.keyframeImg = resized;
+
+		this->buildKeyframePyramid();
+	}
+
+	ROS_DEBUG_STREAM("rescaled the vo state by " << factor << " to " << size);
+}
+
+bool PlanarOdometry::needKeyframe() {
+	if(this->force_keyframe || this->state.size() == 0 || this->state.keyframePyr.empty())
+	{
+		return true;
+	}
+
+	if(this->state.size() < KEYFRAME_MIN_OVERLAP * this->state.keyframe_features)
+	{
+		ROS_DEBUG_STREAM("keyframe overlap dropped to " << this->state.size() << " of " << this->state.keyframe_features << " features");
+		return true;
+	}
+
+	double parallax = 0;
+	for(int i = 0; i < this->state.size(); i++)
+	{
+		double dx = this->state.pixels[i].x - this->state.anchors[i].x;
+		double dy = this->state.pixels[i].y - this->state.anchors[i].y;
+		parallax += sqrt(dx * dx + dy * dy);
+	}
+	parallax /= (double)this->state.size();
+
+	if(parallax > KEYFRAME_MAX_PARALLAX * this->pixel_scale)
+	{
+		ROS_DEBUG_STREAM("keyframe parallax reached " << parallax << " pixels");
+		return true;
+	}
+
+	return false;
+}
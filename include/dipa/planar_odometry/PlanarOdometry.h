@@ -0,0 +1,252 @@
+/*
+ * PlanarOdometry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARODOMETRY_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARODOMETRY_H_
+
+#include <ros/ros.h>
+
+#include <opencv2/imgproc.hpp>
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+#include <tf/tf.h>
+
+#include <dipa/DipaParams.h>
+
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+/*
+ * interface of a visual odometry engine which tracks points on the z = 0 plane
+ *
+ * Dipa only talks to this interface so the engines can be swapped with the vo_engine parameter and benchmarked
+ * on the same data. every engine keeps its points in the shared VOState.
+ */
+class PlanarOdometry {
+public:
+
+	/*
+	 * the features are stored as parallel arrays so klt, the pose solvers and the reprojection
+	 * read the pixels and plane points directly without copying them out first
+	 *
+	 * every object lies on z = 0 so only its plane coordinates are stored
+	 */
+	struct VOState{
+		std::vector<cv::Point2f> pixels; // position of each feature in currentImg
+		std::vector<cv::Point2f> objects; // xy plane position of each feature
+		std::vector<cv::Point2f> anchors; // position of each feature in the keyframe
+		std::vector<int> ids; // unique id of each feature's track
+
+		int next_id;
+
+		ros::Time time_at_last_realignment;
+
+		double ppe;
+
+		cv::Mat currentImg; // the image that the features are currently in
+
+		cv::Mat keyframeImg; // the image the anchors are in
+		std::vector<cv::Mat> keyframePyr; // built once per keyframe and reused by every frame tracked against it
+		int keyframe_levels; // levels actually built into keyframePyr
+		int keyframe_features; // number of features when the keyframe was taken
+
+		tf::Transform currentPose; // w2c transform
+
+		int size() const {
+			return pixels.size();
+		}
+
+		void reserve(int n){
+			pixels.reserve(n);
+			objects.reserve(n);
+			anchors.reserve(n);
+			ids.reserve(n);
+			mask.reserve(n);
+		}
+
+		void push(cv::Point2f px, cv::Point2f obj){
+			pixels.push_back(px);
+			objects.push_back(obj);
+			anchors.push_back(px);
+			ids.push_back(next_id++);
+		}
+
+		/*
+		 * removes every feature whose keep flag is 0 without changing the order of the others
+		 * returns the number of removed features
+		 */
+		int compact(const std::vector<uchar>& keep){
+			ROS_ASSERT(keep.size() == pixels.size());
+
+			int j = 0;
+			for(int i = 0; i < pixels.size(); i++)
+			{
+				if(keep[i])
+				{
+					pixels[j] = pixels[i];
+					objects[j] = objects[i];
+					anchors[j] = anchors[i];
+					ids[j] = ids[i];
+					j++;
+				}
+			}
+
+			int removed = pixels.size() - j;
+
+			// shrinking never gives back the capacity
+			pixels.resize(j);
+			objects.resize(j);
+			anchors.resize(j);
+			ids.resize(j);
+
+			return removed;
+		}
+
+		double getTimeSinceLastRealignment(ros::Time t){
+			if(this->time_at_last_realignment == ros::Time(0))
+			{
+				ROS_DEBUG("setting the first alignment time for dataset");
+				this->time_at_last_realignment = t;
+			}
+			return (t - this->time_at_last_realignment).toSec();
+		}
+
+		/*
+		 * uses the current pose and current pixels to determine the 3d position of the objects
+		 * assumes that all pixels lie on a plane
+		 */
+		void updateObjectPositions(cv::Mat_<float> K)
+		{
+			mask.resize(pixels.size());
+
+			for(int i = 0; i < pixels.size(); i++)
+			{
+				mask[i] = projectToPlane(pixels[i], currentPose, K, objects[i]);
+
+				if(!mask[i])
+				{
+					ROS_DEBUG("removing feature from planar odom because it is not on the xy plane");
+				}
+			}
+
+			compact(mask);
+
+			if(pixels.size() <= 4)
+			{
+				ROS_WARN("planar odometry has too few features!");
+			}
+		}
+
+	private:
+		std::vector<uchar> mask; // reused keep flags for updateObjectPositions
+	};
+
+	/*
+	 * intersects the ray through px with the z = 0 plane
+	 * returns false if the plane is behind the camera along this ray
+	 */
+	static bool projectToPlane(cv::Point2f px, tf::Transform w2c, cv::Mat_<float> K, cv::Point2f& obj)
+	{
+		tf::Vector3 pixel = tf::Vector3((px.x - K(2)) / K(0), (px.y - K(5)) / K(4), 1.0);
+
+		tf::Vector3 dir = w2c * pixel - w2c.getOrigin();
+
+		double dt = (-w2c.getOrigin().z() / dir.z());
+
+		if(dt <= 0)
+		{
+			return false;
+		}
+
+		tf::Vector3 hit = w2c.getOrigin() + dir * dt;
+		obj = cv::Point2f(hit.x(), hit.y());
+		return true;
+	}
+
+
+	cv::Mat_<float> K;
+	VOState state;
+
+	int fast_threshold; // used by the engines which detect corners
+	double min_feature_dist; // pixels between new features at the current resolution
+	double pixel_scale; // multiplies the pixel thresholds which are tuned at the configured resolution
+
+	PlanarOdometry();
+	virtual ~PlanarOdometry();
+
+	/*
+	 * the factor from the resolution the pixel thresholds were tuned at to the one of the images
+	 */
+	void setPixelScale(double s)
+	{
+		this->pixel_scale = s;
+		this->min_feature_dist = MIN_NEW_FEATURE_DIST * s;
+	}
+
+	/*
+	 * tracks the points into img starting from the current pose
+	 */
+	virtual void updateFeatures(cv::Mat img) = 0;
+
+	/*
+	 * tracks the points into img starting from the pose predicted for it
+	 */
+	virtual void updateFeatures(cv::Mat img, tf::Transform w2c_predicted) = 0;
+
+	/*
+	 * solves the pose of the camera from the tracked points
+	 * returns false if the pose could not be computed
+	 */
+	virtual bool computePose(double& perPixelError) = 0;
+
+	/*
+	 * tops the number of tracked points up to num_features
+	 */
+	virtual void replenishFeatures(cv::Mat img, int num_features) = 0;
+
+	/*
+	 * sets the pose after a realignment and re-anchors the points to it
+	 */
+	virtual void updatePose(tf::Transform w2c, ros::Time t);
+
+	/*
+	 * true if the points have drifted far enough from the keyframe that a new one should be taken
+	 */
+	bool needKeyframe();
+
+	/*
+	 * moves the tracking state to a new processing resolution. factor is the ratio of the new image
+	 * size to the old one and size is the exact size of the new images.
+	 *
+	 * the points and anchors are scaled and the current and keyframe images resampled so tracking
+	 * continues from the same keyframe. K has to be set for the new resolution by the caller.
+	 */
+	virtual void rescale(double factor, cv::Size size);
+
+	cv::Mat draw(cv::Mat in)
+	{
+		for(auto e : this->state.pixels)
+		{
+			cv::drawMarker(in, e, cv::Scalar(255, 0, 0));
+		}
+		return in;
+	}
+
+protected:
+
+	PlanarPoseSolver planar_solver;
+
+	// set when the pose is realigned so the next frame starts a keyframe at the corrected pose
+	bool force_keyframe;
+
+	/*
+	 * builds keyframePyr from keyframeImg
+	 */
+	virtual void buildKeyframePyramid() = 0;
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARODOMETRY_H_ */
@@ -0,0 +1,328 @@
+/*
+ * PlanarPoseSolver.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <dipa/planar_odometry/PlanarPoseSolver.h>
+
+PlanarPoseSolver::PlanarPoseSolver() {
+
+}
+
+PlanarPoseSolver::~PlanarPoseSolver() {
+
+}
+
+bool PlanarPoseSolver::solve(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2f>& img_pts, cv::Mat_<float> K,
+		tf::Transform& c2w, double& ppe, cv::Mat H_guess)
+{
+	if(plane_pts.size() < 4 || plane_pts.size() != img_pts.size())
+	{
+		return false;
+	}
+
+	double fx = K(0), cx = K(2), fy = K(4), cy = K(5);
+
+	cv::Point2d center(0, 0);
+	for(auto e : plane_pts)
+	{
+		center.x += e.x;
+		center.y += e.y;
+	}
+	center.x /= plane_pts.size();
+	center.y /= plane_pts.size();
+
+	cv::Matx33d H;
+
+	if(!H_guess.empty())
+	{
+		// take the intrinsics back out of the pixel homography
+		cv::Matx33d Kinv = cv::Matx33d(1.0 / fx, 0, -cx / fx,
+				0, 1.0 / fy, -cy / fy,
+				0, 0, 1);
+		cv::Matx33d Hpx;
+		for(int i = 0; i < 3; i++)
+		{
+			for(int j = 0; j < 3; j++)
+			{
+				Hpx(i, j) = H_guess.at<double>(i, j);
+			}
+		}
+
+		H = Kinv * Hpx;
+	}
+	else
+	{
+		std::vector<cv::Point2d> norm_pts;
+		norm_pts.reserve(img_pts.size());
+		for(auto e : img_pts)
+		{
+			norm_pts.push_back(cv::Point2d((e.x - cx) / fx, (e.y - cy) / fy));
+		}
+
+		if(!this->estimateHomography(plane_pts, norm_pts, H))
+		{
+			ROS_DEBUG("could not estimate the plane homography");
+			return false;
+		}
+	}
+
+	cv::Matx33d R;
+	cv::Vec3d t;
+
+	if(!this->decomposeHomography(H, center, R, t))
+	{
+		ROS_DEBUG("could not decompose the plane homography");
+		return false;
+	}
+
+	ppe = this->refine(plane_pts, img_pts, K, R, t);
+
+	if(ppe < 0)
+	{
+		ROS_DEBUG("the planar pose put points behind the camera");
+		return false;
+	}
+
+	c2w = tf::Transform(tf::Matrix3x3(R(0, 0), R(0, 1), R(0, 2),
+			R(1, 0), R(1, 1), R(1, 2),
+			R(2, 0), R(2, 1), R(2, 2)), tf::Vector3(t[0], t[1], t[2]));
+
+	return true;
+}
+
+/*
+ * normalized dlt with h33 fixed to 1
+ * both point sets are centered first so h33 is the depth of the centroid which is never zero
+ */
+bool PlanarPoseSolver::estimateHomography(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2d>& norm_pts, cv::Matx33d& H)
+{
+	const int n = plane_pts.size();
+
+	double pmx = 0, pmy = 0, imx = 0, imy = 0;
+	for(int i = 0; i < n; i++)
+	{
+		pmx += plane_pts[i].x;
+		pmy += plane_pts[i].y;
+		imx += norm_pts[i].x;
+		imy += norm_pts[i].y;
+	}
+	pmx /= n;
+	pmy /= n;
+	imx /= n;
+	imy /= n;
+
+	double pd = 0, id = 0;
+	for(int i = 0; i < n; i++)
+	{
+		pd += sqrt((plane_pts[i].x - pmx) * (plane_pts[i].x - pmx) + (plane_pts[i].y - pmy) * (plane_pts[i].y - pmy));
+		id += sqrt((norm_pts[i].x - imx) * (norm_pts[i].x - imx) + (norm_pts[i].y - imy) * (norm_pts[i].y - imy));
+	}
+
+	if(pd < 1e-12 || id < 1e-12)
+	{
+		return false; // all points are on top of each other
+	}
+
+	double ps = sqrt(2.0) * n / pd;
+	double is = sqrt(2.0) * n / id;
+
+	cv::Matx<double, 8, 8> AtA;
+	cv::Matx<double, 8, 1> Atb;
+
+	for(int i = 0; i < n; i++)
+	{
+		double X = (plane_pts[i].x - pmx) * ps;
+		double Y = (plane_pts[i].y - pmy) * ps;
+		double x = (norm_pts[i].x - imx) * is;
+		double y = (norm_pts[i].y - imy) * is;
+
+		double a1[8] = {X, Y, 1, 0, 0, 0, -x * X, -x * Y};
+		double a2[8] = {0, 0, 0, X, Y, 1, -y * X, -y * Y};
+
+		for(int r = 0; r < 8; r++)
+		{
+			for(int c = 0; c < 8; c++)
+			{
+				AtA(r, c) += a1[r] * a1[c] + a2[r] * a2[c];
+			}
+			Atb(r) += a1[r] * x + a2[r] * y;
+		}
+	}
+
+	cv::Matx<double, 8, 1> h;
+	if(!cv::solve(AtA, Atb, h, cv::DECOMP_CHOLESKY))
+	{
+		return false;
+	}
+
+	cv::Matx33d Hn = cv::Matx33d(h(0), h(1), h(2),
+			h(3), h(4), h(5),
+			h(6), h(7), 1.0);
+
+	cv::Matx33d Tp = cv::Matx33d(ps, 0, -ps * pmx,
+			0, ps, -ps * pmy,
+			0, 0, 1);
+
+	cv::Matx33d Ti_inv = cv::Matx33d(1.0 / is, 0, imx,
+			0, 1.0 / is, imy,
+			0, 0, 1);
+
+	H = Ti_inv * Hn * Tp;
+
+	return true;
+}
+
+/*
+ * H = lambda * [r1 r2 t]
+ */
+bool PlanarPoseSolver::decomposeHomography(cv::Matx33d H, cv::Point2d plane_center, cv::Matx33d& R, cv::Vec3d& t)
+{
+	cv::Vec3d h1 = cv::Vec3d(H(0, 0), H(1, 0), H(2, 0));
+	cv::Vec3d h2 = cv::Vec3d(H(0, 1), H(1, 1), H(2, 1));
+	cv::Vec3d h3 = cv::Vec3d(H(0, 2), H(1, 2), H(2, 2));
+
+	double n1 = cv::norm(h1);
+	double n2 = cv::norm(h2);
+
+	if(n1 < 1e-12 || n2 < 1e-12)
+	{
+		return false;
+	}
+
+	double lambda = 0.5 * (n1 + n2);
+
+	// pick the sign which puts the plane in front of the camera
+	if(H(2, 0) * plane_center.x + H(2, 1) * plane_center.y + H(2, 2) < 0)
+	{
+		lambda = -lambda;
+	}
+
+	cv::Vec3d r1 = h1 * (1.0 / lambda);
+	cv::Vec3d r2 = h2 * (1.0 / lambda);
+	cv::Vec3d r3 = r1.cross(r2);
+	t = h3 * (1.0 / lambda);
+
+	cv::Matx33d approx = cv::Matx33d(r1[0], r2[0], r3[0],
+			r1[1], r2[1], r3[1],
+			r1[2], r2[2], r3[2]);
+
+	// snap to the closest rotation
+	cv::Matx31d w;
+	cv::Matx33d u, vt;
+	cv::SVD::compute(approx, w, u, vt);
+
+	R = u * vt;
+
+	return cv::determinant(R) > 0;
+}
+
+double PlanarPoseSolver::refine(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2f>& img_pts, cv::Mat_<float> K,
+		cv::Matx33d& R, cv::Vec3d& t)
+{
+	double fx = K(0), cx = K(2), fy = K(4), cy = K(5);
+
+	double ppe = -1;
+
+	// the last pass only measures the error of the final pose
+	for(int it = 0; it <= PLANAR_GN_ITERATIONS; it++)
+	{
+		cv::Matx66d JtJ;
+		cv::Matx61d Jtr;
+		double err = 0;
+
+		for(int i = 0; i < plane_pts.size(); i++)
+		{
+			cv::Vec3d Xc = R * cv::Vec3d(plane_pts[i].x, plane_pts[i].y, 0) + t;
+
+			if(Xc[2] <= 0)
+			{
+				return -1;
+			}
+
+			double iz = 1.0 / Xc[2];
+
+			double ru = img_pts[i].x - (fx * Xc[0] * iz + cx);
+			double rv = img_pts[i].y - (fy * Xc[1] * iz + cy);
+
+			err += sqrt(ru * ru + rv * rv);
+
+			if(it == PLANAR_GN_ITERATIONS)
+			{
+				continue;
+			}
+
+			double du_dx = fx * iz;
+			double du_dz = -fx * Xc[0] * iz * iz;
+			double dv_dy = fy * iz;
+			double dv_dz = -fy * Xc[1] * iz * iz;
+
+			// the camera point moves by dtheta x Xc + dt
+			double Ju[6] = {du_dz * Xc[1], du_dx * Xc[2] - du_dz * Xc[0], -du_dx * Xc[1], du_dx, 0, du_dz};
+			double Jv[6] = {-dv_dy * Xc[2] + dv_dz * Xc[1], -dv_dz * Xc[0], dv_dy * Xc[0], 0, dv_dy, dv_dz};
+
+			for(int r = 0; r < 6; r++)
+			{
+				for(int c = 0; c < 6; c++)
+				{
+					JtJ(r, c) += Ju[r] * Ju[c] + Jv[r] * Jv[c];
+				}
+				Jtr(r) += Ju[r] * ru + Jv[r] * rv;
+			}
+		}
+
+		ppe = err / (double)plane_pts.size();
+
+		if(it == PLANAR_GN_ITERATIONS)
+		{
+			break;
+		}
+
+		cv::Matx61d delta;
+		if(!cv::solve(JtJ, Jtr, delta, cv::DECOMP_CHOLESKY))
+		{
+			ROS_DEBUG("planar gauss newton step is degenerate");
+			break;
+		}
+
+		cv::Matx33d dR = expSO3(cv::Vec3d(delta(0), delta(1), delta(2)));
+
+		R = dR * R;
+		t = dR * t + cv::Vec3d(delta(3), delta(4), delta(5));
+	}
+
+	return ppe;
+}
+
+cv::Matx33d PlanarPoseSolver::expSO3(cv::Vec3d w)
+{
+	double theta = cv::norm(w);
+
+	cv::Matx33d W = cv::Matx33d(0, -w[2], w[1],
+			w[2], 0, -w[0],
+			-w[1], w[0], 0);
+
+	if(theta < 1e-10)
+	{
+		return cv::Matx33d::eye() + W;
+	}
+
+	return cv::Matx33d::eye() + (sin(theta) / theta) * W + ((1 - cos(theta)) / (theta * theta)) * (W * W);
+}
+
+cv::Vec3d PlanarPoseSolver::logSO3(cv::Matx33d R)
+{
+	double c = std::max(-1.0, std::min(1.0, 0.5 * (R(0, 0) + R(1, 1) + R(2, 2) - 1.0)));
+	double theta = acos(c);
+
+	cv::Vec3d w = cv::Vec3d(R(2, 1) - R(1, 2), R(0, 2) - R(2, 0), R(1, 0) - R(0, 1));
+
+	if(theta < 1e-10)
+	{
+		return 0.5 * w;
+	}
+
+	return (theta / (2 * sin(theta))) * w;
+}
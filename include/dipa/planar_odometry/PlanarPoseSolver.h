@@ -0,0 +1,65 @@
+/*
+ * PlanarPoseSolver.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#ifndef DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARPOSESOLVER_H_
+#define DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARPOSESOLVER_H_
+
+#include <ros/ros.h>
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+#include <algorithm>
+
+#include <tf/tf.h>
+
+#include <dipa/DipaParams.h>
+
+/*
+ * solves the pose of a camera looking at points which all lie on z = 0
+ *
+ * the plane to image homography is estimated directly (or taken from the caller), decomposed into
+ * a rotation and translation in closed form and then refined with a fixed number of gauss newton
+ * steps on the reprojection error. the per pixel error of the final pose falls out of the last step.
+ */
+class PlanarPoseSolver {
+public:
+
+	PlanarPoseSolver();
+	virtual ~PlanarPoseSolver();
+
+	/*
+	 * plane_pts are the xy world coordinates of the points and img_pts their pixels
+	 * if H_guess is not empty it is used as the pixel homography instead of estimating one
+	 *
+	 * c2w is the transform which takes world points into the camera frame (solvePnP's rvec and tvec)
+	 * returns false if the pose could not be solved
+	 */
+	bool solve(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2f>& img_pts, cv::Mat_<float> K,
+			tf::Transform& c2w, double& ppe, cv::Mat H_guess = cv::Mat());
+
+	/*
+	 * least squares homography from the plane to normalized image coordinates
+	 */
+	bool estimateHomography(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2d>& norm_pts, cv::Matx33d& H);
+
+	/*
+	 * closed form rotation and translation from a plane to normalized image homography
+	 */
+	bool decomposeHomography(cv::Matx33d H, cv::Point2d plane_center, cv::Matx33d& R, cv::Vec3d& t);
+
+	/*
+	 * refines the pose with PLANAR_GN_ITERATIONS gauss newton steps and returns the mean reprojection error
+	 */
+	double refine(const std::vector<cv::Point2f>& plane_pts, const std::vector<cv::Point2f>& img_pts, cv::Mat_<float> K,
+			cv::Matx33d& R, cv::Vec3d& t);
+
+	static cv::Matx33d expSO3(cv::Vec3d w);
+
+	static cv::Vec3d logSO3(cv::Matx33d R);
+};
+
+#endif /* DIPA_INCLUDE_DIPA_PLANAR_ODOMETRY_PLANARPOSESOLVER_H_ */
@@ -0,0 +1,288 @@
+/*
+ * dipa_tuner.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ *
+ * replays a sequence through offline dipa instances for every combination of a grid of parameters
+ * and reports the throughput, the grid alignment rate and the pose error of each combination.
+ * the throughput is from the cpu time of the frames so it does not depend on how many
+ * combinations share the cores. as in the node the sliding window optimizes beside the frames and
+ * its corrections are applied between them. applying them is counted, the optimization is not.
+ * the pose errors only cover the tracked frames so the lost rate is part of the pareto front.
+ *
+ * the sequence is either rendered from the grid along a synthetic trajectory or read from a csv
+ * where every line is: image_path, stamp, x, y, z, qx, qy, qz, qw (the ground truth base pose)
+ *
+ * private parameters:
+ * 	~sequence 				csv of a recorded sequence. empty renders a synthetic one
+ * 	~frames, ~width, ~height	size of the synthetic sequence
+ * 	~fx, ~fy, ~cx, ~cy 		intrinsics of the sequence
+ * 	~noise 					std dev of the gaussian noise added to the synthetic images
+ * 	~threads 				worker threads. 0 uses all cores. opencv runs single threaded so the
+ * 							combinations do not compete for cores
+ * 	~output 				csv with the result of every combination
+ * 	~<parameter>_values 	the values of a swept parameter. see the defaults below
+ */
+
+#include <ros/ros.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <functional>
+#include <algorithm>
+
+#include <time.h>
+
+#include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <dipa/Dipa.h>
+#include <dipa/DipaParameters.h>
+#include <dipa/Sequence.h>
+
+struct Result{
+	DipaParameters p;
+
+	double fps;
+	double alignment_rate; // frames with a good grid alignment
+	double lost_rate; // frames processed while tracking was lost
+	double position_rmse; // meters over the tracked frames
+	double rotation_rmse; // degrees over the tracked frames
+
+	bool pareto;
+};
+
+/*
+ * the cpu time of the calling thread. unlike the wall time it does not grow while the thread waits
+ * for a core
+ */
+double threadSeconds()
+{
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+Result run(const std::vector<SequenceFrame>& seq, cv::Mat_<float> K, const DipaParameters& p)
+{
+	Result r;
+	r.p = p;
+	r.pareto = false;
+
+	sensor_msgs::CameraInfoPtr cam(new sensor_msgs::CameraInfo);
+	for(int i = 0; i < 9; i++)
+	{
+		cam->K[i] = K(i);
+	}
+
+	// the camera is the base so the ground truth is the camera pose
+	Dipa dipa(seq.front().w2b, tf::Transform::getIdentity(), p);
+
+	int aligned = 0, lost = 0, tracked = 0;
+	double sse_position = 0, sse_rotation = 0;
+	double seconds = 0;
+
+	for(int i = 0; i < seq.size(); i++)
+	{
+		std_msgs::Header header;
+		header.stamp = seq[i].stamp;
+		header.seq = i;
+		header.frame_id = CAMERA_FRAME;
+
+		sensor_msgs::ImageConstPtr img = cv_bridge::CvImage(header, sensor_msgs::image_encodings::MONO8, seq[i].img).toImageMsg();
+
+		double start = threadSeconds();
+#if USE_SLIDING_WINDOW
+		dipa.applyWindowCorrection();
+#endif
+		dipa.processFrame(img, cam);
+		seconds += threadSeconds() - start;
+
+		aligned += dipa.last_frame_grid_aligned;
+
+		if(dipa.TRACKING_LOST)
+		{
+			lost++;
+			continue;
+		}
+
+		tf::Transform est = dipa.state.getCurrentBestPose();
+		double dp = (est.getOrigin() - seq[i].w2b.getOrigin()).length();
+		double dr = (seq[i].w2b.inverse() * est).getRotation().getAngle() * 180.0 / CV_PI;
+
+		sse_position += dp * dp;
+		sse_rotation += dr * dr;
+		tracked++;
+	}
+
+	r.fps = seq.size() / seconds;
+	r.alignment_rate = (double)aligned / seq.size();
+	r.lost_rate = (double)lost / seq.size();
+	r.position_rmse = (tracked > 0) ? sqrt(sse_position / tracked) : std::numeric_limits<double>::infinity();
+	r.rotation_rmse = (tracked > 0) ? sqrt(sse_rotation / tracked) : std::numeric_limits<double>::infinity();
+
+	return r;
+}
+
+/*
+ * a dominates b if it is no worse in throughput, alignment rate, lost rate and position error and
+ * better in one. lost frames skip most of the pipeline and have no error so a run which is often
+ * lost would otherwise look fast and accurate
+ */
+bool dominates(const Result& a, const Result& b)
+{
+	bool no_worse = a.fps >= b.fps && a.alignment_rate >= b.alignment_rate && a.lost_rate <= b.lost_rate && a.position_rmse <= b.position_rmse;
+	bool better = a.fps > b.fps || a.alignment_rate > b.alignment_rate || a.lost_rate < b.lost_rate || a.position_rmse < b.position_rmse;
+	return no_worse && better;
+}
+
+void markParetoFront(std::vector<Result>& results)
+{
+	for(auto& a : results)
+	{
+		a.pareto = true;
+		for(auto& b : results)
+		{
+			if(dominates(b, a))
+			{
+				a.pareto = false;
+				break;
+			}
+		}
+	}
+}
+
+std::vector<double> values(ros::NodeHandle& nh, std::string name, std::vector<double> defaults)
+{
+	std::vector<double> v;
+	nh.param<std::vector<double> >(name + "_values", v, defaults);
+	return v;
+}
+
+int main(int argc, char **argv) {
+	ros::init(argc, argv, "dipa_tuner");
+
+	ros::NodeHandle nh("~");
+
+	std::string sequence_path, output_path;
+	int frames, width, height, threads;
+	double fx, fy, cx, cy, noise;
+
+	nh.param<std::string>("sequence", sequence_path, "");
+	nh.param<std::string>("output", output_path, "dipa_sweep.csv");
+	nh.param<int>("frames", frames, 200);
+	nh.param<int>("width", width, 640);
+	nh.param<int>("height", height, 480);
+	nh.param<int>("threads", threads, 0);
+	nh.param<double>("fx", fx, 400);
+	nh.param<double>("fy", fy, 400);
+	nh.param<double>("cx", cx, 320);
+	nh.param<double>("cy", cy, 240);
+	nh.param<double>("noise", noise, 5.0);
+
+	if(threads <= 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	cv::Mat_<float> K = (cv::Mat_<float>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
+
+	std::vector<SequenceFrame> seq = sequence_path.empty() ? renderSequence(frames, cv::Size(width, height), K, noise, threads) : loadSequence(sequence_path);
+
+	if(seq.empty())
+	{
+		ROS_FATAL("the sequence has no frames");
+		return 1;
+	}
+
+	ROS_INFO_STREAM("sweeping over " << seq.size() << " frames with " << threads << " threads");
+
+	// every combination of the swept values on top of the loaded profile
+	DipaParameters base;
+	base.load(nh);
+	base.frame_time_budget = std::numeric_limits<double>::max(); // the runs share the cores so never degrade
+	base.resolution_control = false; // the scale is swept
+
+	std::vector<DipaParameters> combos(1, base);
+
+	auto sweep = [&](std::vector<double> vals, std::function<void(DipaParameters&, double)> set){
+		std::vector<DipaParameters> next;
+		for(auto& c : combos)
+		{
+			for(auto v : vals)
+			{
+				DipaParameters p = c;
+				set(p, v);
+				if(p.valid())
+				{
+					next.push_back(p);
+				}
+			}
+		}
+		combos = next;
+	};
+
+	sweep(values(nh, "inverse_image_scale", {2, 4, 6}), [](DipaParameters& p, double v){p.inverse_image_scale = v;});
+	sweep(values(nh, "canny_blur_sigma", {1.0, 2.0}), [](DipaParameters& p, double v){p.canny_blur_sigma = v;});
+	sweep(values(nh, "canny_thresh_1", {30, 50}), [](DipaParameters& p, double v){p.canny_thresh_1 = v;});
+	sweep(values(nh, "canny_thresh_2", {150, 200}), [](DipaParameters& p, double v){p.canny_thresh_2 = v;});
+	sweep(values(nh, "hough_thresh", {50, 75, 100}), [](DipaParameters& p, double v){p.hough_thresh = v;});
+	sweep(values(nh, "fast_threshold", {50, 100}), [](DipaParameters& p, double v){p.fast_threshold = v;});
+	sweep(values(nh, "max_norm", {15, 25}), [](DipaParameters& p, double v){p.max_norm = v;});
+	sweep(values(nh, "vo_engine", {(double)base.vo_engine}), [](DipaParameters& p, double v){p.vo_engine = v;});
+
+	ROS_INFO_STREAM("running " << combos.size() << " combinations");
+
+	// the workers already use every core. opencv's own threads would only oversubscribe them and
+	// move its work out of the worker's cpu time
+	cv::setNumThreads(1);
+
+	std::vector<Result> results(combos.size());
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+
+	for(int w = 0; w < threads; w++)
+	{
+		workers.push_back(std::thread([&](){
+			for(int i = next++; i < combos.size(); i = next++)
+			{
+				results[i] = run(seq, K, combos[i]);
+				ROS_INFO_STREAM("finished combination " << i + 1 << " of " << combos.size());
+			}
+		}));
+	}
+
+	for(auto& w : workers)
+	{
+		w.join();
+	}
+
+	markParetoFront(results);
+
+	std::ofstream out(output_path);
+	out << "inverse_image_scale,canny_blur_sigma,canny_thresh_1,canny_thresh_2,hough_thresh,fast_threshold,max_norm,vo_engine,fps,alignment_rate,lost_rate,position_rmse,rotation_rmse,pareto\n";
+
+	for(auto& r : results)
+	{
+		std::stringstream row;
+		row << r.p.inverse_image_scale << "," << r.p.canny_blur_sigma << "," << r.p.canny_thresh_1 << "," << r.p.canny_thresh_2 << ","
+				<< r.p.hough_thresh << "," << r.p.fast_threshold << "," << r.p.max_norm << "," << r.p.vo_engine << ","
+				<< r.fps << "," << r.alignment_rate << "," << r.lost_rate << "," << r.position_rmse << "," << r.rotation_rmse << "," << r.pareto;
+
+		out << row.str() << "\n";
+
+		if(r.pareto)
+		{
+			ROS_INFO_STREAM("pareto: " << row.str());
+		}
+	}
+
+	ROS_INFO_STREAM("wrote every combination to " << output_path);
+
+	return 0;
+}
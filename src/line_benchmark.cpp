@@ -0,0 +1,236 @@
+/*
+ * line_benchmark.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ *
+ * runs every line detector backend on the same frames and reports its speed and how well the
+ * corners from its lines match the projected grid corners.
+ *
+ * the frames come from a sequence (see Sequence.h) and are scaled like dipa scales them. the
+ * ground truth corners are the grid corners projected with the ground truth pose.
+ *
+ * private parameters:
+ * 	~sequence 				csv of a recorded sequence. empty renders a synthetic one
+ * 	~frames, ~width, ~height	size of the synthetic sequence
+ * 	~fx, ~fy, ~cx, ~cy 		intrinsics of the sequence
+ * 	~noise 					std dev of the gaussian noise added to the synthetic images
+ * 	~repeats 				times every frame is detected for the timing
+ * 	~tolerance 				pixels in the scaled image within which a corner matches the ground truth
+ * 	~prior_yaw_error 		degrees of yaw added to the ground truth to predict the lines for the prior
+ * 	~prior_offset_error 	meters of x and y offset added to the ground truth for the prior
+ * 	~output 				csv with one row per backend
+ * 	the DipaParameters names set the detector settings and the image scale
+ */
+
+#include <ros/ros.h>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <limits>
+#include <memory>
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include <dipa/DipaParameters.h>
+#include <dipa/GridRenderer.h>
+#include <dipa/Sequence.h>
+
+#include <dipa/line_detection/HoughLineDetector.h>
+#include <dipa/line_detection/LSDLineDetector.h>
+#include <dipa/line_detection/EDLineDetector.h>
+#include <dipa/line_detection/PriorHoughLineDetector.h>
+
+struct Score{
+	std::string name;
+
+	double ms_per_frame;
+	double lines_per_frame;
+	double precision; // detected corners within the tolerance of a ground truth corner
+	double recall; // ground truth corners with a detected corner within the tolerance
+	double mean_error; // pixels over the matched detected corners
+};
+
+/*
+ * distance from pt to the closest of pts
+ */
+double closest(cv::Point2f pt, const std::vector<cv::Point2f>& pts)
+{
+	double best = std::numeric_limits<double>::infinity();
+	for(auto& e : pts)
+	{
+		double dx = pt.x - e.x, dy = pt.y - e.y;
+		best = std::min(best, sqrt(dx * dx + dy * dy));
+	}
+	return best;
+}
+
+Score benchmark(LineDetector& detector, const std::vector<cv::Mat>& imgs, const std::vector<std::vector<cv::Vec4f> >& priors,
+		const std::vector<std::vector<cv::Point2f> >& truth, int repeats, double tolerance)
+{
+	Score s;
+	s.name = detector.name();
+
+	std::vector<cv::Vec2f> lines;
+
+	// warm the buffers up so allocation is not timed
+	detector.setPrior(priors.front());
+	detector.detect(imgs.front(), lines);
+
+	ros::WallTime start = ros::WallTime::now();
+	for(int r = 0; r < repeats; r++)
+	{
+		for(int i = 0; i < imgs.size(); i++)
+		{
+			detector.setPrior(priors[i]);
+			detector.detect(imgs[i], lines);
+		}
+	}
+	s.ms_per_frame = 1000.0 * (ros::WallTime::now() - start).toSec() / (repeats * imgs.size());
+
+	int detected = 0, true_positive = 0, ground_truth = 0, found = 0;
+	double error = 0;
+	double total_lines = 0;
+
+	for(int i = 0; i < imgs.size(); i++)
+	{
+		detector.setPrior(priors[i]);
+		detector.detect(imgs[i], lines);
+		total_lines += lines.size();
+
+		std::vector<cv::Point2f> corners = LineDetector::findLineIntersections(lines, cv::Rect(0, 0, imgs[i].cols, imgs[i].rows));
+
+		for(auto& c : corners)
+		{
+			double d = closest(c, truth[i]);
+			detected++;
+			if(d <= tolerance)
+			{
+				true_positive++;
+				error += d;
+			}
+		}
+
+		for(auto& t : truth[i])
+		{
+			ground_truth++;
+			found += (closest(t, corners) <= tolerance);
+		}
+	}
+
+	s.lines_per_frame = total_lines / imgs.size();
+	s.precision = (detected > 0) ? (double)true_positive / detected : 0;
+	s.recall = (ground_truth > 0) ? (double)found / ground_truth : 0;
+	s.mean_error = (true_positive > 0) ? error / true_positive : std::numeric_limits<double>::infinity();
+
+	return s;
+}
+
+int main(int argc, char **argv) {
+	ros::init(argc, argv, "line_benchmark");
+
+	ros::NodeHandle nh("~");
+
+	std::string sequence_path, output_path;
+	int frames, width, height, repeats;
+	double fx, fy, cx, cy, noise, tolerance, prior_yaw_error, prior_offset_error;
+
+	nh.param<std::string>("sequence", sequence_path, "");
+	nh.param<std::string>("output", output_path, "line_benchmark.csv");
+	nh.param<int>("frames", frames, 100);
+	nh.param<int>("width", width, 640);
+	nh.param<int>("height", height, 480);
+	nh.param<int>("repeats", repeats, 5);
+	nh.param<double>("fx", fx, 400);
+	nh.param<double>("fy", fy, 400);
+	nh.param<double>("cx", cx, 320);
+	nh.param<double>("cy", cy, 240);
+	nh.param<double>("noise", noise, 5.0);
+	nh.param<double>("tolerance", tolerance, 2.0);
+	nh.param<double>("prior_yaw_error", prior_yaw_error, 2.0);
+	nh.param<double>("prior_offset_error", prior_offset_error, 0.03);
+
+	DipaParameters p;
+	p.load(nh);
+
+	cv::Mat_<float> K = (cv::Mat_<float>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
+
+	std::vector<SequenceFrame> seq = sequence_path.empty() ? renderSequence(frames, cv::Size(width, height), K, noise, std::max(1u, std::thread::hardware_concurrency())) : loadSequence(sequence_path);
+
+	if(seq.empty())
+	{
+		ROS_FATAL("the sequence has no frames");
+		return 1;
+	}
+
+	// scale the frames and project the ground truth corners like dipa does
+	cv::Mat_<float> scaled_K = (1.0 / p.inverse_image_scale) * K;
+
+	GridRenderer renderer;
+	renderer.setGrid(p.grid_width, p.grid_height, p.grid_spacing);
+	renderer.setIntrinsic(scaled_K);
+
+	std::vector<cv::Mat> imgs;
+	std::vector<std::vector<cv::Vec4f> > priors;
+	std::vector<std::vector<cv::Point2f> > truth;
+
+	// the error a drifting vo pose would have
+	tf::Transform prior_error(tf::createQuaternionFromYaw(prior_yaw_error * CV_PI / 180.0), tf::Vector3(prior_offset_error, prior_offset_error, 0));
+
+	for(auto& f : seq)
+	{
+		cv::Mat scaled;
+		cv::resize(f.img, scaled, cv::Size(f.img.cols / p.inverse_image_scale, f.img.rows / p.inverse_image_scale));
+		imgs.push_back(scaled);
+
+		renderer.setSize(scaled.size());
+		renderer.setW2C(f.w2b); // the camera is the base
+
+		std::vector<cv::Point2f> corners;
+		for(auto& m : renderer.renderGridCorners().matches)
+		{
+			if(m.obj_px.x >= 0 && m.obj_px.y >= 0 && m.obj_px.x < scaled.cols && m.obj_px.y < scaled.rows)
+			{
+				corners.push_back(m.obj_px);
+			}
+		}
+		truth.push_back(corners);
+
+		renderer.setW2C(prior_error * f.w2b);
+
+		std::vector<cv::Vec4f> prior;
+		for(auto& l : renderer.renderGridEdges())
+		{
+			prior.push_back(cv::Vec4f(l.pa.x, l.pa.y, l.pb.x, l.pb.y));
+		}
+		priors.push_back(prior);
+	}
+
+	std::vector<std::unique_ptr<LineDetector> > detectors;
+	detectors.push_back(std::unique_ptr<LineDetector>(new HoughLineDetector));
+	detectors.push_back(std::unique_ptr<LineDetector>(new LSDLineDetector));
+	detectors.push_back(std::unique_ptr<LineDetector>(new EDLineDetector));
+	detectors.push_back(std::unique_ptr<LineDetector>(new PriorHoughLineDetector));
+
+	std::ofstream out(output_path);
+	out << "detector,ms_per_frame,lines_per_frame,precision,recall,mean_error\n";
+
+	for(auto& d : detectors)
+	{
+		d->setParameters(p);
+
+		Score s = benchmark(*d, imgs, priors, truth, repeats, tolerance);
+
+		std::stringstream row;
+		row << s.name << "," << s.ms_per_frame << "," << s.lines_per_frame << "," << s.precision << "," << s.recall << "," << s.mean_error;
+
+		ROS_INFO_STREAM(row.str());
+		out << row.str() << "\n";
+	}
+
+	ROS_INFO_STREAM("benchmarked " << imgs.size() << " frames at 1/" << p.inverse_image_scale << " resolution. wrote " << output_path);
+
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * planar_solver_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include <dipa/GridRenderer.h>
+#include <dipa/Sequence.h>
+#include <dipa/planar_odometry/PlanarLineSolver.h>
+#include <dipa/planar_odometry/PlanarChamferSolver.h>
+
+namespace {
+
+const cv::Size SIZE(640, 480);
+
+cv::Mat_<float> intrinsic()
+{
+	return (cv::Mat_<float>(3, 3) << 250, 0, 320, 0, 250, 240, 0, 0, 1);
+}
+
+/*
+ * R and t of the inverse of w2c. these take world points into the camera
+ */
+void toRt(tf::Transform w2c, cv::Matx33d& R, cv::Vec3d& t)
+{
+	tf::Transform c2w = w2c.inverse();
+	tf::Matrix3x3 basis = c2w.getBasis();
+
+	R = cv::Matx33d(basis[0][0], basis[0][1], basis[0][2], basis[1][0], basis[1][1], basis[1][2], basis[2][0], basis[2][1], basis[2][2]);
+	t = cv::Vec3d(c2w.getOrigin().x(), c2w.getOrigin().y(), c2w.getOrigin().z());
+}
+
+tf::Transform toW2C(const cv::Matx33d& R, const cv::Vec3d& t)
+{
+	tf::Transform c2w;
+	c2w.getBasis().setValue(R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2), R(2, 0), R(2, 1), R(2, 2));
+	c2w.setOrigin(tf::Vector3(t[0], t[1], t[2]));
+	return c2w.inverse();
+}
+
+double positionError(const tf::Transform& a, const tf::Transform& b)
+{
+	return (a.getOrigin() - b.getOrigin()).length();
+}
+
+double rotationError(const tf::Transform& a, const tf::Transform& b)
+{
+	double angle = (a.inverse() * b).getRotation().getAngle();
+	return std::min(angle, 2 * CV_PI - angle);
+}
+
+/*
+ * the camera above the grid as in the rendered sequences
+ */
+class PlanarSolverTest : public testing::Test {
+protected:
+	GridRenderer renderer;
+	cv::Mat_<float> K;
+	tf::Transform truth;
+
+	void SetUp()
+	{
+		K = intrinsic();
+		truth = syntheticPose(1.0);
+
+		renderer.setSize(SIZE);
+		renderer.setIntrinsic(K);
+		renderer.setW2C(truth);
+	}
+
+	/*
+	 * the plane point seen at a pixel from the true pose
+	 */
+	cv::Point2d backProject(cv::Point2f px)
+	{
+		cv::Mat_<float> dir = K.inv() * (cv::Mat_<float>(3, 1) << px.x, px.y, 1);
+
+		bool behind;
+		tf::Vector3 pt = renderer.project2XYPlane(dir, behind);
+		EXPECT_FALSE(behind);
+
+		return cv::Point2d(pt.x(), pt.y());
+	}
+};
+
+}
+
+TEST_F(PlanarSolverTest, LineSolverRecoversThePoseFromGridEdges)
+{
+	std::vector<GridRenderer::Line> model = renderer.renderGridEdges();
+
+	// both grid directions must be in view for a full pose
+	ASSERT_GE(model.size(), 8u);
+
+	std::vector<PlanarLineSolver::Correspondence> corr;
+	for(auto& m : model)
+	{
+		PlanarLineSolver::Correspondence c;
+		c.a = backProject(m.pa);
+		c.b = backProject(m.pb);
+		c.line = cv::Vec3d(cos(m.line[1]), sin(m.line[1]), m.line[0]);
+		corr.push_back(c);
+	}
+
+	tf::Transform guess = truth * tf::Transform(tf::createQuaternionFromRPY(0.02, -0.02, 0.03), tf::Vector3(0.05, -0.03, 0.02));
+
+	cv::Matx33d R;
+	cv::Vec3d t;
+	toRt(guess, R, t);
+
+	PlanarLineSolver solver;
+	double rms = -1;
+	for(int i = 0; i < 20; i++)
+	{
+		rms = solver.step(corr, K, PNL_HUBER, R, t);
+		ASSERT_GE(rms, 0);
+	}
+
+	EXPECT_LT(rms, 1e-3);
+
+	tf::Transform solved = toW2C(R, t);
+	EXPECT_LT(positionError(solved, truth), 1e-4);
+	EXPECT_LT(rotationError(solved, truth), 1e-4);
+}
+
+TEST_F(PlanarSolverTest, ChamferSolverPullsTheGridOntoTheEdges)
+{
+	cv::Mat gray, edges, not_edges;
+	cv::cvtColor(renderer.renderGridByProjection(), gray, cv::COLOR_BGR2GRAY);
+	cv::Canny(gray, edges, 50, 200);
+	ASSERT_GT(cv::countNonZero(edges), 0);
+
+	cv::threshold(edges, not_edges, 0, 255, cv::THRESH_BINARY_INV);
+
+	cv::Mat_<float> dist;
+	cv::distanceTransform(not_edges, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+
+	const double truncation = 10;
+
+	PlanarChamferSolver solver;
+	solver.setDistance(dist, cv::Rect(cv::Point(0, 0), SIZE), truncation);
+
+	std::vector<cv::Point2d> pts = renderer.sampleGridEdges(CHAMFER_SAMPLES_PER_CELL);
+
+	// a few pixels off so every point starts inside of the truncation
+	tf::Transform guess = truth * tf::Transform(tf::createQuaternionFromRPY(0.01, -0.01, 0.01), tf::Vector3(0.02, -0.02, 0.01));
+
+	cv::Matx33d R;
+	cv::Vec3d t;
+	toRt(guess, R, t);
+
+	for(int i = 0; i < 30; i++)
+	{
+		ASSERT_GE(solver.step(pts, K, CHAMFER_HUBER, R, t), 0);
+	}
+
+	int visible, inliers;
+	EXPECT_LT(solver.error(pts, K, R, t, visible, inliers), 1.0);
+	EXPECT_GE(inliers, CHAMFER_MIN_INLIERS);
+
+	tf::Transform solved = toW2C(R, t);
+	EXPECT_LT(positionError(solved, truth), 0.01);
+	EXPECT_LT(rotationError(solved, truth), 0.01);
+}
+
+int main(int argc, char **argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+/*
+ * pose_filter_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <dipa/PoseFilter.h>
+
+namespace {
+
+double rotationError(const tf::Transform& a, const tf::Transform& b)
+{
+	double angle = (a.inverse() * b).getRotation().getAngle();
+	return std::min(angle, 2 * M_PI - angle);
+}
+
+void expectNear(const tf::Transform& a, const tf::Transform& b, double tolerance)
+{
+	EXPECT_NEAR((a.getOrigin() - b.getOrigin()).length(), 0, tolerance);
+	EXPECT_NEAR(rotationError(a, b), 0, tolerance);
+}
+
+/*
+ * a base flying forward and turning slowly
+ */
+tf::Transform truth(double t)
+{
+	return tf::Transform(tf::createQuaternionFromYaw(0.2 * t), tf::Vector3(0.5 * t, 0.1 * t, 1.5));
+}
+
+const tf::Vector3 OMEGA(0, 0, 0.2);
+
+}
+
+TEST(PoseFilter, ReplaysALateGyroMeasurement)
+{
+	PoseFilter in_order, late;
+
+	in_order.reset(truth(0), ros::Time(1.0));
+	in_order.addVO(truth(0.1), ros::Time(1.1));
+	in_order.addGyro(OMEGA, ros::Time(1.15));
+	in_order.addVO(truth(0.2), ros::Time(1.2));
+	in_order.addVO(truth(0.3), ros::Time(1.3));
+
+	// the gyro message is delivered after the frames which followed it
+	late.reset(truth(0), ros::Time(1.0));
+	late.addVO(truth(0.1), ros::Time(1.1));
+	late.addVO(truth(0.2), ros::Time(1.2));
+	late.addVO(truth(0.3), ros::Time(1.3));
+	late.addGyro(OMEGA, ros::Time(1.15));
+
+	EXPECT_EQ(late.getStamp(), ros::Time(1.3));
+	expectNear(late.getPose(), in_order.getPose(), 1e-9);
+	EXPECT_NEAR((late.getBaseFrameVelocity() - in_order.getBaseFrameVelocity()).length(), 0, 1e-9);
+	EXPECT_NEAR((late.getBaseFrameOmega() - in_order.getBaseFrameOmega()).length(), 0, 1e-9);
+}
+
+TEST(PoseFilter, ReplaysALateAbsolutePose)
+{
+	PoseFilter drifting, corrected;
+
+	// vo drifts away from the truth a centimeter per frame
+	tf::Vector3 drift(0.01, -0.01, 0);
+
+	for(PoseFilter* f : {&drifting, &corrected})
+	{
+		f->reset(truth(0), ros::Time(1.0));
+		for(int i = 1; i <= 5; i++)
+		{
+			tf::Transform vo = truth(0.1 * i);
+			vo.setOrigin(vo.getOrigin() + drift * i);
+			f->addVO(vo, ros::Time(1.0 + 0.1 * i));
+		}
+	}
+
+	// a grid alignment of the third frame arrives after the fifth
+	corrected.addAbsolutePose(truth(0.3), ros::Time(1.3), EKF_MANUAL_POSITION_SIGMA, EKF_MANUAL_ROTATION_SIGMA);
+
+	EXPECT_EQ(corrected.getStamp(), ros::Time(1.5));
+
+	double drifting_error = (drifting.getPose().getOrigin() - truth(0.5).getOrigin()).length();
+	double corrected_error = (corrected.getPose().getOrigin() - truth(0.5).getOrigin()).length();
+
+	EXPECT_LT(corrected_error, drifting_error);
+
+	// the posterior of the aligned frame sits on the alignment
+	EXPECT_LT((corrected.predict(ros::Time(1.3)).getOrigin() - truth(0.3).getOrigin()).length(), 2 * EKF_MANUAL_POSITION_SIGMA);
+}
+
+TEST(PoseFilter, PredictsAnOlderStampFromThePosteriorAtThatStamp)
+{
+	PoseFilter with_gyro, without_gyro;
+
+	for(PoseFilter* f : {&with_gyro, &without_gyro})
+	{
+		f->reset(truth(0), ros::Time(1.0));
+		f->addVO(truth(0.1), ros::Time(1.1));
+		f->addVO(truth(0.2), ros::Time(1.2));
+	}
+
+	// the imu moves the filter past the last frame
+	with_gyro.addGyro(OMEGA * 10, ros::Time(1.25));
+	with_gyro.addGyro(OMEGA * 10, ros::Time(1.3));
+
+	EXPECT_EQ(with_gyro.getStamp(), ros::Time(1.3));
+
+	ros::Time from;
+	tf::Transform at_frame = with_gyro.predict(ros::Time(1.2), from);
+
+	EXPECT_EQ(from, ros::Time(1.2));
+	expectNear(at_frame, without_gyro.getPose(), 1e-9);
+
+	// between the two gyro measurements it extrapolates from the first
+	with_gyro.predict(ros::Time(1.27), from);
+	EXPECT_EQ(from, ros::Time(1.25));
+}
+
+int main(int argc, char **argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
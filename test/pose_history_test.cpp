@@ -0,0 +1,143 @@
+/*
+ * pose_history_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <dipa/PoseHistory.h>
+
+namespace {
+
+double rotationError(const tf::Transform& a, const tf::Transform& b)
+{
+	double angle = (a.inverse() * b).getRotation().getAngle();
+	return std::min(angle, 2 * M_PI - angle);
+}
+
+void expectNear(const tf::Transform& a, const tf::Transform& b, double tolerance)
+{
+	EXPECT_NEAR((a.getOrigin() - b.getOrigin()).length(), 0, tolerance);
+	EXPECT_NEAR(rotationError(a, b), 0, tolerance);
+}
+
+tf::Transform power(const tf::Transform& step, int n)
+{
+	tf::Transform result = tf::Transform::getIdentity();
+	for(int i = 0; i < n; i++)
+	{
+		result = result * step;
+	}
+	return result;
+}
+
+ros::Time stampOf(int frame)
+{
+	return ros::Time(1.0 + 0.1 * frame);
+}
+
+/*
+ * frames at 10 hz which each move by step from the last
+ */
+void fill(PoseHistory& history, const tf::Transform& start, const tf::Transform& step, int frames)
+{
+	tf::Transform pose = start;
+	for(int i = 0; i < frames; i++)
+	{
+		history.record(stampOf(i), pose);
+		pose = pose * step;
+	}
+}
+
+const tf::Transform START(tf::createQuaternionFromYaw(0.3), tf::Vector3(1, 2, 1.5));
+const tf::Transform STEP(tf::createQuaternionFromYaw(0.01), tf::Vector3(0.02, 0.01, 0));
+const tf::Transform CORRECTION(tf::createQuaternionFromYaw(0.05), tf::Vector3(0.1, -0.1, 0));
+
+}
+
+TEST(PoseHistory, PropagatesAFramePoseToTheNewestFrame)
+{
+	PoseHistory history;
+	fill(history, START, STEP, 10);
+
+	// the realigned pose of frame 4 is carried along the increments of frames 5 to 9
+	tf::Transform realigned = CORRECTION * START * power(STEP, 4);
+
+	tf::Transform newest;
+	ros::Time newest_stamp;
+	ASSERT_TRUE(history.propagate(stampOf(4), realigned, newest, newest_stamp));
+
+	EXPECT_EQ(newest_stamp, stampOf(9));
+	expectNear(newest, realigned * power(STEP, 5), 1e-9);
+}
+
+TEST(PoseHistory, InterpolatesAPoseBetweenFrames)
+{
+	PoseHistory history;
+
+	// a pure translation so the rest of the interrupted increment is exactly half of it
+	tf::Transform step(tf::Quaternion::getIdentity(), tf::Vector3(0.02, 0.01, 0));
+	fill(history, START, step, 10);
+
+	tf::Transform realigned = CORRECTION * START * power(step, 4) * tf::Transform(tf::Quaternion::getIdentity(), step.getOrigin() * 0.5);
+
+	tf::Transform newest;
+	ros::Time newest_stamp;
+	ASSERT_TRUE(history.propagate(ros::Time(1.45), realigned, newest, newest_stamp));
+
+	EXPECT_EQ(newest_stamp, stampOf(9));
+	expectNear(newest, CORRECTION * START * power(step, 9), 1e-9);
+}
+
+TEST(PoseHistory, KeepsAPoseNewerThanTheNewestFrame)
+{
+	PoseHistory history;
+	fill(history, START, STEP, 10);
+
+	tf::Transform newest;
+	ros::Time newest_stamp;
+	ASSERT_TRUE(history.propagate(ros::Time(5.0), CORRECTION, newest, newest_stamp));
+
+	EXPECT_EQ(newest_stamp, ros::Time(5.0));
+	expectNear(newest, CORRECTION, 1e-12);
+}
+
+TEST(PoseHistory, RejectsAPoseOlderThanTheHistory)
+{
+	PoseHistory history;
+
+	tf::Transform newest;
+	ros::Time newest_stamp;
+	EXPECT_FALSE(history.propagate(stampOf(0), CORRECTION, newest, newest_stamp));
+
+	fill(history, START, STEP, POSE_HISTORY_SIZE + 10);
+
+	EXPECT_FALSE(history.propagate(ros::Time(0.5), CORRECTION, newest, newest_stamp));
+	EXPECT_FALSE(history.propagate(stampOf(5), CORRECTION, newest, newest_stamp)); // overwritten
+	EXPECT_TRUE(history.propagate(stampOf(20), CORRECTION, newest, newest_stamp));
+}
+
+TEST(PoseHistory, RejectsAPoseALaterAlignmentMadeStale)
+{
+	PoseHistory history;
+	fill(history, START, STEP, 10);
+
+	history.amendNewest(START * power(STEP, 9), true);
+
+	tf::Transform newest;
+	ros::Time newest_stamp;
+	EXPECT_FALSE(history.propagate(stampOf(4), CORRECTION, newest, newest_stamp));
+
+	// the aligned frame itself is still a valid place for a pose
+	EXPECT_TRUE(history.propagate(stampOf(9), CORRECTION, newest, newest_stamp));
+}
+
+int main(int argc, char **argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,191 @@
+/*
+ * sliding_window_optimizer_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: kevin
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <dipa/Sequence.h>
+#include <dipa/SlidingWindowOptimizer.h>
+
+namespace {
+
+cv::Mat_<float> intrinsic()
+{
+	return (cv::Mat_<float>(3, 3) << 250, 0, 320, 0, 250, 240, 0, 0, 1);
+}
+
+ros::Time stampOf(int frame)
+{
+	return ros::Time(1.0 + frame / 30.0);
+}
+
+cv::Point2f project(const tf::Transform& w2c, const cv::Mat_<float>& K, cv::Point2f object)
+{
+	tf::Vector3 pc = w2c.inverse() * tf::Vector3(object.x, object.y, 0);
+	return cv::Point2f(K(0) * pc.x() / pc.z() + K(2), K(4) * pc.y() / pc.z() + K(5));
+}
+
+/*
+ * waits for the correction of the frame at stamp
+ */
+std::unique_ptr<SlidingWindowOptimizer::Correction> waitFor(SlidingWindowOptimizer& swo, ros::Time stamp)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		std::unique_ptr<SlidingWindowOptimizer::Correction> c = swo.takeCorrection();
+		if(c && c->stamp == stamp)
+		{
+			return c;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return std::unique_ptr<SlidingWindowOptimizer::Correction>();
+}
+
+/*
+ * a frame at syntheticPose which observes every object at its true pixel
+ */
+std::unique_ptr<SlidingWindowOptimizer::Frame> makeFrame(int f, const tf::Transform& w2c, const std::vector<cv::Point2f>& truth_objects, const std::vector<cv::Point2f>& objects)
+{
+	cv::Mat_<float> K = intrinsic();
+	tf::Transform truth = syntheticPose(f / 30.0);
+
+	std::unique_ptr<SlidingWindowOptimizer::Frame> frame(new SlidingWindowOptimizer::Frame);
+	frame->stamp = stampOf(f);
+	frame->K = K;
+	frame->pixel_scale = 1;
+	frame->w2c = w2c;
+	frame->grid_aligned = false;
+
+	for(int i = 0; i < truth_objects.size(); i++)
+	{
+		frame->ids.push_back(i);
+		frame->pixels.push_back(project(truth, K, truth_objects[i]));
+		frame->objects.push_back(objects[i]);
+	}
+
+	return frame;
+}
+
+}
+
+/*
+ * the first frame is exact and every later frame is off by the same drift. the exact pixels
+ * of the features pull the poses and the noisy landmarks back onto the truth
+ */
+TEST(SlidingWindowOptimizer, RefinesDriftedPosesAndLandmarks)
+{
+	// a lattice of features under the first pose
+	std::vector<cv::Point2f> truth_objects, noisy_objects;
+	cv::RNG rng(1);
+	for(int i = 0; i < 7; i++)
+	{
+		for(int j = 0; j < 7; j++)
+		{
+			cv::Point2f obj(-0.75 + 0.25 * i, -0.75 + 0.25 * j);
+			truth_objects.push_back(obj);
+			noisy_objects.push_back(obj + cv::Point2f(rng.gaussian(0.02), rng.gaussian(0.02)));
+		}
+	}
+
+	tf::Matrix3x3 drift_rot;
+	drift_rot.setRPY(0.005, -0.005, 0.01);
+	tf::Transform drift(drift_rot, tf::Vector3(0.01, -0.01, 0.005));
+
+	SlidingWindowOptimizer swo;
+	swo.start();
+
+	std::unique_ptr<SlidingWindowOptimizer::Correction> c;
+	tf::Transform truth;
+
+	for(int f = 0; f < SWO_WINDOW_SIZE; f++)
+	{
+		truth = syntheticPose(f / 30.0);
+
+		swo.post(makeFrame(f, (f == 0) ? truth : truth * drift, truth_objects, noisy_objects));
+
+		// the first frame alone has nothing to refine
+		if(f > 0)
+		{
+			c = waitFor(swo, stampOf(f));
+			ASSERT_TRUE(!!c) << "no correction for frame " << f;
+		}
+	}
+
+	swo.stop();
+
+	double estimate_error = (c->estimate_w2c.getOrigin() - truth.getOrigin()).length();
+	double refined_error = (c->refined_w2c.getOrigin() - truth.getOrigin()).length();
+
+	EXPECT_LT(refined_error, estimate_error);
+	EXPECT_LT(refined_error, 0.003);
+
+	ASSERT_EQ(c->objects.size(), truth_objects.size());
+
+	double noisy_sum = 0, refined_sum = 0;
+	for(int i = 0; i < c->ids.size(); i++)
+	{
+		noisy_sum += cv::norm(noisy_objects[c->ids[i]] - truth_objects[c->ids[i]]);
+		refined_sum += cv::norm(c->objects[i] - truth_objects[c->ids[i]]);
+	}
+
+	EXPECT_LT(refined_sum, 0.5 * noisy_sum);
+}
+
+/*
+ * a reset drops the frames before it so the next correction comes from a window of the frames
+ * after it
+ */
+TEST(SlidingWindowOptimizer, StartsAFreshWindowAfterAReset)
+{
+	std::vector<cv::Point2f> objects;
+	for(int i = 0; i < 16; i++)
+	{
+		objects.push_back(cv::Point2f(-0.6 + 0.4 * (i % 4), -0.6 + 0.4 * (i / 4)));
+	}
+
+	SlidingWindowOptimizer swo;
+	swo.start();
+
+	for(int f = 0; f < 3; f++)
+	{
+		swo.post(makeFrame(f, syntheticPose(f / 30.0), objects, objects));
+		if(f > 0)
+		{
+			ASSERT_TRUE(!!waitFor(swo, stampOf(f)));
+		}
+	}
+
+	swo.reset();
+
+	swo.post(makeFrame(3, syntheticPose(3 / 30.0), objects, objects));
+	swo.post(makeFrame(4, syntheticPose(4 / 30.0), objects, objects));
+
+	std::unique_ptr<SlidingWindowOptimizer::Correction> c = waitFor(swo, stampOf(4));
+
+	swo.stop();
+
+	ASSERT_TRUE(!!c);
+	EXPECT_EQ(c->window_start, stampOf(3));
+	EXPECT_EQ(c->generation, 1u);
+}
+
+int main(int argc, char **argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	// the optimizer's worker runs while ros is ok
+	ros::init(argc, argv, "sliding_window_optimizer_test");
+	ros::NodeHandle nh;
+
+	return RUN_ALL_TESTS();
+}